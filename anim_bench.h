@@ -0,0 +1,270 @@
+#ifndef ANIM_BENCH_H
+#define ANIM_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "animation_clip.h"
+#include "clip_animator.h"
+#include "job_system.h"
+#include "pose_blend.h"
+
+// Command-line micro-benchmarks for the animation hot paths (skeletal_animation --bench-*).
+// They only need cooked clips: no window, no GL context.
+
+struct NamedClip {
+    std::string name;
+    AnimationClip clip;
+};
+
+// ns per bone sample, playing `clip` at 60 Hz for `seconds` (looping)
+inline double TimeKeyframeSampling(const AnimationClip& clip, float seconds, bool useCursors, float& sink) {
+    const int frames = (int)(seconds * 60.0f);
+    const int trackCount = (int)clip.GetTracks().size();
+    if (frames <= 0 || trackCount == 0 || clip.GetDuration() <= 0.0f) return 0.0;
+
+    std::vector<TrackCursor> cursors(trackCount);
+    const float step = clip.GetTicksPerSecond() / 60.0f;
+    float time = 0.0f;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        time = std::fmod(time + step, clip.GetDuration());
+        for (int i = 0; i < trackCount; i++) {
+            glm::mat4 local = clip.SampleTrack(i, time, useCursors ? &cursors[i] : nullptr);
+            sink += local[3][0];
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    return ns / ((double)frames * trackCount);
+}
+
+// Key lookup strategies side by side:
+//   search  - no cursor, binary search every sample (what a seek costs)
+//   cursor  - per-track cursors, normal playback
+//   uniform - cursors on a copy resampled to uniformKeysPerSecond (index = time * rate)
+inline void BenchKeyframeSampling(const std::vector<NamedClip>& clips, float seconds = 10.0f,
+                                  float uniformKeysPerSecond = 30.0f, std::ostream& os = std::cout) {
+    float sink = 0.0f;
+    os << "---- keyframe sampling, ns per bone sample (" << seconds << " s at 60 Hz per clip) ----\n";
+    os << std::left << std::setw(16) << "clip" << std::right << std::setw(8) << "tracks" << std::setw(10) << "keys"
+       << std::setw(10) << "search" << std::setw(10) << "cursor" << std::setw(10) << "uniform" << "\n";
+
+    for (const NamedClip& named : clips) {
+        const AnimationClip& clip = named.clip;
+        AnimationClip uniform = clip;
+        if (clip.GetTicksPerSecond() > 0.0f)
+            uniform.ResampleUniform(uniformKeysPerSecond / clip.GetTicksPerSecond());
+
+        double search = TimeKeyframeSampling(clip, seconds, false, sink);
+        double cursor = TimeKeyframeSampling(clip, seconds, true, sink);
+        double uniformNs = TimeKeyframeSampling(uniform, seconds, true, sink);
+
+        os << std::left << std::setw(16) << named.name << std::right << std::setw(8) << clip.GetTracks().size()
+           << std::setw(10) << clip.GetKeyCount() << std::fixed << std::setprecision(1)
+           << std::setw(10) << search << std::setw(10) << cursor << std::setw(10) << uniformNs << "\n";
+    }
+    os << "(checksum " << sink << ")\n";
+}
+
+// Compression report: key memory and count before/after, worst model-space joint position
+// error over the clip sampled at 60 Hz (compressed vs original pose), and sampling cost.
+inline void ReportClipCompression(const std::vector<NamedClip>& clips, const ClipCompression& settings,
+                                  std::ostream& os = std::cout) {
+    float sink = 0.0f;
+    size_t rawTotal = 0, packedTotal = 0;
+    os << "---- clip compression (position " << settings.positionError << ", rotation "
+       << glm::degrees(settings.rotationError) << " deg, scale " << settings.scaleError << ") ----\n";
+    os << std::left << std::setw(16) << "clip" << std::right << std::setw(10) << "keys" << std::setw(10) << "kept"
+       << std::setw(10) << "raw KB" << std::setw(10) << "comp KB" << std::setw(8) << "ratio"
+       << std::setw(12) << "max err" << std::setw(10) << "ns raw" << std::setw(10) << "ns comp" << "\n";
+
+    for (const NamedClip& named : clips) {
+        const AnimationClip& clip = named.clip;
+        AnimationClip packed = clip;
+        packed.Compress(settings);
+
+        // same hierarchy, so node i matches node i
+        ClipAnimator original(&clip), compressed(&packed);
+        float maxError = 0.0f;
+        float step = clip.GetTicksPerSecond() / 60.0f;
+        for (float t = 0.0f; step > 0.0f && t <= clip.GetDuration(); t += step) {
+            original.SetClipTime(t);
+            compressed.SetClipTime(t);
+            original.EvaluatePose();
+            compressed.EvaluatePose();
+            const std::vector<glm::mat4>& a = original.GetGlobalTransforms();
+            const std::vector<glm::mat4>& b = compressed.GetGlobalTransforms();
+            for (int i = 0; i < clip.GetNodeCount(); i++)
+                maxError = std::max(maxError, glm::length(glm::vec3(a[i][3]) - glm::vec3(b[i][3])));
+        }
+
+        size_t raw = clip.GetKeyMemoryBytes(), comp = packed.GetKeyMemoryBytes();
+        rawTotal += raw;
+        packedTotal += comp;
+        double rawNs = TimeKeyframeSampling(clip, 2.0f, true, sink);
+        double compNs = TimeKeyframeSampling(packed, 2.0f, true, sink);
+
+        os << std::left << std::setw(16) << named.name << std::right << std::setw(10) << clip.GetKeyCount()
+           << std::setw(10) << packed.GetKeyCount() << std::fixed << std::setprecision(1)
+           << std::setw(10) << raw / 1024.0 << std::setw(10) << comp / 1024.0
+           << std::setw(8) << (comp ? (double)raw / comp : 0.0) << std::setprecision(5) << std::setw(12) << maxError
+           << std::setprecision(1) << std::setw(10) << rawNs << std::setw(10) << compNs << "\n";
+    }
+    os << "total " << rawTotal / 1024 << " KB -> " << packedTotal / 1024 << " KB (max err in model units)"
+       << " (checksum " << sink << ")\n";
+}
+
+// Pose blending cost per bone (node): the raw two-pose blend (scalar vs SSE), and a full
+// BlendAnimator update — sampling included — against ClipAnimator playing a single clip.
+inline void BenchPoseBlending(const std::vector<NamedClip>& clips, float seconds = 5.0f, std::ostream& os = std::cout) {
+    auto find = [&](const char* name) -> const AnimationClip* {
+        for (const NamedClip& named : clips)
+            if (named.name == name) return &named.clip;
+        return nullptr;
+    };
+    const AnimationClip* idle = find("idle");
+    if (!idle || idle->GetNodeCount() == 0) { os << "bench-blend: idle clip missing\n"; return; }
+    const int nodes = idle->GetNodeCount();
+    const int frames = std::max(1, (int)(seconds * 60.0f));
+    const float dt = 1.0f / 60.0f;
+    float sink = 0.0f;
+    auto perBone = [&](std::chrono::steady_clock::time_point begin, int iterations) {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / ((double)iterations * nodes);
+    };
+
+    LocalPose a, b, out;
+    for (LocalPose* pose : { &a, &b, &out }) pose->Resize(nodes);
+    const int blends = frames * 100;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < blends; i++) BlendPosesScalar(a, b, (float)(i & 63) / 63.0f, out);
+    double scalarNs = perBone(begin, blends);
+    sink += out[LocalPose::RW][0];
+    begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < blends; i++) BlendPoses(a, b, (float)(i & 63) / 63.0f, out);
+    double simdNs = perBone(begin, blends);
+    sink += out[LocalPose::RW][0];
+
+    ClipAnimator single(find("walk") ? find("walk") : idle);
+    begin = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) single.UpdateAnimation(dt);
+    double singleNs = perBone(begin, frames);
+
+    BlendAnimator blend(idle);
+    blend.SetLocomotionClips(idle, find("walk"), find("run"), find("walk_backward"), find("strafe_left"), find("strafe_right"));
+    blend.PlayLocomotion(0.0f);
+    blend.SetLocomotionInput(glm::vec2(0.6f, 1.4f)); // walk + run + strafe_right carry weight
+    for (int f = 0; f < 120; f++) blend.UpdateAnimation(dt); // settle the gait smoothing
+    begin = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) blend.UpdateAnimation(dt);
+    double locomotionNs = perBone(begin, frames);
+
+    const AnimationClip* roll = find("roll") ? find("roll") : idle;
+    blend.AddClip(roll);
+    begin = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        if (f % 12 == 0) blend.Play(roll, 0.15f, false); // always mid-crossfade
+        blend.UpdateAnimation(dt);
+    }
+    double fadeNs = perBone(begin, frames);
+    sink += blend.GetFinalBoneMatrices()[0][3][0] + single.GetFinalBoneMatrices()[0][3][0];
+
+    os << "---- pose blending, ns per bone (" << nodes << " nodes) ----\n" << std::fixed << std::setprecision(2);
+    os << std::left << std::setw(40) << "blend two poses, scalar" << std::right << std::setw(10) << scalarNs << "\n";
+#ifdef POSE_BLEND_SSE
+    os << std::left << std::setw(40) << "blend two poses, SSE" << std::right << std::setw(10) << simdNs << "\n";
+#else
+    os << std::left << std::setw(40) << "blend two poses (no SSE in this build)" << std::right << std::setw(10) << simdNs << "\n";
+#endif
+    os << std::left << std::setw(40) << "single clip update (ClipAnimator)" << std::right << std::setw(10) << singleNs << "\n";
+    os << std::left << std::setw(40) << "locomotion blend space, 3 clips" << std::right << std::setw(10) << locomotionNs << "\n";
+    os << std::left << std::setw(40) << "crossfade (clip + frozen pose)" << std::right << std::setw(10) << fadeNs << "\n";
+    os << "(checksum " << sink << ")\n";
+}
+
+// Animation update for `characters` animators (clips round-robin, staggered phases) on
+// 1, 2, 4, ... threads: ms per 60 Hz frame, whole characters per job. Then one character
+// with its pose split into subtree jobs (ClipAnimator::UpdateAnimationAsync), checked
+// against a serial UpdateAnimation of the same clip every frame.
+inline void BenchParallelAnimation(const std::vector<NamedClip>& clips, int characters = 256, float seconds = 5.0f,
+                                   std::ostream& os = std::cout) {
+    if (clips.empty() || characters <= 0) return;
+    std::vector<ClipAnimator> animators;
+    animators.reserve(characters);
+    for (int i = 0; i < characters; i++) {
+        const AnimationClip& clip = clips[i % clips.size()].clip;
+        animators.emplace_back(&clip);
+        animators.back().SetClipTime(clip.GetDuration() * (float)i / (float)characters);
+    }
+
+    const int frames = std::max(1, (int)(seconds * 60.0f));
+    const int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    auto update = [&](int begin, int end) {
+        for (int i = begin; i < end; i++) animators[i].UpdateAnimation(1.0f / 60.0f);
+    };
+
+    os << "---- animation update, " << characters << " characters (" << seconds << " s at 60 Hz) ----\n";
+    os << std::setw(8) << "threads" << std::setw(12) << "ms/frame" << std::setw(10) << "speedup" << "\n";
+    double single = 0.0;
+    for (int threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        JobSystem jobs(threads - 1);
+        const int grain = std::max(1, characters / (threads * 8)); // a few jobs per thread to steal
+        auto begin = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++) {
+            JobCounter done;
+            jobs.ParallelFor(characters, grain, update, done);
+            jobs.Wait(done);
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() / frames;
+        if (threads == 1) single = ms;
+        os << std::setw(8) << threads << std::fixed << std::setprecision(3) << std::setw(12) << ms
+           << std::setprecision(2) << std::setw(10) << (ms > 0.0 ? single / ms : 0.0) << "\n";
+        if (threads == maxThreads) break;
+    }
+
+    const AnimationClip& clip = clips[0].clip;
+    const int grain = 16;
+    os << "---- one character, pose split into subtree jobs (" << clips[0].name << ", "
+       << clip.GetNodeCount() << " nodes, grain " << grain << ") ----\n";
+    os << std::setw(8) << "threads" << std::setw(12) << "us/frame" << std::setw(10) << "speedup"
+       << std::setw(8) << "jobs" << std::setw(14) << "max diff" << "\n";
+    for (int threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        JobSystem jobs(threads - 1);
+        ClipAnimator serial(&clip), split(&clip);
+        float worst = 0.0f;
+        double serialUs = 0.0, splitUs = 0.0;
+        for (int f = 0; f < frames; f++) {
+            auto t0 = std::chrono::steady_clock::now();
+            serial.UpdateAnimation(1.0f / 60.0f);
+            auto t1 = std::chrono::steady_clock::now();
+            JobCounter done;
+            split.UpdateAnimationAsync(1.0f / 60.0f, jobs, done, grain);
+            jobs.Wait(done);
+            auto t2 = std::chrono::steady_clock::now();
+            serialUs += std::chrono::duration<double, std::micro>(t1 - t0).count();
+            splitUs += std::chrono::duration<double, std::micro>(t2 - t1).count();
+
+            const std::vector<glm::mat4>& a = serial.GetFinalBoneMatrices();
+            const std::vector<glm::mat4>& b = split.GetFinalBoneMatrices();
+            for (size_t m = 0; m < a.size(); m++)
+                for (int c = 0; c < 4; c++)
+                    for (int r = 0; r < 4; r++) worst = std::max(worst, std::fabs(a[m][c][r] - b[m][c][r]));
+        }
+        os << std::setw(8) << threads << std::fixed << std::setprecision(2) << std::setw(12) << splitUs / frames
+           << std::setw(10) << (splitUs > 0.0 ? serialUs / splitUs : 0.0) << std::setw(8) << split.GetSplitJobCount()
+           << std::scientific << std::setprecision(1) << std::setw(14) << worst << std::defaultfloat << "\n";
+        if (worst > 1e-5f)
+            os << "ERROR::BENCH_JOBS: split pose differs from serial EvaluatePose by " << worst << "\n";
+        if (threads == maxThreads) break;
+    }
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef ANIM_LOD_H
+#define ANIM_LOD_H
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "frustum.h"
+
+// Animation level of detail for background characters. Each character gets a level from
+// its on-screen height (fraction of the viewport, from a bounding sphere), and the level
+// decides how often its pose is evaluated and how deep into the skeleton:
+//
+//   level  screen height  update    bones sampled
+//   0      >= 30%         per frame all
+//   1      >= 12%         30 Hz     all
+//   2      >= 5%          15 Hz     down to the hands (fingers reuse their last pose)
+//   3      smaller        8 Hz      down to the forearms
+//   culled outside the frustum: clip time advances, nothing is evaluated or drawn
+//
+// Between two updates the palette is blended from the previous pose to the new one, so a
+// reduced rate shows as a slight lag rather than stepping. Depth is counted from the root
+// bone (see AnimationClip::GetNodeDepths); on a Mixamo rig the hands are 7 deep.
+struct AnimLodLevel {
+    float minScreenHeight; // fraction of the viewport height
+    float updateHz;        // 0 = every frame
+    int maxDepth;          // deepest node sampled (INT_MAX = all)
+};
+
+struct AnimLodPolicy {
+    static const int LEVELS = 4;
+    AnimLodLevel levels[LEVELS] = {
+        { 0.30f, 0.0f, INT_MAX },
+        { 0.12f, 30.0f, INT_MAX },
+        { 0.05f, 15.0f, 7 },
+        { 0.0f, 8.0f, 6 },
+    };
+    float boundsRadius = 1.0f;       // sphere around the character, metres
+    float boundsHeight = 0.9f;       // its centre above the character's origin
+    bool enabled = true;             // false: everything at level 0, nothing culled
+};
+
+// what the LOD selection needs from the camera, captured once per frame
+struct AnimLodView {
+    Frustum frustum;
+    glm::vec3 cameraPos{ 0.0f };
+    float projScale = 1.0f; // projection[1][1] = cot(fovY / 2)
+
+    AnimLodView() {}
+    AnimLodView(const glm::mat4& projection, const glm::mat4& view, const glm::vec3& camPos)
+        : frustum(projection * view), cameraPos(camPos), projScale(projection[1][1]) {}
+};
+
+// Level for a character standing at `pos`, or -1 if it's outside the frustum
+inline int SelectAnimLod(const AnimLodPolicy& policy, const AnimLodView& view, const glm::vec3& pos) {
+    if (!policy.enabled) return 0;
+    glm::vec3 center = pos + glm::vec3(0.0f, policy.boundsHeight, 0.0f);
+    if (!view.frustum.IntersectsSphere(center, policy.boundsRadius)) return -1;
+
+    // projected diameter over the NDC height (2): r * cot(fovY / 2) / distance
+    float distance = std::max(glm::length(center - view.cameraPos), 1e-3f);
+    float screenHeight = policy.boundsRadius * view.projScale / distance;
+    for (int level = 0; level < AnimLodPolicy::LEVELS - 1; level++)
+        if (screenHeight >= policy.levels[level].minScreenHeight) return level;
+    return AnimLodPolicy::LEVELS - 1;
+}
+
+// per-frame counters, filled by whoever applies the LOD (Crowd::GatherLodStats)
+struct AnimLodStats {
+    int characters[AnimLodPolicy::LEVELS] = {};
+    int culled = 0;
+    int updated = 0;        // characters whose pose was evaluated this frame
+    int bonesEvaluated = 0; // nodes sampled this frame
+    int bonesFull = 0;      // nodes a full-rate, full-depth update would have sampled
+
+    void Reset() { *this = AnimLodStats(); }
+    void Add(const AnimLodStats& o) {
+        for (int i = 0; i < AnimLodPolicy::LEVELS; i++) characters[i] += o.characters[i];
+        culled += o.culled; updated += o.updated;
+        bonesEvaluated += o.bonesEvaluated; bonesFull += o.bonesFull;
+    }
+};
+
+#endif
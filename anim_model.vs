@@ -5,37 +5,98 @@ layout(location = 1) in vec3 norm;
 layout(location = 2) in vec2 tex;
 layout(location = 3) in vec3 tangent;
 layout(location = 4) in vec3 bitangent;
-layout(location = 5) in ivec4 boneIds; 
+layout(location = 5) in ivec4 boneIds;
 layout(location = 6) in vec4 weights;
 
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
 
-const int MAX_BONES = 100;
 const int MAX_BONE_INFLUENCE = 4;
-uniform mat4 finalBonesMatrices[MAX_BONES];
+
+// bone palette (see bone_palette.h): 4 RGBA32F texels per matrix, one column each
+uniform samplerBuffer bonePalette;
+uniform int bonePaletteBase; // first matrix of this draw's palette
+uniform int boneCount;       // 0 = unskinned geometry (e.g. the ground)
+// instanced crowd draws (see crowd.h): instance i's block starts at
+// bonePaletteBase + i * instanceStride and holds its model matrix, then its palette.
+// 0 = single draw, `model` uniform and the palette at bonePaletteBase.
+uniform int instanceStride;
+// packed meshes (see packed_mesh.h): pos is unorm16 within the model's bind-pose box.
+// 0 = float positions (the ground, unpacked models)
+uniform int packedVertices;
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+// baked crowd playback (see baked_palette.h): the matrix after an instance's model matrix
+// holds (first baked matrix, frame count, frame position, 0) in its first column, and the
+// palette is interpolated from two baked frames of 3-row matrices. 0 = palettes in the block.
+uniform samplerBuffer bakedPalettes;
+uniform int bakedInstances;
+
+mat4 PaletteMatrix(int index)
+{
+    int t = index * 4;
+    return mat4(texelFetch(bonePalette, t),
+                texelFetch(bonePalette, t + 1),
+                texelFetch(bonePalette, t + 2),
+                texelFetch(bonePalette, t + 3));
+}
+
+mat4 BakedMatrix(int index)
+{
+    int t = index * 3;
+    return transpose(mat4(texelFetch(bakedPalettes, t),
+                          texelFetch(bakedPalettes, t + 1),
+                          texelFetch(bakedPalettes, t + 2),
+                          vec4(0.0, 0.0, 0.0, 1.0)));
+}
 
 out vec2 TexCoords;
 
 void main()
 {
+    mat4 modelMatrix = model;
+    int paletteBase = bonePaletteBase;
+    bool baked = false;
+    int frame0 = 0, frame1 = 0;
+    float frameBlend = 0.0;
+    if(instanceStride > 0)
+    {
+        int block = bonePaletteBase + gl_InstanceID * instanceStride;
+        modelMatrix = PaletteMatrix(block);
+        paletteBase = block + 1;
+        if(bakedInstances != 0)
+        {
+            vec4 playback = texelFetch(bonePalette, paletteBase * 4);
+            int frames = int(playback.y);
+            int frame = int(playback.z);
+            baked = true;
+            frame0 = int(playback.x) + frame * boneCount;
+            frame1 = int(playback.x) + ((frame + 1) % frames) * boneCount;
+            frameBlend = fract(playback.z);
+        }
+    }
+
+    vec3 position = packedVertices != 0 ? pos * positionScale + positionOffset : pos;
     vec4 totalPosition = vec4(0.0f);
-    for(int i = 0 ; i < MAX_BONE_INFLUENCE ; i++)
+    if(boneCount == 0)
+        totalPosition = vec4(position,1.0f);
+    for(int i = 0 ; i < MAX_BONE_INFLUENCE && boneCount > 0 ; i++)
     {
-        if(boneIds[i] == -1) 
+        if(boneIds[i] == -1)
             continue;
-        if(boneIds[i] >=MAX_BONES) 
+        if(boneIds[i] >= boneCount)
         {
-            totalPosition = vec4(pos,1.0f);
+            totalPosition = vec4(position,1.0f);
             break;
         }
-        vec4 localPosition = finalBonesMatrices[boneIds[i]] * vec4(pos,1.0f);
+        mat4 bone = baked ? BakedMatrix(frame0 + boneIds[i]) * (1.0 - frameBlend) + BakedMatrix(frame1 + boneIds[i]) * frameBlend
+                          : PaletteMatrix(paletteBase + boneIds[i]);
+        vec4 localPosition = bone * vec4(position,1.0f);
         totalPosition += localPosition * weights[i];
-        vec3 localNormal = mat3(finalBonesMatrices[boneIds[i]]) * norm;
    }
-	
-    mat4 viewModel = view * model;
+
+    mat4 viewModel = view * modelMatrix;
     gl_Position =  projection * viewModel * totalPosition;
 	TexCoords = tex;
 }
@@ -0,0 +1,576 @@
+#ifndef ANIMATION_CLIP_H
+#define ANIMATION_CLIP_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+
+#include <learnopengl/animator.h>
+#include <learnopengl/model_animation.h>
+#include <learnopengl/assimp_glm_helpers.h>
+
+// Range of one channel's keys inside the clip's key arrays.
+struct KeyRange {
+    uint32_t first = 0;
+    uint32_t count = 0;
+};
+
+// One animated node. The keys themselves live in AnimationClip's SoA arrays.
+struct BoneTrack {
+    std::string name;
+    int id = -1; // bone id (palette slot) once bound to a model
+    KeyRange positions, rotations, scales;
+};
+
+// Quantized keys of a compressed clip (AnimationClip::Compress).
+struct PackedVec3 { uint16_t x, y, z; };    // fraction of the channel's QuantRange, 16 bits per axis
+struct PackedQuat { uint16_t bits[3]; };    // smallest-three: 2-bit index of the dropped component, 3 x 15 bits
+struct QuantRange { glm::vec3 min{ 0.0f }, extent{ 0.0f }; }; // per track and channel
+
+// Error bounds for AnimationClip::Compress: a key is dropped when interpolating its
+// neighbours reproduces it this closely. Positions/scales in model units, rotations in radians.
+struct ClipCompression {
+    float positionError = 0.001f;
+    float rotationError = 0.0005f;
+    float scaleError = 0.0001f;
+};
+
+inline PackedVec3 PackVec3(const glm::vec3& v, const QuantRange& range) {
+    auto axis = [](float x, float lo, float extent) {
+        float f = (extent > 0.0f) ? (x - lo) / extent : 0.0f;
+        return (uint16_t)std::lround(glm::clamp(f, 0.0f, 1.0f) * 65535.0f);
+    };
+    return { axis(v.x, range.min.x, range.extent.x), axis(v.y, range.min.y, range.extent.y), axis(v.z, range.min.z, range.extent.z) };
+}
+
+inline glm::vec3 UnpackVec3(const PackedVec3& p, const QuantRange& range) {
+    return range.min + range.extent * (glm::vec3(p.x, p.y, p.z) * (1.0f / 65535.0f));
+}
+
+// the largest component is rebuilt from the unit length, the other three lie in [-1/sqrt2, 1/sqrt2]
+inline PackedQuat PackQuat(const glm::quat& rotation) {
+    glm::quat q = glm::normalize(rotation);
+    float c[4] = { q.x, q.y, q.z, q.w };
+    int largest = 0;
+    for (int i = 1; i < 4; i++)
+        if (std::fabs(c[i]) > std::fabs(c[largest])) largest = i;
+    float sign = (c[largest] < 0.0f) ? -1.0f : 1.0f; // q and -q are the same rotation
+
+    uint64_t bits = (uint64_t)largest << 45;
+    for (int i = 0, slot = 0; i < 4; i++) {
+        if (i == largest) continue;
+        float f = c[i] * sign * 0.70710678f + 0.5f; // [-1/sqrt2, 1/sqrt2] -> [0, 1]
+        bits |= (uint64_t)std::lround(glm::clamp(f, 0.0f, 1.0f) * 32767.0f) << (15 * slot++);
+    }
+    return { { (uint16_t)bits, (uint16_t)(bits >> 16), (uint16_t)(bits >> 32) } };
+}
+
+inline glm::quat UnpackQuat(const PackedQuat& p) {
+    uint64_t bits = (uint64_t)p.bits[0] | ((uint64_t)p.bits[1] << 16) | ((uint64_t)p.bits[2] << 32);
+    int largest = (int)(bits >> 45) & 3;
+    float c[4];
+    float sum = 0.0f;
+    for (int i = 0, slot = 0; i < 4; i++) {
+        if (i == largest) continue;
+        float f = (float)((bits >> (15 * slot++)) & 0x7FFF) * (1.0f / 32767.0f);
+        c[i] = (f - 0.5f) * 1.41421356f;
+        sum += c[i] * c[i];
+    }
+    c[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+    return glm::quat(c[3], c[0], c[1], c[2]);
+}
+
+// Playback position of one track instance: the segment each channel used last time.
+// Owned by whoever plays the clip (ClipAnimator keeps one per track), not by the clip.
+struct TrackCursor {
+    uint32_t position = 0, rotation = 0, scale = 0;
+};
+
+// An animation clip, stored for playback rather than for lookup:
+//  - the node hierarchy is flattened in pre-order, so every parent comes before its children
+//    and a pose is one linear pass over parent indices (no tree walk, no name lookups);
+//  - keys are structure-of-arrays (times apart from values) so the key search only touches
+//    the time stream;
+//  - key lookup is O(1) amortized: a TrackCursor remembers the last segment and playback
+//    just steps forward from it, with a binary search when time jumps (loop, seek). A clip
+//    resampled at cook time (ResampleUniform) skips the search entirely: index = time * rate.
+//  - optionally compressed at cook time (Compress): redundant keys dropped, the rest quantized
+//    and decoded inline while sampling.
+// Built either from a .dae through Assimp (slow, used when cooking) or from a cooked
+// .clip file by ClipCache (no XML parsing).
+class AnimationClip {
+public:
+    AnimationClip() = default;
+
+    // full Assimp import; does not need a Model or a GL context
+    explicit AnimationClip(const std::string& animationPath) {
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(animationPath, aiProcess_Triangulate);
+        if (!scene || !scene->mRootNode || scene->mNumAnimations == 0) {
+            std::cout << "ERROR::CLIP:: failed to import " << animationPath << ": " << importer.GetErrorString() << "\n";
+            return;
+        }
+        const aiAnimation* animation = scene->mAnimations[0];
+        m_Duration = (float)animation->mDuration;
+        m_TicksPerSecond = (float)animation->mTicksPerSecond;
+
+        ReadHierarchyData(scene->mRootNode, -1);
+        ReadBoneInfo(scene, scene->mRootNode);
+        ReadTracks(animation);
+        ResolveNodes();
+    }
+
+    // Resolve bone ids against the skinned model (what learnopengl's Animation::ReadMissingBones does):
+    // bones the model doesn't know about get appended to its map.
+    void BindToModel(Model& model) {
+        BindToSkeleton(model.GetBoneInfoMap(), model.GetBoneCount());
+    }
+
+    // Same against a bare bone map, for when there's no Model (headless runs): bind every
+    // clip to the same map so they agree on bone ids.
+    void BindToSkeleton(std::map<std::string, BoneInfo>& boneInfoMap, int& boneCount) {
+        for (BoneTrack& track : m_Tracks) {
+            auto it = boneInfoMap.find(track.name);
+            if (it == boneInfoMap.end()) {
+                BoneInfo info;
+                info.id = boneCount++;
+                auto cached = m_BoneInfoMap.find(track.name);
+                info.offset = (cached != m_BoneInfoMap.end()) ? cached->second.offset : glm::mat4(1.0f);
+                it = boneInfoMap.emplace(track.name, info).first;
+            }
+            track.id = it->second.id;
+        }
+        m_BoneInfoMap = boneInfoMap;
+        ResolveNodes();
+    }
+
+    // index into GetTracks(), or -1
+    int FindTrack(const std::string& name) const {
+        for (int i = 0; i < (int)m_Tracks.size(); i++) {
+            if (m_Tracks[i].name == name) return i;
+        }
+        return -1;
+    }
+
+    // index into the flattened hierarchy, or -1
+    int FindNode(const std::string& name) const {
+        for (int i = 0; i < (int)m_NodeNames.size(); i++) {
+            if (m_NodeNames[i] == name) return i;
+        }
+        return -1;
+    }
+
+    // local transform (T * R * S) of a track at animationTime (ticks);
+    // pass the track instance's cursor for amortized O(1) lookups during playback
+    glm::mat4 SampleTrack(int trackIndex, float animationTime, TrackCursor* cursor = nullptr) const {
+        glm::vec3 position, scale;
+        glm::quat rotation;
+        SampleTrackTRS(trackIndex, animationTime, cursor, position, rotation, scale);
+
+        glm::mat4 local = glm::mat4_cast(rotation);
+        local[0] *= scale.x;
+        local[1] *= scale.y;
+        local[2] *= scale.z;
+        local[3] = glm::vec4(position, 1.0f);
+        return local;
+    }
+
+    // the same sample as separate translation / rotation / scale (what pose blending works on)
+    void SampleTrackTRS(int trackIndex, float animationTime, TrackCursor* cursor,
+                        glm::vec3& position, glm::quat& rotation, glm::vec3& scale) const {
+        const BoneTrack& track = m_Tracks[trackIndex];
+        position = SampleVec3(m_PositionTimes, m_PositionValues, m_PackedPositions,
+                              m_Compressed ? &m_PositionRanges[trackIndex] : nullptr, track.positions,
+                              animationTime, glm::vec3(0.0f), cursor ? &cursor->position : nullptr);
+        rotation = SampleQuat(track.rotations, animationTime, cursor ? &cursor->rotation : nullptr);
+        scale = SampleVec3(m_ScaleTimes, m_ScaleValues, m_PackedScales,
+                           m_Compressed ? &m_ScaleRanges[trackIndex] : nullptr, track.scales,
+                           animationTime, glm::vec3(1.0f), cursor ? &cursor->scale : nullptr);
+    }
+
+    // Cook-time option: replace every animated channel with keys spaced 1/keysPerTick apart
+    // starting at 0, so lookups become index = time * rate. Sparse channels get denser, so this
+    // trades memory for lookup cost; channels with a single key are left alone.
+    // Not available on compressed clips.
+    void ResampleUniform(float keysPerTick) {
+        if (keysPerTick <= 0.0f || m_Duration <= 0.0f || m_Compressed) return;
+        int keyCount = (int)std::ceil(m_Duration * keysPerTick) + 1;
+
+        std::vector<float> positionTimes, rotationTimes, scaleTimes;
+        std::vector<glm::vec3> positionValues, scaleValues;
+        std::vector<glm::quat> rotationValues;
+
+        for (BoneTrack& track : m_Tracks) {
+            KeyRange positions = { (uint32_t)positionTimes.size(), 0 };
+            KeyRange rotations = { (uint32_t)rotationTimes.size(), 0 };
+            KeyRange scales = { (uint32_t)scaleTimes.size(), 0 };
+            int positionKeys = track.positions.count > 1 ? keyCount : (int)track.positions.count;
+            int rotationKeys = track.rotations.count > 1 ? keyCount : (int)track.rotations.count;
+            int scaleKeys = track.scales.count > 1 ? keyCount : (int)track.scales.count;
+
+            for (int k = 0; k < positionKeys; k++) {
+                float t = (track.positions.count > 1) ? k / keysPerTick : m_PositionTimes[track.positions.first];
+                positionTimes.push_back(t);
+                positionValues.push_back(SampleVec3(m_PositionTimes, m_PositionValues, m_PackedPositions, nullptr, track.positions, t, glm::vec3(0.0f), nullptr));
+            }
+            for (int k = 0; k < rotationKeys; k++) {
+                float t = (track.rotations.count > 1) ? k / keysPerTick : m_RotationTimes[track.rotations.first];
+                rotationTimes.push_back(t);
+                rotationValues.push_back(SampleQuat(track.rotations, t, nullptr));
+            }
+            for (int k = 0; k < scaleKeys; k++) {
+                float t = (track.scales.count > 1) ? k / keysPerTick : m_ScaleTimes[track.scales.first];
+                scaleTimes.push_back(t);
+                scaleValues.push_back(SampleVec3(m_ScaleTimes, m_ScaleValues, m_PackedScales, nullptr, track.scales, t, glm::vec3(1.0f), nullptr));
+            }
+            positions.count = (uint32_t)positionKeys;
+            rotations.count = (uint32_t)rotationKeys;
+            scales.count = (uint32_t)scaleKeys;
+            track.positions = positions;
+            track.rotations = rotations;
+            track.scales = scales;
+        }
+
+        m_PositionTimes.swap(positionTimes);
+        m_PositionValues.swap(positionValues);
+        m_RotationTimes.swap(rotationTimes);
+        m_RotationValues.swap(rotationValues);
+        m_ScaleTimes.swap(scaleTimes);
+        m_ScaleValues.swap(scaleValues);
+        m_KeyRate = keysPerTick;
+    }
+
+    // Cook-time option: drop every key that interpolating its kept neighbours reproduces
+    // within the error bounds (constant channels collapse to one key), then quantize what's
+    // left: rotations smallest-three in 48 bits, positions and scales to 16 bits per axis
+    // inside each track's range. Sampling decodes the two keys it needs inline. One-way;
+    // the float keys are released.
+    void Compress(const ClipCompression& settings) {
+        if (m_Compressed) return;
+
+        std::vector<float> positionTimes, rotationTimes, scaleTimes;
+        std::vector<glm::vec3> positionValues, scaleValues;
+        std::vector<glm::quat> rotationValues;
+        auto lerp = [](const glm::vec3& a, const glm::vec3& b, float f) { return glm::mix(a, b, f); };
+        auto distance = [](const glm::vec3& a, const glm::vec3& b) { return glm::length(a - b); };
+        auto slerp = [](const glm::quat& a, const glm::quat& b, float f) { return glm::normalize(glm::slerp(a, b, f)); };
+        auto angle = [](const glm::quat& a, const glm::quat& b) {
+            float d = std::fabs(glm::dot(glm::normalize(a), glm::normalize(b)));
+            return 2.0f * std::acos(std::min(d, 1.0f));
+        };
+
+        for (BoneTrack& track : m_Tracks) {
+            track.positions = ReduceChannel(m_PositionTimes, m_PositionValues, track.positions, settings.positionError,
+                                            lerp, distance, positionTimes, positionValues);
+            track.rotations = ReduceChannel(m_RotationTimes, m_RotationValues, track.rotations, settings.rotationError,
+                                            slerp, angle, rotationTimes, rotationValues);
+            track.scales = ReduceChannel(m_ScaleTimes, m_ScaleValues, track.scales, settings.scaleError,
+                                         lerp, distance, scaleTimes, scaleValues);
+        }
+        m_PositionTimes.swap(positionTimes);
+        m_RotationTimes.swap(rotationTimes);
+        m_ScaleTimes.swap(scaleTimes);
+        m_KeyRate = 0.0f; // no longer evenly spaced
+
+        m_PositionRanges.resize(m_Tracks.size());
+        m_ScaleRanges.resize(m_Tracks.size());
+        m_PackedPositions.resize(positionValues.size());
+        m_PackedRotations.resize(rotationValues.size());
+        m_PackedScales.resize(scaleValues.size());
+        for (size_t i = 0; i < m_Tracks.size(); i++) {
+            const BoneTrack& track = m_Tracks[i];
+            m_PositionRanges[i] = QuantizeChannel(positionValues, track.positions, m_PackedPositions);
+            m_ScaleRanges[i] = QuantizeChannel(scaleValues, track.scales, m_PackedScales);
+        }
+        for (size_t k = 0; k < rotationValues.size(); k++)
+            m_PackedRotations[k] = PackQuat(rotationValues[k]);
+
+        std::vector<glm::vec3>().swap(m_PositionValues);
+        std::vector<glm::quat>().swap(m_RotationValues);
+        std::vector<glm::vec3>().swap(m_ScaleValues);
+        m_Compressed = true;
+    }
+
+    bool IsValid() const { return m_Duration > 0.0f && !m_Tracks.empty() && !m_NodeParents.empty(); }
+    bool IsUniform() const { return m_KeyRate > 0.0f; }
+    float GetKeyRate() const { return m_KeyRate; } // keys per tick when uniform, else 0
+    size_t GetKeyCount() const { return m_PositionTimes.size() + m_RotationTimes.size() + m_ScaleTimes.size(); }
+    bool IsCompressed() const { return m_Compressed; }
+
+    // bytes held by key data (times, float or packed values, quantization ranges)
+    size_t GetKeyMemoryBytes() const {
+        return (m_PositionTimes.size() + m_RotationTimes.size() + m_ScaleTimes.size()) * sizeof(float)
+             + (m_PositionValues.size() + m_ScaleValues.size()) * sizeof(glm::vec3)
+             + m_RotationValues.size() * sizeof(glm::quat)
+             + (m_PackedPositions.size() + m_PackedScales.size()) * sizeof(PackedVec3)
+             + m_PackedRotations.size() * sizeof(PackedQuat)
+             + (m_PositionRanges.size() + m_ScaleRanges.size()) * sizeof(QuantRange);
+    }
+    float GetTicksPerSecond() const { return m_TicksPerSecond; }
+    float GetDuration() const { return m_Duration; }
+    const std::map<std::string, BoneInfo>& GetBoneIDMap() const { return m_BoneInfoMap; }
+    const std::vector<BoneTrack>& GetTracks() const { return m_Tracks; }
+
+    // flattened hierarchy, all indexed by node (pre-order)
+    int GetNodeCount() const { return (int)m_NodeParents.size(); }
+    const std::vector<std::string>& GetNodeNames() const { return m_NodeNames; }
+    const std::vector<int>& GetNodeParents() const { return m_NodeParents; }          // -1 for the root
+    const std::vector<glm::mat4>& GetNodeBindLocal() const { return m_NodeBindLocal; } // used when the node has no track
+    const std::vector<int>& GetNodeTracks() const { return m_NodeTrack; }              // track index or -1
+    const std::vector<int>& GetNodeBones() const { return m_NodeBone; }                // bone id or -1
+    const std::vector<glm::mat4>& GetNodeOffsets() const { return m_NodeOffset; }      // bone offset (identity if no bone)
+    const std::vector<int>& GetNodeDepths() const { return m_NodeDepth; }              // levels below the root bone (0 at and above it)
+
+    // palette size needed to skin with this clip (highest bone id + 1)
+    int GetBoneCount() const {
+        int count = 0;
+        for (const auto& entry : m_BoneInfoMap) count = std::max(count, entry.second.id + 1);
+        return count;
+    }
+
+private:
+    friend class ClipCache;
+
+    // how far a cursor may walk forward before we give up and binary search
+    static const int MAX_CURSOR_STEPS = 4;
+
+    // index of the key that starts the segment containing animationTime (count >= 2)
+    int KeyIndex(const float* times, int count, float animationTime, uint32_t* cursor) const {
+        int last = count - 2;
+        int index;
+        if (m_KeyRate > 0.0f) {
+            index = glm::clamp((int)((animationTime - times[0]) * m_KeyRate), 0, last);
+        }
+        else if (cursor && (int)*cursor <= last && animationTime >= times[*cursor]) {
+            // normal playback: same segment as last time or a few keys further on
+            index = (int)*cursor;
+            for (int steps = 0; index < last && animationTime >= times[index + 1]; steps++) {
+                if (steps == MAX_CURSOR_STEPS) {
+                    index = FindKey(times, count, animationTime);
+                    break;
+                }
+                index++;
+            }
+        }
+        else {
+            index = FindKey(times, count, animationTime); // first sample, loop or seek
+        }
+        if (cursor) *cursor = (uint32_t)index;
+        return index;
+    }
+
+    // binary search; past the last key holds the last segment
+    static int FindKey(const float* times, int count, float animationTime) {
+        int index = (int)(std::upper_bound(times, times + count, animationTime) - times) - 1;
+        return glm::clamp(index, 0, count - 2);
+    }
+
+    static float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime) {
+        float framesDiff = nextTimeStamp - lastTimeStamp;
+        if (framesDiff <= 0.0f) return 0.0f;
+        return glm::clamp((animationTime - lastTimeStamp) / framesDiff, 0.0f, 1.0f);
+    }
+
+    // quant != nullptr: compressed clip, keys come from `packed`
+    glm::vec3 SampleVec3(const std::vector<float>& times, const std::vector<glm::vec3>& values,
+                         const std::vector<PackedVec3>& packed, const QuantRange* quant, const KeyRange& range,
+                         float animationTime, const glm::vec3& fallback, uint32_t* cursor) const {
+        if (range.count == 0) return fallback;
+        const float* t = times.data() + range.first;
+        auto key = [&](int k) { return quant ? UnpackVec3(packed[range.first + k], *quant) : values[range.first + k]; };
+        if (range.count == 1) return key(0);
+
+        int p0 = KeyIndex(t, (int)range.count, animationTime, cursor);
+        return glm::mix(key(p0), key(p0 + 1), GetScaleFactor(t[p0], t[p0 + 1], animationTime));
+    }
+
+    glm::quat SampleQuat(const KeyRange& range, float animationTime, uint32_t* cursor) const {
+        if (range.count == 0) return glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        const float* t = m_RotationTimes.data() + range.first;
+        auto key = [&](int k) { return m_Compressed ? UnpackQuat(m_PackedRotations[range.first + k]) : m_RotationValues[range.first + k]; };
+        if (range.count == 1) return glm::normalize(key(0));
+
+        int p0 = KeyIndex(t, (int)range.count, animationTime, cursor);
+        return glm::normalize(glm::slerp(key(p0), key(p0 + 1), GetScaleFactor(t[p0], t[p0 + 1], animationTime)));
+    }
+
+    // Greedy key reduction of one channel, appended to outTimes/outValues: from each kept key
+    // reach as far as possible while every skipped key stays within `tolerance` of the
+    // interpolation between the two ends.
+    template <class T, class Interp, class Dist>
+    static KeyRange ReduceChannel(const std::vector<float>& times, const std::vector<T>& values, const KeyRange& range,
+                                  float tolerance, Interp interp, Dist dist,
+                                  std::vector<float>& outTimes, std::vector<T>& outValues) {
+        KeyRange reduced = { (uint32_t)outTimes.size(), 0 };
+        const float* t = times.data() + range.first;
+        const T* v = values.data() + range.first;
+        uint32_t count = range.count;
+        auto keep = [&](uint32_t k) { outTimes.push_back(t[k]); outValues.push_back(v[k]); reduced.count++; };
+        if (count == 0) return reduced;
+
+        bool constant = true;
+        for (uint32_t k = 1; k < count && constant; k++) constant = dist(v[k], v[0]) <= tolerance;
+        keep(0);
+        if (constant) return reduced;
+
+        auto spanOk = [&](uint32_t a, uint32_t c) {
+            for (uint32_t k = a + 1; k < c; k++) {
+                if (dist(interp(v[a], v[c], GetScaleFactor(t[a], t[c], t[k])), v[k]) > tolerance) return false;
+            }
+            return true;
+        };
+        for (uint32_t a = 0; a + 1 < count;) {
+            uint32_t b = a + 1;
+            while (b + 1 < count && spanOk(a, b + 1)) b++;
+            keep(b);
+            a = b;
+        }
+        return reduced;
+    }
+
+    // bounding range of one channel's keys, and the keys packed into it
+    static QuantRange QuantizeChannel(const std::vector<glm::vec3>& values, const KeyRange& range, std::vector<PackedVec3>& packed) {
+        QuantRange quant;
+        if (range.count == 0) return quant;
+        glm::vec3 lo = values[range.first], hi = lo;
+        for (uint32_t k = range.first; k < range.first + range.count; k++) {
+            lo = glm::min(lo, values[k]);
+            hi = glm::max(hi, values[k]);
+        }
+        quant.min = lo;
+        quant.extent = hi - lo;
+        for (uint32_t k = range.first; k < range.first + range.count; k++)
+            packed[k] = PackVec3(values[k], quant);
+        return quant;
+    }
+
+    void ReadHierarchyData(const aiNode* src, int parent) {
+        int self = (int)m_NodeParents.size();
+        m_NodeNames.push_back(src->mName.C_Str());
+        m_NodeParents.push_back(parent);
+        m_NodeBindLocal.push_back(AssimpGLMHelpers::ConvertMatrixToGLMFormat(src->mTransformation));
+
+        for (unsigned int i = 0; i < src->mNumChildren; i++)
+            ReadHierarchyData(src->mChildren[i], self);
+    }
+
+    // bone ids in the same order Model assigns them (node order, then mesh bone order)
+    void ReadBoneInfo(const aiScene* scene, const aiNode* node) {
+        for (unsigned int m = 0; m < node->mNumMeshes; m++) {
+            const aiMesh* mesh = scene->mMeshes[node->mMeshes[m]];
+            for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+                std::string boneName = mesh->mBones[b]->mName.C_Str();
+                if (m_BoneInfoMap.find(boneName) != m_BoneInfoMap.end()) continue;
+                BoneInfo info;
+                info.id = (int)m_BoneInfoMap.size();
+                info.offset = AssimpGLMHelpers::ConvertMatrixToGLMFormat(mesh->mBones[b]->mOffsetMatrix);
+                m_BoneInfoMap[boneName] = info;
+            }
+        }
+        for (unsigned int i = 0; i < node->mNumChildren; i++)
+            ReadBoneInfo(scene, node->mChildren[i]);
+    }
+
+    void ReadTracks(const aiAnimation* animation) {
+        m_Tracks.reserve(animation->mNumChannels);
+        for (unsigned int c = 0; c < animation->mNumChannels; c++) {
+            const aiNodeAnim* channel = animation->mChannels[c];
+            BoneTrack track;
+            track.name = channel->mNodeName.C_Str();
+
+            auto it = m_BoneInfoMap.find(track.name);
+            if (it == m_BoneInfoMap.end()) {
+                BoneInfo info;
+                info.id = (int)m_BoneInfoMap.size();
+                info.offset = glm::mat4(1.0f);
+                it = m_BoneInfoMap.emplace(track.name, info).first;
+            }
+            track.id = it->second.id;
+
+            track.positions = { (uint32_t)m_PositionTimes.size(), channel->mNumPositionKeys };
+            for (unsigned int i = 0; i < channel->mNumPositionKeys; ++i) {
+                m_PositionTimes.push_back((float)channel->mPositionKeys[i].mTime);
+                m_PositionValues.push_back(AssimpGLMHelpers::GetGLMVec(channel->mPositionKeys[i].mValue));
+            }
+            track.rotations = { (uint32_t)m_RotationTimes.size(), channel->mNumRotationKeys };
+            for (unsigned int i = 0; i < channel->mNumRotationKeys; ++i) {
+                m_RotationTimes.push_back((float)channel->mRotationKeys[i].mTime);
+                m_RotationValues.push_back(AssimpGLMHelpers::GetGLMQuat(channel->mRotationKeys[i].mValue));
+            }
+            track.scales = { (uint32_t)m_ScaleTimes.size(), channel->mNumScalingKeys };
+            for (unsigned int i = 0; i < channel->mNumScalingKeys; ++i) {
+                m_ScaleTimes.push_back((float)channel->mScalingKeys[i].mTime);
+                m_ScaleValues.push_back(AssimpGLMHelpers::GetGLMVec(channel->mScalingKeys[i].mValue));
+            }
+            m_Tracks.push_back(std::move(track));
+        }
+    }
+
+    // per-node track / bone / offset; the only place names are matched
+    void ResolveNodes() {
+        int count = GetNodeCount();
+        m_NodeTrack.assign(count, -1);
+        m_NodeBone.assign(count, -1);
+        m_NodeOffset.assign(count, glm::mat4(1.0f));
+        for (int i = 0; i < count; i++) {
+            m_NodeTrack[i] = FindTrack(m_NodeNames[i]);
+            auto it = m_BoneInfoMap.find(m_NodeNames[i]);
+            if (it != m_BoneInfoMap.end()) {
+                m_NodeBone[i] = it->second.id;
+                m_NodeOffset[i] = it->second.offset;
+            }
+        }
+
+        // depth counted from the first bone in pre-order (the hips on a Mixamo rig), so it
+        // doesn't depend on how many scene / armature nodes sit above the skeleton
+        m_NodeDepth.assign(count, 0);
+        int rootBone = -1;
+        for (int i = 0; i < count; i++) {
+            m_NodeDepth[i] = (m_NodeParents[i] >= 0) ? m_NodeDepth[m_NodeParents[i]] + 1 : 0;
+            if (rootBone < 0 && m_NodeBone[i] >= 0) rootBone = i;
+        }
+        int rootDepth = (rootBone >= 0) ? m_NodeDepth[rootBone] : 0;
+        for (int& depth : m_NodeDepth) depth = std::max(0, depth - rootDepth);
+    }
+
+    float m_Duration = 0.0f;
+    float m_TicksPerSecond = 0.0f;
+    float m_KeyRate = 0.0f; // keys per tick if every animated channel is uniformly sampled from t=0
+    std::map<std::string, BoneInfo> m_BoneInfoMap;
+
+    std::vector<BoneTrack> m_Tracks;
+    std::vector<float> m_PositionTimes;
+    std::vector<glm::vec3> m_PositionValues;
+    std::vector<float> m_RotationTimes;
+    std::vector<glm::quat> m_RotationValues;
+    std::vector<float> m_ScaleTimes;
+    std::vector<glm::vec3> m_ScaleValues;
+
+    // compressed clips: packed keys (parallel to the time arrays) replace the float values
+    bool m_Compressed = false;
+    std::vector<PackedVec3> m_PackedPositions;
+    std::vector<PackedQuat> m_PackedRotations;
+    std::vector<PackedVec3> m_PackedScales;
+    std::vector<QuantRange> m_PositionRanges; // per track
+    std::vector<QuantRange> m_ScaleRanges;
+
+    std::vector<std::string> m_NodeNames;
+    std::vector<int> m_NodeParents;
+    std::vector<glm::mat4> m_NodeBindLocal;
+    std::vector<int> m_NodeTrack;
+    std::vector<int> m_NodeBone;
+    std::vector<glm::mat4> m_NodeOffset;
+    std::vector<int> m_NodeDepth;
+};
+
+#endif
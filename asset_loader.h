@@ -0,0 +1,260 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+// Fixed-size pool of worker threads fed from one FIFO.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int threadCount = 0) {
+        if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int i = 0; i < threadCount; i++)
+            m_Workers.emplace_back([this] { WorkerLoop(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stopping = true;
+        }
+        m_Wake.notify_all();
+        for (std::thread& t : m_Workers) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <typename F>
+    auto Submit(F&& fn) -> std::future<typename std::invoke_result<F>::type> {
+        using R = typename std::invoke_result<F>::type;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn));
+        std::future<R> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Tasks.emplace_back([task] { (*task)(); });
+        }
+        m_Wake.notify_one();
+        return result;
+    }
+
+    unsigned int GetThreadCount() const { return (unsigned int)m_Workers.size(); }
+
+private:
+    void WorkerLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Wake.wait(lock, [this] { return m_Stopping || !m_Tasks.empty(); });
+                if (m_Tasks.empty()) return; // stopping and drained
+                task = std::move(m_Tasks.front());
+                m_Tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> m_Workers;
+    std::deque<std::function<void()>> m_Tasks;
+    std::mutex m_Mutex;
+    std::condition_variable m_Wake;
+    bool m_Stopping = false;
+};
+
+// Startup asset loading. CPU work (clip parsing, image decoding) runs on the pool;
+// anything that touches GL is posted back and executed by the main thread in PumpMain().
+// Every step is timed so the startup report shows where the time went.
+class AssetLoader {
+public:
+    explicit AssetLoader(unsigned int threadCount = 0)
+        : m_Start(Clock::now()), m_Pool(threadCount) {}
+
+    // run fn on a worker thread
+    template <typename F>
+    auto Async(const std::string& name, F&& fn) -> std::future<typename std::invoke_result<F>::type> {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Pending++;
+        }
+        return m_Pool.Submit([this, name, fn = std::forward<F>(fn)]() mutable {
+            struct Done { // runs even if fn throws
+                AssetLoader* loader;
+                ~Done() { loader->FinishOne(); }
+            } done{ this };
+            return Time(name, "worker", fn);
+        });
+    }
+
+    // run fn on the main (GL) thread during the next PumpMain()
+    void PostToMain(const std::string& name, std::function<void()> fn) {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_MainQueue.push_back({ name, std::move(fn) });
+        }
+        m_Changed.notify_all();
+    }
+
+    // time a step that has to stay on the main thread (e.g. Model, which uploads while it parses)
+    template <typename F>
+    auto Main(const std::string& name, F&& fn) -> typename std::invoke_result<F>::type {
+        return Time(name, "main", fn);
+    }
+
+    // execute whatever GL work is queued; returns how many items ran
+    int PumpMain() {
+        std::deque<MainItem> items;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            items.swap(m_MainQueue);
+        }
+        for (MainItem& item : items)
+            Time(item.name, "main", item.fn);
+        return (int)items.size();
+    }
+
+    // pump main-thread work until every async job (and what it posted) is done
+    void Finish() {
+        for (;;) {
+            PumpMain();
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            if (m_Pending == 0 && m_MainQueue.empty()) break;
+            m_Changed.wait(lock, [this] { return m_Pending == 0 || !m_MainQueue.empty(); });
+        }
+    }
+
+    void PrintReport(std::ostream& os = std::cout) const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        double sum = 0.0, longest = 0.0;
+        os << "---- asset load (" << m_Pool.GetThreadCount() << " workers) ----\n";
+        for (const Timing& t : m_Timings) {
+            os << "  " << std::left << std::setw(28) << t.name << std::setw(8) << t.thread
+               << std::right << std::fixed << std::setprecision(1) << std::setw(8) << t.ms << " ms\n";
+            sum += t.ms;
+            longest = std::max(longest, t.ms);
+        }
+        double wall = std::chrono::duration<double, std::milli>(Clock::now() - m_Start).count();
+        os << "  sum " << sum << " ms, longest " << longest << " ms, wall " << wall << " ms\n";
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct MainItem {
+        std::string name;
+        std::function<void()> fn;
+    };
+
+    struct Timing {
+        std::string name;
+        const char* thread;
+        double ms;
+    };
+
+    template <typename F>
+    auto Time(const std::string& name, const char* thread, F& fn) -> typename std::invoke_result<F&>::type {
+        struct Record { // records on scope exit so void and non-void results share one path
+            AssetLoader* loader;
+            const std::string& name;
+            const char* thread;
+            Clock::time_point begin;
+            ~Record() {
+                double ms = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+                std::lock_guard<std::mutex> lock(loader->m_Mutex);
+                loader->m_Timings.push_back({ name, thread, ms });
+            }
+        } record{ this, name, thread, Clock::now() };
+        return fn();
+    }
+
+    void FinishOne() {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Pending--;
+        }
+        m_Changed.notify_all();
+    }
+
+    Clock::time_point m_Start;
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Changed;
+    std::deque<MainItem> m_MainQueue;
+    std::vector<Timing> m_Timings;
+    int m_Pending = 0;
+    ThreadPool m_Pool; // last: workers must stop before the members they use go away
+};
+
+// Pixels decoded by stb_image, ready for upload.
+struct DecodedImage {
+    std::string path;
+    int width = 0, height = 0, channels = 0;
+    std::unique_ptr<unsigned char, void (*)(void*)> data{ nullptr, stbi_image_free };
+};
+
+// CPU half of a texture load; safe to call from a worker
+// (stbi_set_flip_vertically_on_load must already be set).
+inline DecodedImage DecodeImage(const std::string& path) {
+    DecodedImage img;
+    img.path = path;
+    img.data.reset(stbi_load(path.c_str(), &img.width, &img.height, &img.channels, 0));
+    return img;
+}
+
+// GL half of a texture load: upload straight from the decoded pixels, then build mips (which
+// needs the level-0 data right away, so staging it through a buffer would only add a copy).
+// Returns 0 if the image didn't decode.
+inline unsigned int UploadTexture(const DecodedImage& img) {
+    if (!img.data) {
+        std::cout << "Failed to load texture: " << img.path << "\n";
+        return 0;
+    }
+
+    GLenum format = GL_RGB;
+    if (img.channels == 1) format = GL_RED;
+    else if (img.channels == 3) format = GL_RGB;
+    else if (img.channels == 4) format = GL_RGBA;
+
+    unsigned int tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // RGB rows are not 4-byte aligned in general
+    glTexImage2D(GL_TEXTURE_2D, 0, format, img.width, img.height, 0, format, GL_UNSIGNED_BYTE, img.data.get());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return tex;
+}
+
+// decode on a worker, upload on the main thread; *outTex is written during PumpMain()
+inline void LoadTextureAsync(AssetLoader& loader, const std::string& path, unsigned int* outTex) {
+    std::string file = path.substr(path.find_last_of("/\\") + 1);
+    loader.Async("decode " + file, [&loader, path, file, outTex] {
+        auto img = std::make_shared<DecodedImage>(DecodeImage(path));
+        loader.PostToMain("upload " + file, [img, outTex] { *outTex = UploadTexture(*img); });
+    });
+}
+
+#endif
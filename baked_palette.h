@@ -0,0 +1,155 @@
+#ifndef BAKED_PALETTE_H
+#define BAKED_PALETTE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "animation_clip.h"
+#include "clip_animator.h"
+
+// Looping clips pre-sampled into one static texture buffer, for background characters that
+// never blend or change clip: per frame the CPU only advances each agent's clock, and
+// anim_model.vs fetches the two baked frames around it and interpolates.
+//
+// Each clip is `frames` evenly spaced samples over its duration (the loop wraps from the
+// last back to the first), each sample `boneCount` final bone matrices. A matrix is stored
+// as its top three rows, one RGBA32F texel each (the bottom row of a skinning matrix is
+// always 0 0 0 1): 48 bytes instead of 64.
+//
+//   texel (firstMatrix + frame * boneCount + bone) * 3 + row
+//
+// An instance finds its clip through its block in the bone palette (see Crowd): the model
+// matrix, then one matrix whose first column is (firstMatrix, frames, framePosition, 0).
+class BakedPalettes {
+public:
+    static const int TEXELS_PER_MATRIX = 3;
+
+    struct Clip {
+        const AnimationClip* clip = nullptr;
+        int firstMatrix = 0;
+        int frames = 0;
+        double evaluateSeconds = 0.0; // a live ClipAnimator's full pose, averaged over the bake
+        size_t GetBytes(int boneCount) const { return (size_t)frames * boneCount * TEXELS_PER_MATRIX * 4 * sizeof(float); }
+    };
+
+    // `sampleRate` samples per second of clip time (at least two per clip). Needs a current
+    // GL context (the texture buffer).
+    BakedPalettes(const std::vector<const AnimationClip*>& clips, int boneCount, float sampleRate = 30.0f)
+        : m_BoneCount(boneCount), m_SampleRate(sampleRate) {
+        std::vector<float> rows;
+        for (const AnimationClip* clip : clips) {
+            if (!clip || Find(clip) >= 0) continue;
+            Clip baked;
+            baked.clip = clip;
+            baked.firstMatrix = (int)(rows.size() / (TEXELS_PER_MATRIX * 4));
+            float tps = clip->GetTicksPerSecond() > 0.0f ? clip->GetTicksPerSecond() : 25.0f;
+            float seconds = clip->GetDuration() / tps;
+            baked.frames = std::max(2, (int)std::lround(seconds * sampleRate));
+
+            ClipAnimator animator(clip);
+            auto begin = std::chrono::steady_clock::now();
+            for (int f = 0; f < baked.frames; f++) {
+                animator.SetClipTime(clip->GetDuration() * f / baked.frames);
+                animator.EvaluatePose();
+                const std::vector<glm::mat4>& bones = animator.GetFinalBoneMatrices();
+                for (int b = 0; b < boneCount; b++) {
+                    // clips may have fewer bones than the crowd's palette: identity past them
+                    glm::mat4 m = b < (int)bones.size() ? bones[b] : glm::mat4(1.0f);
+                    for (int r = 0; r < TEXELS_PER_MATRIX; r++)
+                        for (int c = 0; c < 4; c++) rows.push_back(m[c][r]);
+                }
+            }
+            baked.evaluateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() / baked.frames;
+            m_Clips.push_back(baked);
+        }
+
+        GLint maxTexels = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+        GLsizeiptr texels = (GLsizeiptr)(rows.size() / 4);
+        if (texels == 0 || texels > maxTexels) {
+            std::cout << "ERROR::BAKED_PALETTES: " << texels << " texels, GL_MAX_TEXTURE_BUFFER_SIZE is " << maxTexels << "\n";
+            m_Clips.clear();
+            return;
+        }
+        glGenBuffers(1, &m_Buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, m_Buffer);
+        glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)(rows.size() * sizeof(float)), rows.data(), GL_STATIC_DRAW);
+        glGenTextures(1, &m_Texture);
+        glBindTexture(GL_TEXTURE_BUFFER, m_Texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_Buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        m_Bytes = rows.size() * sizeof(float);
+    }
+
+    ~BakedPalettes() {
+        if (m_Texture) glDeleteTextures(1, &m_Texture);
+        if (m_Buffer) glDeleteBuffers(1, &m_Buffer);
+    }
+
+    BakedPalettes(const BakedPalettes&) = delete;
+    BakedPalettes& operator=(const BakedPalettes&) = delete;
+
+    bool IsValid() const { return m_Texture != 0; }
+
+    // for anim_model.vs's bakedPalettes sampler; nothing else uses the unit, so once will do
+    void Bind(int unit) const {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_BUFFER, m_Texture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // index of `clip`'s bake, -1 if it wasn't baked
+    int Find(const AnimationClip* clip) const {
+        for (int i = 0; i < (int)m_Clips.size(); i++)
+            if (m_Clips[i].clip == clip) return i;
+        return -1;
+    }
+    const Clip& GetClip(int i) const { return m_Clips[i]; }
+    int GetBoneCount() const { return m_BoneCount; }
+
+    // The block matrix after an instance's model matrix: where to fetch at clip time `ticks`
+    glm::mat4 Playback(int clip, float ticks) const {
+        const Clip& baked = m_Clips[clip];
+        float duration = baked.clip->GetDuration();
+        float position = duration > 0.0f ? ticks / duration * baked.frames : 0.0f;
+        position = std::fmod(std::max(position, 0.0f), (float)baked.frames);
+        glm::mat4 m(0.0f);
+        m[0] = glm::vec4((float)baked.firstMatrix, (float)baked.frames, position, 0.0f);
+        return m;
+    }
+
+    // memory per clip, and the CPU a live ClipAnimator per agent would spend instead
+    void PrintReport(int agents, std::ostream& os = std::cout) const {
+        os << "---- baked palettes (" << m_SampleRate << " samples/s, " << m_BoneCount << " bones) ----\n";
+        double evaluate = 0.0;
+        for (int i = 0; i < (int)m_Clips.size(); i++) {
+            const Clip& baked = m_Clips[i];
+            float tps = baked.clip->GetTicksPerSecond() > 0.0f ? baked.clip->GetTicksPerSecond() : 25.0f;
+            os << "  clip " << i << std::fixed << std::setprecision(2) << std::setw(7) << baked.clip->GetDuration() / tps << " s"
+               << std::setw(6) << baked.frames << " frames" << std::setw(7) << baked.GetBytes(m_BoneCount) / 1024 << " KB"
+               << "   live pose " << std::setprecision(1) << 1e6 * baked.evaluateSeconds << " us\n" << std::defaultfloat;
+            evaluate += baked.evaluateSeconds;
+        }
+        if (!m_Clips.empty()) evaluate /= m_Clips.size();
+        os << "  total " << m_Bytes / 1024 << " KB; " << agents << " live agents would cost ~" << std::fixed
+           << std::setprecision(2) << 1000.0 * evaluate * agents << " ms CPU per frame at full rate, baked: clock only\n"
+           << std::defaultfloat;
+    }
+
+private:
+    std::vector<Clip> m_Clips;
+    int m_BoneCount = 0;
+    float m_SampleRate = 0.0f;
+    size_t m_Bytes = 0;
+    GLuint m_Buffer = 0, m_Texture = 0;
+};
+
+#endif
@@ -0,0 +1,227 @@
+#ifndef BONE_HITBOX_H
+#define BONE_HITBOX_H
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "animation_clip.h"
+#include "clip_animator.h"
+#include "collision_world.h"
+
+// Hit volumes attached to the skeleton. Each volume is a capsule from one node's origin
+// towards another's (a bone and its child), so it follows the animated pose and needs no
+// per-rig offsets; a weapon is the hand's capsule stretched to a fixed length.
+//
+//   hurt volumes  where a character can be hit; placed every tick from the animator's
+//                 global transforms (BoneHitboxes)
+//   hit volumes   what deals damage (weapon, kicking foot); pre-sampled per clip at setup
+//                 (AttackSweep), so an attack's hit test is a lookup, not a pose evaluation
+enum BoneVolumeFlag : uint32_t {
+    VOLUME_HURT = 1u << 0,
+    VOLUME_HIT = 1u << 1,
+};
+
+struct BoneVolumeDesc {
+    const char* name;
+    const char* bone; // capsule start: this node's origin
+    const char* tip;  // direction (and, with length 0, the end): this node's origin
+    float radius;     // m
+    float length;     // m along bone -> tip; 0 = end at the tip node
+    uint32_t flags;
+};
+
+// Mixamo knight. The sword isn't a separate node in attack.dae (it's skinned to the right
+// hand), so its capsule runs from the hand out along the middle finger for a blade's length.
+const BoneVolumeDesc KNIGHT_VOLUMES[] = {
+    { "head",        "mixamorig_Head",       "mixamorig_HeadTop_End",      0.12f, 0.0f, VOLUME_HURT },
+    { "torso",       "mixamorig_Hips",       "mixamorig_Neck",             0.20f, 0.0f, VOLUME_HURT },
+    { "upper_arm_l", "mixamorig_LeftArm",    "mixamorig_LeftForeArm",      0.07f, 0.0f, VOLUME_HURT },
+    { "forearm_l",   "mixamorig_LeftForeArm","mixamorig_LeftHand",         0.06f, 0.0f, VOLUME_HURT },
+    { "upper_arm_r", "mixamorig_RightArm",   "mixamorig_RightForeArm",     0.07f, 0.0f, VOLUME_HURT },
+    { "forearm_r",   "mixamorig_RightForeArm","mixamorig_RightHand",       0.06f, 0.0f, VOLUME_HURT },
+    { "thigh_l",     "mixamorig_LeftUpLeg",  "mixamorig_LeftLeg",          0.09f, 0.0f, VOLUME_HURT },
+    { "shin_l",      "mixamorig_LeftLeg",    "mixamorig_LeftFoot",         0.07f, 0.0f, VOLUME_HURT },
+    { "thigh_r",     "mixamorig_RightUpLeg", "mixamorig_RightLeg",         0.09f, 0.0f, VOLUME_HURT },
+    { "shin_r",      "mixamorig_RightLeg",   "mixamorig_RightFoot",        0.07f, 0.0f, VOLUME_HURT },
+    { "sword",       "mixamorig_RightHand",  "mixamorig_RightHandMiddle1", 0.05f, 1.0f, VOLUME_HIT },
+};
+const int KNIGHT_VOLUME_COUNT = (int)(sizeof(KNIGHT_VOLUMES) / sizeof(KNIGHT_VOLUMES[0]));
+
+struct Capsule {
+    glm::vec3 a{ 0.0f }, b{ 0.0f };
+    float radius = 0.0f;
+
+    Aabb Bounds() const { return Aabb{ glm::min(a, b) - glm::vec3(radius), glm::max(a, b) + glm::vec3(radius) }; }
+};
+
+inline float DistanceToAabb(const glm::vec3& p, const Aabb& box) {
+    return glm::length(p - glm::clamp(p, box.min, box.max));
+}
+
+// distance from the segment to the box is convex along the segment: ternary search
+inline bool CapsuleOverlapsAabb(const Capsule& c, const Aabb& box) {
+    float lo = 0.0f, hi = 1.0f;
+    for (int i = 0; i < 24; i++) {
+        float m1 = lo + (hi - lo) / 3.0f, m2 = hi - (hi - lo) / 3.0f;
+        if (DistanceToAabb(glm::mix(c.a, c.b, m1), box) < DistanceToAabb(glm::mix(c.a, c.b, m2), box)) hi = m2;
+        else lo = m1;
+    }
+    return DistanceToAabb(glm::mix(c.a, c.b, 0.5f * (lo + hi)), box) <= c.radius;
+}
+
+// volume endpoints from node transforms (model space, or world with the model matrix applied)
+inline Capsule PlaceVolume(const BoneVolumeDesc& desc, const glm::mat4& boneGlobal, const glm::mat4& tipGlobal) {
+    Capsule c;
+    c.a = glm::vec3(boneGlobal[3]);
+    c.b = glm::vec3(tipGlobal[3]);
+    c.radius = desc.radius;
+    if (desc.length > 0.0f) {
+        glm::vec3 dir = c.b - c.a;
+        float len = glm::length(dir);
+        c.b = c.a + ((len > 1e-6f) ? dir / len : glm::vec3(0, 1, 0)) * desc.length;
+    }
+    return c;
+}
+
+// node indices of each volume in a clip / skeleton hierarchy (-1 where a name is missing)
+inline void ResolveVolumes(const AnimationClip& skeleton, const BoneVolumeDesc* descs, int count,
+                           std::vector<int>& bones, std::vector<int>& tips) {
+    bones.assign(count, -1);
+    tips.assign(count, -1);
+    for (int i = 0; i < count; i++) {
+        bones[i] = skeleton.FindNode(descs[i].bone);
+        tips[i] = skeleton.FindNode(descs[i].tip);
+        if (bones[i] < 0 || tips[i] < 0)
+            std::cout << "Warning: hit volume " << descs[i].name << " has no " << (bones[i] < 0 ? descs[i].bone : descs[i].tip) << " node\n";
+    }
+}
+
+// Hurt volumes of one character, placed in world space from its animator's global
+// transforms each tick.
+class BoneHitboxes {
+public:
+    BoneHitboxes(const AnimationClip& skeleton, const BoneVolumeDesc* descs, int count, uint32_t flags = VOLUME_HURT) {
+        for (int i = 0; i < count; i++)
+            if (descs[i].flags & flags) m_Descs.push_back(descs[i]);
+        ResolveVolumes(skeleton, m_Descs.data(), (int)m_Descs.size(), m_Bones, m_Tips);
+        m_Capsules.resize(m_Descs.size());
+    }
+
+    // `globals`: the animator's GetGlobalTransforms(); `model`: the character's model matrix
+    void Update(const std::vector<glm::mat4>& globals, const glm::mat4& model) {
+        m_Bounds = Aabb{ glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+        for (int i = 0; i < GetCount(); i++) {
+            if (m_Bones[i] < 0 || m_Tips[i] < 0) continue;
+            m_Capsules[i] = PlaceVolume(m_Descs[i], model * globals[m_Bones[i]], model * globals[m_Tips[i]]);
+            Aabb b = m_Capsules[i].Bounds();
+            m_Bounds.min = glm::min(m_Bounds.min, b.min);
+            m_Bounds.max = glm::max(m_Bounds.max, b.max);
+        }
+    }
+
+    int GetCount() const { return (int)m_Descs.size(); }
+    const Capsule& GetCapsule(int i) const { return m_Capsules[i]; }
+    const BoneVolumeDesc& GetDesc(int i) const { return m_Descs[i]; }
+    // all volumes, as of the last Update
+    const Aabb& GetBounds() const { return m_Bounds; }
+
+private:
+    std::vector<BoneVolumeDesc> m_Descs;
+    std::vector<int> m_Bones, m_Tips;
+    std::vector<Capsule> m_Capsules;
+    Aabb m_Bounds;
+};
+
+// The hit volumes of one clip, sampled in model space at setup. Samples are SAMPLE_HZ
+// apart, with extra ones wherever a capsule end moves more than its radius between two,
+// so consecutive samples overlap and together cover the swept volume (no gaps for a fast
+// swing to pass through). A sample is active while the volume's far end moves faster
+// than ACTIVE_SPEED: the wind-up and recovery don't hit.
+class AttackSweep {
+public:
+    static constexpr float SAMPLE_HZ = 120.0f;
+    static constexpr float ACTIVE_SPEED = 2.5f; // m/s
+
+    struct Sample {
+        float time;    // seconds into the clip
+        int volume;    // index into the hit volumes
+        Capsule capsule;
+        bool active;
+    };
+
+    AttackSweep() = default;
+
+    AttackSweep(const AnimationClip& clip, const BoneVolumeDesc* descs, int count) {
+        for (int i = 0; i < count; i++)
+            if (descs[i].flags & VOLUME_HIT) m_Descs.push_back(descs[i]);
+        m_Clip = &clip;
+        if (m_Descs.empty() || !clip.IsValid() || clip.GetTicksPerSecond() <= 0.0f) return;
+        ResolveVolumes(clip, m_Descs.data(), (int)m_Descs.size(), m_Bones, m_Tips);
+
+        ClipAnimator animator(&clip);
+        m_Duration = clip.GetDuration() / clip.GetTicksPerSecond();
+        int frames = std::max(1, (int)std::ceil(m_Duration * SAMPLE_HZ));
+        for (int v = 0; v < (int)m_Descs.size(); v++) {
+            if (m_Bones[v] < 0 || m_Tips[v] < 0) continue;
+            Capsule prev = SampleAt(animator, v, 0.0f);
+            float prevTime = 0.0f;
+            m_Samples.push_back({ 0.0f, v, prev, false });
+            for (int f = 1; f <= frames; f++) {
+                float time = std::min(m_Duration, f / SAMPLE_HZ);
+                Capsule next = SampleAt(animator, v, time);
+                float moved = std::max(glm::length(next.a - prev.a), glm::length(next.b - prev.b));
+                int steps = std::max(1, (int)std::ceil(moved / std::max(next.radius, 1e-3f)));
+                for (int s = 1; s <= steps; s++) {
+                    float t = prevTime + (time - prevTime) * s / steps;
+                    Capsule c = (s == steps) ? next : SampleAt(animator, v, t);
+                    const Capsule& last = m_Samples.back().capsule;
+                    float speed = glm::length(c.b - last.b) / std::max(t - m_Samples.back().time, 1e-6f);
+                    m_Samples.push_back({ t, v, c, speed > ACTIVE_SPEED });
+                }
+                prev = next;
+                prevTime = time;
+            }
+        }
+        std::stable_sort(m_Samples.begin(), m_Samples.end(), [](const Sample& x, const Sample& y) { return x.time < y.time; });
+        for (const Sample& s : m_Samples) m_ActiveCount += s.active;
+    }
+
+    // fn(sample) for every active sample with time in (from, to], seconds into the clip
+    template <class F>
+    void ForEachActive(float from, float to, F&& fn) const {
+        auto it = std::upper_bound(m_Samples.begin(), m_Samples.end(), from, [](float t, const Sample& s) { return t < s.time; });
+        for (; it != m_Samples.end() && it->time <= to; ++it)
+            if (it->active) fn(*it);
+    }
+
+    const AnimationClip* GetClip() const { return m_Clip; }
+    float GetDuration() const { return m_Duration; }
+    int GetSampleCount() const { return (int)m_Samples.size(); }
+    int GetActiveCount() const { return m_ActiveCount; }
+    const BoneVolumeDesc& GetDesc(int volume) const { return m_Descs[volume]; }
+
+private:
+    Capsule SampleAt(ClipAnimator& animator, int volume, float seconds) {
+        // SetClipTime wraps at the duration; stay just inside the last frame
+        float ticks = std::min(seconds * m_Clip->GetTicksPerSecond(), m_Clip->GetDuration() * 0.9999f);
+        animator.SetClipTime(ticks);
+        animator.EvaluatePose();
+        const std::vector<glm::mat4>& globals = animator.GetGlobalTransforms();
+        return PlaceVolume(m_Descs[volume], globals[m_Bones[volume]], globals[m_Tips[volume]]);
+    }
+
+    const AnimationClip* m_Clip = nullptr;
+    float m_Duration = 0.0f;
+    std::vector<BoneVolumeDesc> m_Descs;
+    std::vector<int> m_Bones, m_Tips;
+    std::vector<Sample> m_Samples; // by time
+    int m_ActiveCount = 0;
+};
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef BONE_PALETTE_H
+#define BONE_PALETTE_H
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Bone palettes for skinning, streamed through a texture buffer (RGBA32F, 4 texels per mat4)
+// that anim_model.vs reads with texelFetch. The buffer is a ring of FRAMES regions, each
+// guarded by a fence, so the CPU writes frame N while the GPU still reads N-1 / N-2 and
+// nothing is allocated per frame.
+//
+// With ARB_buffer_storage the ring is mapped once, persistently; on plain GL 3.3 each
+// region is mapped unsynchronized at BeginFrame (safe because of the fence) and unmapped
+// in Submit.
+//
+// Per frame:
+//   palette.BeginFrame();
+//   int base = palette.Upload(matrices, count);   // any number of palettes
+//   palette.Submit(unit);                          // before the draws that read it
+//   ... draw with uniform bonePaletteBase = base ...
+//   palette.EndFrame();                            // after those draws
+class BonePaletteBuffer {
+public:
+    static const int FRAMES = 3;
+
+    explicit BonePaletteBuffer(int matricesPerFrame) {
+        GLint maxTexels = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+        int maxPerFrame = std::max(1, maxTexels / (4 * FRAMES));
+        if (matricesPerFrame > maxPerFrame) {
+            std::cout << "Warning: bone palette clamped to " << maxPerFrame << " matrices per frame (GL_MAX_TEXTURE_BUFFER_SIZE)\n";
+            matricesPerFrame = maxPerFrame;
+        }
+        m_Capacity = matricesPerFrame;
+        GLsizeiptr bytes = (GLsizeiptr)m_Capacity * FRAMES * sizeof(glm::mat4);
+
+        glGenBuffers(1, &m_Buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, m_Buffer);
+#ifdef GL_ARB_buffer_storage
+        if (GLAD_GL_ARB_buffer_storage) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_TEXTURE_BUFFER, bytes, nullptr, flags);
+            m_Persistent = (glm::mat4*)glMapBufferRange(GL_TEXTURE_BUFFER, 0, bytes, flags);
+        }
+#endif
+        if (!m_Persistent)
+            glBufferData(GL_TEXTURE_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+
+        glGenTextures(1, &m_Texture);
+        glBindTexture(GL_TEXTURE_BUFFER, m_Texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_Buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    ~BonePaletteBuffer() {
+        for (GLsync& fence : m_Fences) {
+            if (fence) glDeleteSync(fence);
+        }
+        if (m_Persistent) {
+            glBindBuffer(GL_TEXTURE_BUFFER, m_Buffer);
+            glUnmapBuffer(GL_TEXTURE_BUFFER);
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        }
+        glDeleteTextures(1, &m_Texture);
+        glDeleteBuffers(1, &m_Buffer);
+    }
+
+    BonePaletteBuffer(const BonePaletteBuffer&) = delete;
+    BonePaletteBuffer& operator=(const BonePaletteBuffer&) = delete;
+
+    // wait until the GPU is done with the region we're about to overwrite
+    void BeginFrame() {
+        m_Frame = (m_Frame + 1) % FRAMES;
+        m_Used = 0;
+
+        if (GLsync& fence = m_Fences[m_Frame]) {
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+
+        if (m_Persistent) {
+            m_Write = m_Persistent + (size_t)m_Frame * m_Capacity;
+        }
+        else {
+            glBindBuffer(GL_TEXTURE_BUFFER, m_Buffer);
+            m_Write = (glm::mat4*)glMapBufferRange(GL_TEXTURE_BUFFER,
+                (GLintptr)m_Frame * m_Capacity * sizeof(glm::mat4), (GLsizeiptr)m_Capacity * sizeof(glm::mat4),
+                GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        }
+    }
+
+    // Copy one palette into this frame's region. Returns the matrix index to pass as
+    // bonePaletteBase, or -1 if the region is full (or mapping failed).
+    int Upload(const glm::mat4* matrices, int count) {
+        int base = -1;
+        glm::mat4* dst = Allocate(count, base);
+        if (dst) std::memcpy(dst, matrices, (size_t)count * sizeof(glm::mat4));
+        return base;
+    }
+
+    // Reserve `count` matrices in this frame's region and return where to write them
+    // (write-only memory), with their matrix index in outBase. nullptr if full.
+    glm::mat4* Allocate(int count, int& outBase) {
+        outBase = -1;
+        if (!m_Write || m_Used + count > m_Capacity) return nullptr;
+        glm::mat4* dst = m_Write + m_Used;
+        outBase = m_Frame * m_Capacity + m_Used;
+        m_Used += count;
+        return dst;
+    }
+
+    // make this frame's writes visible and bind the palette to texture unit `unit`
+    void Submit(int unit) {
+        if (!m_Persistent && m_Write) {
+            glBindBuffer(GL_TEXTURE_BUFFER, m_Buffer);
+            glUnmapBuffer(GL_TEXTURE_BUFFER);
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        }
+        m_Write = nullptr;
+
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_BUFFER, m_Texture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // fence the region once every draw that reads it has been issued
+    void EndFrame() {
+        m_Fences[m_Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    int GetCapacity() const { return m_Capacity; }
+    int GetUsed() const { return m_Used; }
+    bool IsPersistent() const { return m_Persistent != nullptr; }
+
+private:
+    GLuint m_Buffer = 0;
+    GLuint m_Texture = 0;
+    glm::mat4* m_Persistent = nullptr; // whole ring, when persistently mapped
+    glm::mat4* m_Write = nullptr;      // start of this frame's region while writable
+    GLsync m_Fences[FRAMES] = {};
+    int m_Capacity = 0; // matrices per frame
+    int m_Used = 0;
+    int m_Frame = 0;
+};
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef CLIP_ANIMATOR_H
+#define CLIP_ANIMATOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "animation_clip.h"
+#include "job_system.h"
+
+// Plays an AnimationClip; drop-in for learnopengl's Animator. The palette is sized to the
+// rig (no fixed 100-bone cap) and grows if a later clip binds extra bones.
+//
+// Pose evaluation is one forward pass over the clip's flattened hierarchy: parents come
+// first, so each node's global transform is its parent's (already computed) times its
+// local one. No recursion, no name lookups, and the scratch buffers are only reallocated
+// when a bigger skeleton shows up.
+//
+// Pre-order also makes every subtree a contiguous node range, so one pose can be split
+// across threads (UpdateAnimationAsync): the few nodes above the split ("trunk") are
+// evaluated first, then each subtree below them is an independent job.
+class ClipAnimator {
+public:
+    explicit ClipAnimator(const AnimationClip* clip) {
+        m_CurrentTime = 0.0f;
+        m_CurrentClip = clip;
+        m_FinalBoneMatrices.assign(clip ? clip->GetBoneCount() : 0, glm::mat4(1.0f));
+        m_Cursors.assign(clip ? clip->GetTracks().size() : 0, TrackCursor());
+    }
+
+    void UpdateAnimation(float dt) {
+        AdvanceTime(dt);
+        if (!m_CurrentClip) return;
+        EvaluatePose();
+    }
+
+    // Same as UpdateAnimation, with the pose split into subtree jobs of about `grain` nodes
+    // on `jobs`. The trunk runs on the calling thread; the pose is complete once `done` is
+    // (jobs.Wait(done) before reading the palette).
+    void UpdateAnimationAsync(float dt, JobSystem& jobs, JobCounter& done, int grain = 16) {
+        AdvanceTime(dt);
+        if (!m_CurrentClip) return;
+        if (grain != m_SplitGrain || m_SplitClip != m_CurrentClip) BuildSplit(grain);
+        PrepareScratch();
+
+        for (int node : m_Trunk) EvaluateNode(node);
+        for (int j = 0; j < (int)m_Subtrees.size(); j++)
+            jobs.Kick(&EvaluateSubtrees, this, j, j + 1, done);
+    }
+
+    void PlayAnimation(const AnimationClip* clip) {
+        m_CurrentClip = clip;
+        m_CurrentTime = 0.0f;
+        if (!clip) return;
+        if (clip->GetBoneCount() > (int)m_FinalBoneMatrices.size())
+            m_FinalBoneMatrices.resize(clip->GetBoneCount(), glm::mat4(1.0f));
+        m_Cursors.assign(clip->GetTracks().size(), TrackCursor()); // capacity is kept across clips
+    }
+
+    // local -> global -> skinning matrix for every node, in hierarchy order
+    void EvaluatePose() {
+        PrepareScratch();
+        EvaluateRange(0, m_CurrentClip->GetNodeCount());
+    }
+
+    // LOD variant: only nodes at most maxDepth below the root bone are sampled; deeper ones
+    // (fingers, ...) reuse their last sampled local transform but still follow their parent.
+    // Returns the number of nodes sampled.
+    int EvaluatePose(int maxDepth) {
+        if (!m_CurrentClip) return 0;
+        PrepareScratch();
+        const AnimationClip& clip = *m_CurrentClip;
+        const int nodeCount = clip.GetNodeCount();
+        const int* depths = clip.GetNodeDepths().data();
+        int sampled = 0;
+        for (int i = 0; i < nodeCount; i++) {
+            if (depths[i] <= maxDepth) { EvaluateNode(i); sampled++; }
+            else ComposeNode(i, m_LocalTransforms[i]);
+        }
+        return sampled;
+    }
+
+    // move the clip time on without evaluating (e.g. while off screen)
+    void AdvanceTime(float dt) {
+        m_DeltaTime = dt;
+        if (!m_CurrentClip) return;
+        m_CurrentTime += m_CurrentClip->GetTicksPerSecond() * dt;
+        if (m_CurrentClip->GetDuration() > 0.0f)
+            m_CurrentTime = std::fmod(m_CurrentTime, m_CurrentClip->GetDuration());
+    }
+
+    // jump to a time (ticks) in the current clip, e.g. to desynchronize crowd agents
+    void SetClipTime(float ticks) {
+        m_CurrentTime = (m_CurrentClip && m_CurrentClip->GetDuration() > 0.0f)
+            ? std::fmod(std::max(ticks, 0.0f), m_CurrentClip->GetDuration()) : 0.0f;
+    }
+    float GetClipTime() const { return m_CurrentTime; }
+
+    const std::vector<glm::mat4>& GetFinalBoneMatrices() const { return m_FinalBoneMatrices; }
+    // model-space transform of every node of the current clip (valid after UpdateAnimation)
+    const std::vector<glm::mat4>& GetGlobalTransforms() const { return m_GlobalTransforms; }
+    const AnimationClip* GetCurrentClip() const { return m_CurrentClip; }
+    // subtree jobs the last UpdateAnimationAsync kicked
+    int GetSplitJobCount() const { return (int)m_Subtrees.size(); }
+
+private:
+    void PrepareScratch() {
+        int nodeCount = m_CurrentClip->GetNodeCount();
+        if ((int)m_GlobalTransforms.size() < nodeCount) m_GlobalTransforms.resize(nodeCount);
+        for (int i = (int)m_LocalTransforms.size(); i < nodeCount; i++)
+            m_LocalTransforms.push_back(m_CurrentClip->GetNodeBindLocal()[i]);
+    }
+
+    // nodes [begin, end); parents outside the range must already be evaluated
+    void EvaluateRange(int begin, int end) {
+        for (int i = begin; i < end; i++) EvaluateNode(i);
+    }
+
+    void EvaluateNode(int i) {
+        const AnimationClip& clip = *m_CurrentClip;
+        int track = clip.GetNodeTracks()[i];
+        glm::mat4& local = m_LocalTransforms[i];
+        local = (track >= 0) ? clip.SampleTrack(track, m_CurrentTime, &m_Cursors[track]) : clip.GetNodeBindLocal()[i];
+        ComposeNode(i, local);
+    }
+
+    void ComposeNode(int i, const glm::mat4& local) {
+        const AnimationClip& clip = *m_CurrentClip;
+        int parent = clip.GetNodeParents()[i];
+        int bone = clip.GetNodeBones()[i];
+        glm::mat4& global = m_GlobalTransforms[i];
+        global = (parent >= 0) ? m_GlobalTransforms[parent] * local : local;
+        if (bone >= 0 && bone < (int)m_FinalBoneMatrices.size())
+            m_FinalBoneMatrices[bone] = global * clip.GetNodeOffsets()[i];
+    }
+
+    // Trunk = nodes whose subtree is bigger than `grain` (in pre-order, so parents stay
+    // first); every child of a trunk node that isn't trunk itself roots one job range.
+    // Tracks and bones belong to exactly one node, so the jobs never write the same slot.
+    void BuildSplit(int grain) {
+        const std::vector<int>& parents = m_CurrentClip->GetNodeParents();
+        int nodeCount = (int)parents.size();
+        std::vector<int> subtreeEnd(nodeCount);
+        for (int i = nodeCount - 1; i >= 0; i--) {
+            subtreeEnd[i] = std::max(subtreeEnd[i], i + 1);
+            if (parents[i] >= 0) subtreeEnd[parents[i]] = std::max(subtreeEnd[parents[i]], subtreeEnd[i]);
+        }
+
+        m_Trunk.clear();
+        m_Subtrees.clear();
+        for (int i = 0; i < nodeCount;) {
+            if (subtreeEnd[i] - i > std::max(1, grain)) { m_Trunk.push_back(i); i++; }
+            else { m_Subtrees.push_back({ (uint32_t)i, (uint32_t)(subtreeEnd[i] - i) }); i = subtreeEnd[i]; }
+        }
+        m_SplitGrain = grain;
+        m_SplitClip = m_CurrentClip;
+    }
+
+    static void EvaluateSubtrees(void* ctx, int begin, int end) {
+        ClipAnimator* self = static_cast<ClipAnimator*>(ctx);
+        for (int j = begin; j < end; j++) {
+            const KeyRange& r = self->m_Subtrees[j];
+            self->EvaluateRange((int)r.first, (int)(r.first + r.count));
+        }
+    }
+
+    std::vector<glm::mat4> m_FinalBoneMatrices;
+    std::vector<glm::mat4> m_GlobalTransforms;
+    std::vector<glm::mat4> m_LocalTransforms; // last sampled local per node (LOD reuses it)
+    std::vector<TrackCursor> m_Cursors; // one per track of the current clip
+    const AnimationClip* m_CurrentClip;
+    float m_CurrentTime;
+    float m_DeltaTime = 0.0f;
+
+    // subtree split for UpdateAnimationAsync, rebuilt when the clip or grain changes
+    std::vector<int> m_Trunk;
+    std::vector<KeyRange> m_Subtrees;
+    const AnimationClip* m_SplitClip = nullptr;
+    int m_SplitGrain = -1;
+};
+
+#endif
@@ -0,0 +1,445 @@
+#ifndef CLIP_CACHE_H
+#define CLIP_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "animation_clip.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (m_File == INVALID_HANDLE_VALUE) return;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0) return;
+        m_Mapping = CreateFileMappingA(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!m_Mapping) return;
+        m_Data = (const unsigned char*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+        if (m_Data) m_Size = (size_t)size.QuadPart;
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                m_Data = (const unsigned char*)p;
+                m_Size = (size_t)st.st_size;
+            }
+        }
+        close(fd); // the mapping keeps the file alive
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (m_Data) UnmapViewOfFile(m_Data);
+        if (m_Mapping) CloseHandle(m_Mapping);
+        if (m_File != INVALID_HANDLE_VALUE) CloseHandle(m_File);
+#else
+        if (m_Data) munmap((void*)m_Data, m_Size);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool IsOpen() const { return m_Data != nullptr; }
+    const unsigned char* Data() const { return m_Data; }
+    size_t Size() const { return m_Size; }
+
+private:
+    const unsigned char* m_Data = nullptr;
+    size_t m_Size = 0;
+#ifdef _WIN32
+    HANDLE m_File = INVALID_HANDLE_VALUE;
+    HANDLE m_Mapping = NULL;
+#endif
+};
+
+// Cooked clip file (<clip>.dae.clip). Everything AnimationClip needs from the .dae, in the
+// same flattened / structure-of-arrays layout AnimationClip plays from, so loading is a
+// handful of bulk copies out of the mapping.
+//
+//   ClipFileHeader
+//   ClipFileNode[nodeCount]          pre-order, parent index < own index
+//   ClipFileBoneInfo[boneInfoCount]
+//   ClipFileTrack[trackCount]
+//   float positionTimes[P], positionValues[P * 3]     (x,y,z)
+//   float rotationTimes[R], rotationValues[R * 4]     (w,x,y,z)
+//   float scaleTimes[S],    scaleValues[S * 3]        (x,y,z)
+//   char strings[stringsSize]        names, not NUL-terminated
+//
+// With CLIP_FLAG_COMPRESSED the value arrays hold packed keys instead, each padded to 4 bytes,
+// and the per-track quantization ranges follow the scale keys:
+//   PackedVec3 positionValues[P], PackedQuat rotationValues[R], PackedVec3 scaleValues[S]
+//   float positionRanges[trackCount * 6], scaleRanges[trackCount * 6]   (min xyz, extent xyz)
+//
+// Everything is 4-byte aligned and stored in host byte order (little-endian on every target we ship).
+// Version history: 1 = per-track interleaved keys + child counts, 2 = flat SoA,
+// 3 = + keyRate for uniformly resampled clips, 4 = + flags / compressed keys (current).
+const char CLIP_FILE_MAGIC[4] = { 'K', 'C', 'L', 'P' };
+const uint32_t CLIP_FILE_VERSION = 4;
+const uint32_t CLIP_FLAG_COMPRESSED = 1;
+
+struct ClipFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t fileSize;
+    float duration;
+    float ticksPerSecond;
+    float keyRate; // keys per tick if resampled uniformly, else 0
+    uint32_t nodeCount;
+    uint32_t boneInfoCount;
+    uint32_t trackCount;
+    uint32_t positionKeyCount;
+    uint32_t rotationKeyCount;
+    uint32_t scaleKeyCount;
+    uint32_t stringsSize;
+    uint32_t flags; // CLIP_FLAG_*
+};
+
+struct ClipFileNode {
+    uint32_t nameOffset, nameLength;
+    int32_t parent;
+    float transformation[16];
+};
+
+struct ClipFileBoneInfo {
+    uint32_t nameOffset, nameLength;
+    int32_t id;
+    float offset[16];
+};
+
+struct ClipFileTrack {
+    uint32_t nameOffset, nameLength;
+    int32_t id;
+    uint32_t firstPosition, numPositions;
+    uint32_t firstRotation, numRotations;
+    uint32_t firstScale, numScales;
+};
+
+static_assert(sizeof(ClipFileHeader) == 56, "ClipFileHeader layout changed, bump CLIP_FILE_VERSION");
+static_assert(sizeof(ClipFileNode) == 76, "ClipFileNode layout changed, bump CLIP_FILE_VERSION");
+static_assert(sizeof(ClipFileBoneInfo) == 76, "ClipFileBoneInfo layout changed, bump CLIP_FILE_VERSION");
+static_assert(sizeof(ClipFileTrack) == 36, "ClipFileTrack layout changed, bump CLIP_FILE_VERSION");
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "vec3 keys are copied as raw floats");
+static_assert(sizeof(PackedVec3) == 6 && sizeof(PackedQuat) == 6, "packed keys are copied as raw bytes");
+static_assert(sizeof(QuantRange) == 6 * sizeof(float), "quantization ranges are copied as raw floats");
+
+// bytes of a section padded to the file's 4-byte alignment
+inline uint64_t ClipFileAligned(uint64_t bytes) { return (bytes + 3) & ~(uint64_t)3; }
+
+// Cook / load AnimationClips through the binary cache.
+class ClipCache {
+public:
+    static std::string CachePathFor(const std::string& sourcePath) { return sourcePath + ".clip"; }
+
+    // cache exists and is at least as new as the source (a cache without a source is always fresh)
+    static bool IsFresh(const std::string& sourcePath, const std::string& cachePath) {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        auto cacheTime = fs::last_write_time(cachePath, ec);
+        if (ec) return false;
+        auto sourceTime = fs::last_write_time(sourcePath, ec);
+        if (ec) return true;
+        return cacheTime >= sourceTime;
+    }
+
+    // Offline step: parse the .dae and write its .clip next to it. With keysPerSecond > 0 every
+    // animated channel is resampled to that rate so runtime key lookup is a multiply.
+    // With `compression` the clip is stored compressed instead (see AnimationClip::Compress).
+    static bool Cook(const std::string& sourcePath, float keysPerSecond = 0.0f, const ClipCompression* compression = nullptr) {
+        AnimationClip clip(sourcePath);
+        if (!clip.IsValid()) return false;
+        if (compression)
+            clip.Compress(*compression);
+        else if (keysPerSecond > 0.0f && clip.GetTicksPerSecond() > 0.0f)
+            clip.ResampleUniform(keysPerSecond / clip.GetTicksPerSecond());
+        return Write(clip, CachePathFor(sourcePath));
+    }
+
+    // Runtime entry point: read the cooked clip if it's fresh, otherwise (re)cook it from the .dae.
+    // Either way the result is bound to the model's bone ids.
+    static AnimationClip Load(const std::string& sourcePath, Model& model) {
+        AnimationClip clip = LoadUnbound(sourcePath);
+        clip.BindToModel(model);
+        return clip;
+    }
+
+    // Load() without the model binding; touches no shared state, so clips can load on worker
+    // threads and be bound (in a fixed order) once the model is up.
+    static AnimationClip LoadUnbound(const std::string& sourcePath) {
+        std::string cachePath = CachePathFor(sourcePath);
+        AnimationClip clip;
+
+        if (!IsFresh(sourcePath, cachePath) || !Read(cachePath, clip)) {
+            clip = AnimationClip(sourcePath);
+            if (clip.IsValid() && !Write(clip, cachePath))
+                std::cout << "Warning: could not write clip cache " << cachePath << "\n";
+        }
+        return clip;
+    }
+
+    static bool Write(const AnimationClip& clip, const std::string& cachePath) {
+        std::vector<ClipFileNode> nodes;
+        std::vector<ClipFileBoneInfo> boneInfos;
+        std::vector<ClipFileTrack> tracks;
+        std::string strings;
+
+        auto addString = [&strings](const std::string& s, uint32_t& offset, uint32_t& length) {
+            offset = (uint32_t)strings.size();
+            length = (uint32_t)s.size();
+            strings += s;
+        };
+
+        for (int i = 0; i < clip.GetNodeCount(); i++) {
+            ClipFileNode n;
+            addString(clip.m_NodeNames[i], n.nameOffset, n.nameLength);
+            n.parent = clip.m_NodeParents[i];
+            std::memcpy(n.transformation, glm::value_ptr(clip.m_NodeBindLocal[i]), sizeof(n.transformation));
+            nodes.push_back(n);
+        }
+
+        for (const auto& entry : clip.m_BoneInfoMap) {
+            ClipFileBoneInfo info;
+            addString(entry.first, info.nameOffset, info.nameLength);
+            info.id = entry.second.id;
+            std::memcpy(info.offset, glm::value_ptr(entry.second.offset), sizeof(info.offset));
+            boneInfos.push_back(info);
+        }
+
+        for (const BoneTrack& track : clip.m_Tracks) {
+            ClipFileTrack t;
+            addString(track.name, t.nameOffset, t.nameLength);
+            t.id = track.id;
+            t.firstPosition = track.positions.first;  t.numPositions = track.positions.count;
+            t.firstRotation = track.rotations.first;  t.numRotations = track.rotations.count;
+            t.firstScale = track.scales.first;        t.numScales = track.scales.count;
+            tracks.push_back(t);
+        }
+
+        std::vector<float> rotationValues;
+        rotationValues.reserve(clip.m_RotationValues.size() * 4);
+        for (const glm::quat& q : clip.m_RotationValues)
+            rotationValues.insert(rotationValues.end(), { q.w, q.x, q.y, q.z });
+
+        // pad the string table so the file size stays a multiple of 4
+        while (strings.size() % 4) strings.push_back('\0');
+
+        ClipFileHeader header;
+        std::memcpy(header.magic, CLIP_FILE_MAGIC, sizeof(header.magic));
+        header.version = CLIP_FILE_VERSION;
+        header.fileSize = 0; // patched once the blob is built
+        header.duration = clip.m_Duration;
+        header.ticksPerSecond = clip.m_TicksPerSecond;
+        header.keyRate = clip.m_KeyRate;
+        header.nodeCount = (uint32_t)nodes.size();
+        header.boneInfoCount = (uint32_t)boneInfos.size();
+        header.trackCount = (uint32_t)tracks.size();
+        header.positionKeyCount = (uint32_t)clip.m_PositionTimes.size();
+        header.rotationKeyCount = (uint32_t)clip.m_RotationTimes.size();
+        header.scaleKeyCount = (uint32_t)clip.m_ScaleTimes.size();
+        header.stringsSize = (uint32_t)strings.size();
+        header.flags = clip.m_Compressed ? CLIP_FLAG_COMPRESSED : 0;
+
+        std::vector<char> blob;
+        auto append = [&blob](const void* data, size_t bytes) {
+            blob.insert(blob.end(), (const char*)data, (const char*)data + bytes);
+            blob.resize((size_t)ClipFileAligned(blob.size()), '\0');
+        };
+        append(&header, sizeof(header));
+        append(nodes.data(), nodes.size() * sizeof(ClipFileNode));
+        append(boneInfos.data(), boneInfos.size() * sizeof(ClipFileBoneInfo));
+        append(tracks.data(), tracks.size() * sizeof(ClipFileTrack));
+        if (clip.m_Compressed) {
+            append(clip.m_PositionTimes.data(), clip.m_PositionTimes.size() * sizeof(float));
+            append(clip.m_PackedPositions.data(), clip.m_PackedPositions.size() * sizeof(PackedVec3));
+            append(clip.m_RotationTimes.data(), clip.m_RotationTimes.size() * sizeof(float));
+            append(clip.m_PackedRotations.data(), clip.m_PackedRotations.size() * sizeof(PackedQuat));
+            append(clip.m_ScaleTimes.data(), clip.m_ScaleTimes.size() * sizeof(float));
+            append(clip.m_PackedScales.data(), clip.m_PackedScales.size() * sizeof(PackedVec3));
+            append(clip.m_PositionRanges.data(), clip.m_PositionRanges.size() * sizeof(QuantRange));
+            append(clip.m_ScaleRanges.data(), clip.m_ScaleRanges.size() * sizeof(QuantRange));
+        }
+        else {
+            append(clip.m_PositionTimes.data(), clip.m_PositionTimes.size() * sizeof(float));
+            append(clip.m_PositionValues.data(), clip.m_PositionValues.size() * sizeof(glm::vec3));
+            append(clip.m_RotationTimes.data(), clip.m_RotationTimes.size() * sizeof(float));
+            append(rotationValues.data(), rotationValues.size() * sizeof(float));
+            append(clip.m_ScaleTimes.data(), clip.m_ScaleTimes.size() * sizeof(float));
+            append(clip.m_ScaleValues.data(), clip.m_ScaleValues.size() * sizeof(glm::vec3));
+        }
+        append(strings.data(), strings.size());
+
+        uint32_t fileSize = (uint32_t)blob.size();
+        std::memcpy(blob.data() + offsetof(ClipFileHeader, fileSize), &fileSize, sizeof(fileSize));
+
+        // write to a temp file and rename, so a reader never maps a half-written cache
+        std::string tmpPath = cachePath + ".tmp";
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out) return false;
+            out.write(blob.data(), blob.size());
+            if (!out) return false;
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmpPath, cachePath, ec);
+        return !ec;
+    }
+
+    // Rebuild a clip from a cooked file. Returns false (leaving clip untouched) on any
+    // mismatch so the caller can fall back to the .dae.
+    static bool Read(const std::string& cachePath, AnimationClip& clip) {
+        MappedFile file(cachePath);
+        if (!file.IsOpen() || file.Size() < sizeof(ClipFileHeader)) return false;
+
+        const unsigned char* base = file.Data();
+        ClipFileHeader header;
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, CLIP_FILE_MAGIC, sizeof(header.magic)) != 0) return false;
+        if (header.version != CLIP_FILE_VERSION || header.fileSize != file.Size()) return false;
+
+        // walk the sections in order, refusing anything that runs past the end
+        size_t at = sizeof(ClipFileHeader);
+        bool inBounds = true;
+        auto take = [&](uint64_t bytes) -> const unsigned char* {
+            bytes = ClipFileAligned(bytes);
+            if (!inBounds || at + bytes > file.Size()) { inBounds = false; return nullptr; }
+            const unsigned char* p = base + at;
+            at += (size_t)bytes;
+            return p;
+        };
+        const bool compressed = (header.flags & CLIP_FLAG_COMPRESSED) != 0;
+        const size_t vec3Key = compressed ? sizeof(PackedVec3) : 3 * sizeof(float);
+        const size_t quatKey = compressed ? sizeof(PackedQuat) : 4 * sizeof(float);
+
+        const ClipFileNode* nodes = (const ClipFileNode*)take((uint64_t)header.nodeCount * sizeof(ClipFileNode));
+        const ClipFileBoneInfo* boneInfos = (const ClipFileBoneInfo*)take((uint64_t)header.boneInfoCount * sizeof(ClipFileBoneInfo));
+        const ClipFileTrack* tracks = (const ClipFileTrack*)take((uint64_t)header.trackCount * sizeof(ClipFileTrack));
+        const float* positionTimes = (const float*)take((uint64_t)header.positionKeyCount * sizeof(float));
+        const unsigned char* positionValues = take((uint64_t)header.positionKeyCount * vec3Key);
+        const float* rotationTimes = (const float*)take((uint64_t)header.rotationKeyCount * sizeof(float));
+        const unsigned char* rotationValues = take((uint64_t)header.rotationKeyCount * quatKey);
+        const float* scaleTimes = (const float*)take((uint64_t)header.scaleKeyCount * sizeof(float));
+        const unsigned char* scaleValues = take((uint64_t)header.scaleKeyCount * vec3Key);
+        const unsigned char* positionRanges = compressed ? take((uint64_t)header.trackCount * sizeof(QuantRange)) : nullptr;
+        const unsigned char* scaleRanges = compressed ? take((uint64_t)header.trackCount * sizeof(QuantRange)) : nullptr;
+        const char* strings = (const char*)take(header.stringsSize);
+        if (!inBounds || at != file.Size() || header.nodeCount == 0) return false;
+
+        auto nameOk = [&](uint32_t offset, uint32_t length) {
+            return (uint64_t)offset + length <= header.stringsSize;
+        };
+        auto rangeOk = [](uint32_t first, uint32_t count, uint32_t total) {
+            return (uint64_t)first + count <= total;
+        };
+
+        AnimationClip result;
+        result.m_Duration = header.duration;
+        result.m_TicksPerSecond = header.ticksPerSecond;
+        result.m_KeyRate = header.keyRate;
+
+        result.m_NodeNames.resize(header.nodeCount);
+        result.m_NodeParents.resize(header.nodeCount);
+        result.m_NodeBindLocal.resize(header.nodeCount);
+        for (uint32_t i = 0; i < header.nodeCount; i++) {
+            const ClipFileNode& src = nodes[i];
+            if (!nameOk(src.nameOffset, src.nameLength)) return false;
+            if (src.parent >= (int32_t)i || (i > 0 && src.parent < 0)) return false; // must stay topologically ordered
+            result.m_NodeNames[i].assign(strings + src.nameOffset, src.nameLength);
+            result.m_NodeParents[i] = src.parent;
+            result.m_NodeBindLocal[i] = glm::make_mat4(src.transformation);
+        }
+
+        for (uint32_t i = 0; i < header.boneInfoCount; i++) {
+            const ClipFileBoneInfo& src = boneInfos[i];
+            if (!nameOk(src.nameOffset, src.nameLength)) return false;
+            BoneInfo info;
+            info.id = src.id;
+            info.offset = glm::make_mat4(src.offset);
+            result.m_BoneInfoMap[std::string(strings + src.nameOffset, src.nameLength)] = info;
+        }
+
+        result.m_Tracks.resize(header.trackCount);
+        for (uint32_t i = 0; i < header.trackCount; i++) {
+            const ClipFileTrack& src = tracks[i];
+            if (!nameOk(src.nameOffset, src.nameLength)) return false;
+            if (!rangeOk(src.firstPosition, src.numPositions, header.positionKeyCount) ||
+                !rangeOk(src.firstRotation, src.numRotations, header.rotationKeyCount) ||
+                !rangeOk(src.firstScale, src.numScales, header.scaleKeyCount))
+                return false;
+
+            BoneTrack& track = result.m_Tracks[i];
+            track.name.assign(strings + src.nameOffset, src.nameLength);
+            track.id = src.id;
+            track.positions = { src.firstPosition, src.numPositions };
+            track.rotations = { src.firstRotation, src.numRotations };
+            track.scales = { src.firstScale, src.numScales };
+        }
+
+        result.m_PositionTimes.assign(positionTimes, positionTimes + header.positionKeyCount);
+        result.m_RotationTimes.assign(rotationTimes, rotationTimes + header.rotationKeyCount);
+        result.m_ScaleTimes.assign(scaleTimes, scaleTimes + header.scaleKeyCount);
+
+        if (compressed) {
+            result.m_Compressed = true;
+            result.m_PackedPositions.resize(header.positionKeyCount);
+            std::memcpy((void*)result.m_PackedPositions.data(), positionValues, (size_t)header.positionKeyCount * sizeof(PackedVec3));
+            result.m_PackedRotations.resize(header.rotationKeyCount);
+            std::memcpy((void*)result.m_PackedRotations.data(), rotationValues, (size_t)header.rotationKeyCount * sizeof(PackedQuat));
+            result.m_PackedScales.resize(header.scaleKeyCount);
+            std::memcpy((void*)result.m_PackedScales.data(), scaleValues, (size_t)header.scaleKeyCount * sizeof(PackedVec3));
+            result.m_PositionRanges.resize(header.trackCount);
+            std::memcpy((void*)result.m_PositionRanges.data(), positionRanges, (size_t)header.trackCount * sizeof(QuantRange));
+            result.m_ScaleRanges.resize(header.trackCount);
+            std::memcpy((void*)result.m_ScaleRanges.data(), scaleRanges, (size_t)header.trackCount * sizeof(QuantRange));
+        }
+        else {
+            result.m_PositionValues.resize(header.positionKeyCount);
+            std::memcpy((void*)result.m_PositionValues.data(), positionValues, (size_t)header.positionKeyCount * sizeof(glm::vec3));
+            result.m_RotationValues.resize(header.rotationKeyCount);
+            for (uint32_t i = 0; i < header.rotationKeyCount; i++) {
+                float q[4];
+                std::memcpy(q, rotationValues + 4 * sizeof(float) * i, sizeof(q));
+                result.m_RotationValues[i] = glm::quat(q[0], q[1], q[2], q[3]);
+            }
+            result.m_ScaleValues.resize(header.scaleKeyCount);
+            std::memcpy((void*)result.m_ScaleValues.data(), scaleValues, (size_t)header.scaleKeyCount * sizeof(glm::vec3));
+        }
+
+        result.ResolveNodes();
+        clip = std::move(result);
+        return true;
+    }
+};
+
+#endif
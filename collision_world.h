@@ -0,0 +1,519 @@
+#ifndef COLLISION_WORLD_H
+#define COLLISION_WORLD_H
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COLLISION_SSE 1
+#endif
+
+struct Aabb {
+    glm::vec3 min{ 0.0f };
+    glm::vec3 max{ 0.0f };
+
+    static Aabb FromCenter(const glm::vec3& center, const glm::vec3& halfExtents) {
+        return Aabb{ center - halfExtents, center + halfExtents };
+    }
+    bool Overlaps(const Aabb& o) const {
+        return min.x <= o.max.x && max.x >= o.min.x && min.y <= o.max.y && max.y >= o.min.y && min.z <= o.max.z && max.z >= o.min.z;
+    }
+};
+
+// Axis-aligned boxes, structure-of-arrays, padded to a multiple of 4 with empty boxes
+// (min > max) so the batch tests below always run whole SSE lanes.
+struct AabbSoA {
+    std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+    std::vector<int> ids;
+
+    int Count() const { return (int)ids.size(); }
+
+    void Add(int id, const Aabb& box) {
+        if (ids.size() == minX.size()) {
+            for (std::vector<float>* v : { &minX, &minY, &minZ }) v->insert(v->end(), 4, FLT_MAX);
+            for (std::vector<float>* v : { &maxX, &maxY, &maxZ }) v->insert(v->end(), 4, -FLT_MAX);
+        }
+        ids.push_back(id);
+        Set(Count() - 1, box);
+    }
+    void Set(int i, const Aabb& box) {
+        minX[i] = box.min.x; minY[i] = box.min.y; minZ[i] = box.min.z;
+        maxX[i] = box.max.x; maxY[i] = box.max.y; maxZ[i] = box.max.z;
+    }
+    // swap-remove; the vacated lane becomes an empty box again
+    void RemoveAt(int i) {
+        int last = Count() - 1;
+        if (i != last) {
+            ids[i] = ids[last];
+            minX[i] = minX[last]; minY[i] = minY[last]; minZ[i] = minZ[last];
+            maxX[i] = maxX[last]; maxY[i] = maxY[last]; maxZ[i] = maxZ[last];
+        }
+        ids.pop_back();
+        minX[last] = minY[last] = minZ[last] = FLT_MAX;
+        maxX[last] = maxY[last] = maxZ[last] = -FLT_MAX;
+    }
+    int Find(int id) const {
+        for (int i = 0; i < Count(); i++)
+            if (ids[i] == id) return i;
+        return -1;
+    }
+    int PaddedCount() const { return (int)minX.size(); }
+};
+
+// fn(i) for every box i in [begin, s.PaddedCount()) overlapping q; begin is a multiple of 4
+template <class F>
+inline void ForEachOverlap(const AabbSoA& s, int begin, const Aabb& q, F&& fn) {
+    const int n = s.PaddedCount();
+#ifdef COLLISION_SSE
+    const __m128 qMinX = _mm_set1_ps(q.min.x), qMinY = _mm_set1_ps(q.min.y), qMinZ = _mm_set1_ps(q.min.z);
+    const __m128 qMaxX = _mm_set1_ps(q.max.x), qMaxY = _mm_set1_ps(q.max.y), qMaxZ = _mm_set1_ps(q.max.z);
+    for (int i = begin; i < n; i += 4) {
+        __m128 m = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&s.minX[i]), qMaxX), _mm_cmpge_ps(_mm_loadu_ps(&s.maxX[i]), qMinX));
+        m = _mm_and_ps(m, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&s.minY[i]), qMaxY), _mm_cmpge_ps(_mm_loadu_ps(&s.maxY[i]), qMinY)));
+        m = _mm_and_ps(m, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&s.minZ[i]), qMaxZ), _mm_cmpge_ps(_mm_loadu_ps(&s.maxZ[i]), qMinZ)));
+        for (int bits = _mm_movemask_ps(m); bits; bits &= bits - 1) {
+            int lane = 0;
+            while (!(bits & (1 << lane))) lane++;
+            fn(i + lane);
+        }
+    }
+#else
+    for (int i = begin; i < n; i++) {
+        if (s.minX[i] <= q.max.x && s.maxX[i] >= q.min.x && s.minY[i] <= q.max.y && s.maxY[i] >= q.min.y &&
+            s.minZ[i] <= q.max.z && s.maxZ[i] >= q.min.z) fn(i);
+    }
+#endif
+}
+
+// fn(i, tEnter) for every box i the ray origin + t * dir enters within [0, tMax], each box
+// grown by `grow` on every side (a swept box is a ray against grown boxes). invDir must
+// not be infinite (see SafeInverse).
+template <class F>
+inline void ForEachRayHit(const AabbSoA& s, const glm::vec3& origin, const glm::vec3& invDir, float tMax,
+                          const glm::vec3& grow, F&& fn) {
+    const int n = s.PaddedCount();
+#ifdef COLLISION_SSE
+    const __m128 oX = _mm_set1_ps(origin.x), oY = _mm_set1_ps(origin.y), oZ = _mm_set1_ps(origin.z);
+    const __m128 iX = _mm_set1_ps(invDir.x), iY = _mm_set1_ps(invDir.y), iZ = _mm_set1_ps(invDir.z);
+    const __m128 gX = _mm_set1_ps(grow.x), gY = _mm_set1_ps(grow.y), gZ = _mm_set1_ps(grow.z);
+    const __m128 zero = _mm_setzero_ps(), limit = _mm_set1_ps(tMax);
+    for (int i = 0; i < n; i += 4) {
+        __m128 minX = _mm_sub_ps(_mm_loadu_ps(&s.minX[i]), gX), maxX = _mm_add_ps(_mm_loadu_ps(&s.maxX[i]), gX);
+        __m128 minY = _mm_sub_ps(_mm_loadu_ps(&s.minY[i]), gY), maxY = _mm_add_ps(_mm_loadu_ps(&s.maxY[i]), gY);
+        __m128 minZ = _mm_sub_ps(_mm_loadu_ps(&s.minZ[i]), gZ), maxZ = _mm_add_ps(_mm_loadu_ps(&s.maxZ[i]), gZ);
+        __m128 valid = _mm_cmple_ps(minX, maxX); // padding lanes are inverted boxes
+
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(minX, oX), iX), t2 = _mm_mul_ps(_mm_sub_ps(maxX, oX), iX);
+        __m128 tEnter = _mm_min_ps(t1, t2), tExit = _mm_max_ps(t1, t2);
+        t1 = _mm_mul_ps(_mm_sub_ps(minY, oY), iY); t2 = _mm_mul_ps(_mm_sub_ps(maxY, oY), iY);
+        tEnter = _mm_max_ps(tEnter, _mm_min_ps(t1, t2)); tExit = _mm_min_ps(tExit, _mm_max_ps(t1, t2));
+        t1 = _mm_mul_ps(_mm_sub_ps(minZ, oZ), iZ); t2 = _mm_mul_ps(_mm_sub_ps(maxZ, oZ), iZ);
+        tEnter = _mm_max_ps(tEnter, _mm_min_ps(t1, t2)); tExit = _mm_min_ps(tExit, _mm_max_ps(t1, t2));
+
+        __m128 hit = _mm_and_ps(valid, _mm_cmple_ps(tEnter, tExit));
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(tExit, zero), _mm_cmple_ps(tEnter, limit)));
+        int bits = _mm_movemask_ps(hit);
+        if (!bits) continue;
+        alignas(16) float enter[4];
+        _mm_store_ps(enter, _mm_max_ps(tEnter, zero));
+        for (int lane = 0; lane < 4; lane++)
+            if (bits & (1 << lane)) fn(i + lane, enter[lane]);
+    }
+#else
+    for (int i = 0; i < n; i++) {
+        float bmin[3] = { s.minX[i] - grow.x, s.minY[i] - grow.y, s.minZ[i] - grow.z };
+        float bmax[3] = { s.maxX[i] + grow.x, s.maxY[i] + grow.y, s.maxZ[i] + grow.z };
+        if (bmin[0] > bmax[0]) continue;
+        float tEnter = -FLT_MAX, tExit = FLT_MAX;
+        for (int a = 0; a < 3; a++) {
+            float t1 = (bmin[a] - origin[a]) * invDir[a], t2 = (bmax[a] - origin[a]) * invDir[a];
+            tEnter = std::max(tEnter, std::min(t1, t2));
+            tExit = std::min(tExit, std::max(t1, t2));
+        }
+        if (tEnter <= tExit && tExit >= 0.0f && tEnter <= tMax) fn(i, std::max(tEnter, 0.0f));
+    }
+#endif
+}
+
+// 1 / d per component, with zero components mapped to a huge finite value so slab tests
+// never compute 0 * inf
+inline glm::vec3 SafeInverse(const glm::vec3& d) {
+    auto inv = [](float v) { return (std::fabs(v) > 1e-20f) ? 1.0f / v : std::copysign(1e30f, v); };
+    return glm::vec3(inv(d.x), inv(d.y), inv(d.z));
+}
+
+struct RayHit {
+    int id = -1;
+    float t = 0.0f;        // distance along the ray (Raycast: in units of |dir|, Sweep: fraction of the move)
+    glm::vec3 point{ 0.0f };
+    glm::vec3 normal{ 0.0f };
+};
+
+// Broad phase for many hitboxes: a uniform grid over XZ (the game is ground-based, so a
+// cell is an infinite column), cells created on demand in a hash map. Each cell keeps the
+// bounds of its boxes in SoA form, so the narrow tests run 4 boxes per SSE op. A box is
+// listed in every cell it touches; boxes spanning more than MAX_CELLS_PER_BOX cells go to
+// a separate "large" list that every query tests.
+//
+// Ids are stable until Remove. Every box has a layer bit and a mask of layers it collides
+// with; a pair is reported when each one's mask has the other's layer. Queries use scratch
+// state: one thread at a time.
+class CollisionWorld {
+public:
+    static const int MAX_CELLS_PER_BOX = 64;
+
+    explicit CollisionWorld(float cellSize = 2.0f) : m_CellSize(cellSize), m_InvCellSize(1.0f / cellSize) {}
+
+    int Add(const Aabb& box, uint32_t layer = 1, uint32_t mask = ~0u) {
+        int id;
+        if (!m_FreeIds.empty()) { id = m_FreeIds.back(); m_FreeIds.pop_back(); }
+        else {
+            id = (int)m_Boxes.size();
+            m_Boxes.emplace_back();
+            m_Layer.push_back(0);
+            m_Mask.push_back(0);
+            m_Range.emplace_back();
+            m_Alive.push_back(0);
+            m_Stamp.push_back(0);
+        }
+        m_Boxes[id] = box;
+        m_Layer[id] = layer;
+        m_Mask[id] = mask;
+        m_Alive[id] = 1;
+        Insert(id);
+        m_Count++;
+        return id;
+    }
+
+    void Remove(int id) {
+        if (!IsAlive(id)) return;
+        Erase(id);
+        m_Alive[id] = 0;
+        m_FreeIds.push_back(id);
+        m_Count--;
+    }
+
+    // new bounds; only touches the grid when the box changes cells
+    void Move(int id, const Aabb& box) {
+        if (!IsAlive(id)) return;
+        CellRange range = RangeOf(box);
+        m_Boxes[id] = box;
+        if (range == m_Range[id]) {
+            ForEachCellOf(id, [&](AabbSoA& cell) { cell.Set(cell.Find(id), box); });
+            m_All.Set(id, box);
+            return;
+        }
+        Erase(id);
+        Insert(id);
+    }
+
+    bool IsAlive(int id) const { return id >= 0 && id < (int)m_Alive.size() && m_Alive[id]; }
+    const Aabb& GetBox(int id) const { return m_Boxes[id]; }
+    int GetCount() const { return m_Count; }
+    int GetCellCount() const { return (int)m_Cells.size(); }
+
+    // fn(id, box) for every box in the world
+    template <class F>
+    void ForEachBox(F&& fn) const {
+        for (int id = 0; id < (int)m_Boxes.size(); id++)
+            if (m_Alive[id]) fn(id, m_Boxes[id]);
+    }
+
+    // ids of the boxes overlapping `query` whose layer is in `mask`
+    void QueryOverlaps(const Aabb& query, std::vector<int>& out, uint32_t mask = ~0u) const {
+        out.clear();
+        uint32_t stamp = NextStamp();
+        auto visit = [&](const AabbSoA& s) {
+            ForEachOverlap(s, 0, query, [&](int i) {
+                int id = s.ids[i];
+                if ((m_Layer[id] & mask) && m_Stamp[id] != stamp) { m_Stamp[id] = stamp; out.push_back(id); }
+            });
+        };
+        visit(m_Large);
+        CellRange r = RangeOf(query);
+        if (r.Cells() > MAX_CELLS_PER_BOX * 4) { visit(m_All); return; } // huge query: one pass over everything
+        for (int cz = r.z0; cz <= r.z1; cz++)
+            for (int cx = r.x0; cx <= r.x1; cx++)
+                if (const AabbSoA* cell = FindCell(cx, cz)) visit(*cell);
+    }
+
+    // every overlapping pair (a < b) whose layers / masks match
+    void FindPairs(std::vector<std::pair<int, int>>& out) const {
+        out.clear();
+        auto report = [&](int a, int b) {
+            if ((m_Mask[a] & m_Layer[b]) && (m_Mask[b] & m_Layer[a])) out.emplace_back(std::min(a, b), std::max(a, b));
+        };
+        for (const auto& entry : m_CellLookup) {
+            const AabbSoA& cell = m_Cells[entry.second];
+            int cx = (int)(int32_t)(entry.first >> 32), cz = (int)(int32_t)(entry.first & 0xffffffffu);
+            for (int i = 0; i < cell.Count(); i++) {
+                int a = cell.ids[i];
+                const Aabb& boxA = m_Boxes[a];
+                ForEachOverlap(cell, (i + 1) & ~3, boxA, [&](int j) {
+                    if (j <= i) return;
+                    int b = cell.ids[j];
+                    // a pair shared by several cells is reported by the one holding the
+                    // min corner of the overlap
+                    const Aabb& boxB = m_Boxes[b];
+                    if (CellCoord(std::max(boxA.min.x, boxB.min.x)) != cx || CellCoord(std::max(boxA.min.z, boxB.min.z)) != cz) return;
+                    report(a, b);
+                });
+            }
+        }
+        // large boxes against everything (including each other, once)
+        for (int i = 0; i < m_Large.Count(); i++) {
+            int a = m_Large.ids[i];
+            ForEachOverlap(m_All, 0, m_Boxes[a], [&](int b) {
+                if (b == a || !m_Alive[b]) return;
+                if (IsLarge(b) && b < a) return;
+                report(a, b);
+            });
+        }
+    }
+
+    // nearest box hit by origin + t * dir, t in [0, maxT] (|dir| need not be 1)
+    bool Raycast(const glm::vec3& origin, const glm::vec3& dir, float maxT, RayHit& hit, uint32_t mask = ~0u) const {
+        hit = RayHit();
+        hit.t = maxT;
+        const glm::vec3 invDir = SafeInverse(dir);
+        const glm::vec3 noGrow(0.0f);
+        auto visit = [&](const AabbSoA& s) {
+            ForEachRayHit(s, origin, invDir, hit.t, noGrow, [&](int i, float t) {
+                int id = s.ids[i];
+                if ((m_Layer[id] & mask) && t <= hit.t) { hit.t = t; hit.id = id; }
+            });
+        };
+        visit(m_Large);
+
+        // 2D DDA over the XZ cells the ray crosses, front to back; stop once the best hit is
+        // nearer than the current cell's exit
+        int cx = CellCoord(origin.x), cz = CellCoord(origin.z);
+        int stepX = dir.x > 0.0f ? 1 : -1, stepZ = dir.z > 0.0f ? 1 : -1;
+        float nextX = (cx + (stepX > 0 ? 1 : 0)) * m_CellSize, nextZ = (cz + (stepZ > 0 ? 1 : 0)) * m_CellSize;
+        float tNextX = (std::fabs(dir.x) > 1e-20f) ? (nextX - origin.x) * invDir.x : FLT_MAX;
+        float tNextZ = (std::fabs(dir.z) > 1e-20f) ? (nextZ - origin.z) * invDir.z : FLT_MAX;
+        float tDeltaX = (std::fabs(dir.x) > 1e-20f) ? m_CellSize * std::fabs(invDir.x) : FLT_MAX;
+        float tDeltaZ = (std::fabs(dir.z) > 1e-20f) ? m_CellSize * std::fabs(invDir.z) : FLT_MAX;
+        for (int steps = 0; steps < 1 << 20; steps++) {
+            if (const AabbSoA* cell = FindCell(cx, cz)) visit(*cell);
+            float tExit = std::min(tNextX, tNextZ);
+            if (tExit > hit.t || tExit > maxT) break;
+            if (tNextX < tNextZ) { cx += stepX; tNextX += tDeltaX; }
+            else { cz += stepZ; tNextZ += tDeltaZ; }
+        }
+        if (hit.id < 0) return false;
+        FinishHit(origin, dir, glm::vec3(0.0f), hit);
+        return true;
+    }
+
+    // First contact of a box with half extents `halfExtents` moving its centre from `from`
+    // to `to`; hit.t is the fraction of the move. Boxes already overlapping at the start
+    // (and `ignoreId`) don't count.
+    bool Sweep(const glm::vec3& halfExtents, const glm::vec3& from, const glm::vec3& to, RayHit& hit,
+               uint32_t mask = ~0u, int ignoreId = -1) const {
+        hit = RayHit();
+        hit.t = 1.0f;
+        Aabb start = Aabb::FromCenter(from, halfExtents), end = Aabb::FromCenter(to, halfExtents);
+        Aabb swept{ glm::min(start.min, end.min), glm::max(start.max, end.max) };
+        QueryOverlaps(swept, m_Scratch, mask);
+        if (m_Scratch.empty()) return false;
+
+        const glm::vec3 dir = to - from, invDir = SafeInverse(dir);
+        for (int id : m_Scratch) {
+            if (id == ignoreId || m_Boxes[id].Overlaps(start)) continue;
+            m_Single.ids.clear();
+            m_Single.minX.clear(); m_Single.minY.clear(); m_Single.minZ.clear();
+            m_Single.maxX.clear(); m_Single.maxY.clear(); m_Single.maxZ.clear();
+            m_Single.Add(id, m_Boxes[id]);
+            ForEachRayHit(m_Single, from, invDir, hit.t, halfExtents, [&](int, float t) {
+                if (t <= hit.t) { hit.t = t; hit.id = id; }
+            });
+        }
+        if (hit.id < 0) return false;
+        FinishHit(from, dir, halfExtents, hit);
+        return true;
+    }
+
+private:
+    struct CellRange {
+        int x0 = 0, z0 = 0, x1 = -1, z1 = -1;
+        bool operator==(const CellRange& o) const { return x0 == o.x0 && z0 == o.z0 && x1 == o.x1 && z1 == o.z1; }
+        int Cells() const { return (x1 - x0 + 1) * (z1 - z0 + 1); }
+    };
+
+    int CellCoord(float v) const { return (int)std::floor(v * m_InvCellSize); }
+    CellRange RangeOf(const Aabb& b) const {
+        return CellRange{ CellCoord(b.min.x), CellCoord(b.min.z), CellCoord(b.max.x), CellCoord(b.max.z) };
+    }
+    static uint64_t CellKey(int cx, int cz) { return ((uint64_t)(uint32_t)cx << 32) | (uint32_t)cz; }
+    bool IsLarge(int id) const { return m_Range[id].Cells() > MAX_CELLS_PER_BOX; }
+
+    const AabbSoA* FindCell(int cx, int cz) const {
+        auto it = m_CellLookup.find(CellKey(cx, cz));
+        return (it != m_CellLookup.end()) ? &m_Cells[it->second] : nullptr;
+    }
+    AabbSoA& GetCell(int cx, int cz) {
+        auto it = m_CellLookup.find(CellKey(cx, cz));
+        if (it != m_CellLookup.end()) return m_Cells[it->second];
+        m_CellLookup.emplace(CellKey(cx, cz), (int)m_Cells.size());
+        m_Cells.emplace_back();
+        return m_Cells.back();
+    }
+
+    template <class F>
+    void ForEachCellOf(int id, F&& fn) {
+        if (IsLarge(id)) { fn(m_Large); return; }
+        const CellRange& r = m_Range[id];
+        for (int cz = r.z0; cz <= r.z1; cz++)
+            for (int cx = r.x0; cx <= r.x1; cx++) fn(GetCell(cx, cz));
+    }
+
+    void Insert(int id) {
+        m_Range[id] = RangeOf(m_Boxes[id]);
+        ForEachCellOf(id, [&](AabbSoA& cell) { cell.Add(id, m_Boxes[id]); });
+        while (m_All.Count() <= id) m_All.Add(-1, Aabb{ glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) });
+        m_All.ids[id] = id;
+        m_All.Set(id, m_Boxes[id]);
+    }
+
+    void Erase(int id) {
+        ForEachCellOf(id, [&](AabbSoA& cell) {
+            int i = cell.Find(id);
+            if (i >= 0) cell.RemoveAt(i);
+        });
+        m_All.Set(id, Aabb{ glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) });
+    }
+
+    // contact point and face normal of a hit found by the batch tests
+    void FinishHit(const glm::vec3& origin, const glm::vec3& dir, const glm::vec3& grow, RayHit& hit) const {
+        const Aabb& b = m_Boxes[hit.id];
+        hit.point = origin + dir * hit.t;
+        int axis = 0;
+        float best = -FLT_MAX;
+        for (int a = 0; a < 3; a++) {
+            if (std::fabs(dir[a]) < 1e-20f) continue;
+            float plane = (dir[a] > 0.0f) ? b.min[a] - grow[a] : b.max[a] + grow[a];
+            float t = (plane - origin[a]) / dir[a];
+            if (t > best) { best = t; axis = a; }
+        }
+        hit.normal = glm::vec3(0.0f);
+        hit.normal[axis] = (dir[axis] > 0.0f) ? -1.0f : 1.0f;
+    }
+
+    uint32_t NextStamp() const {
+        if (++m_QueryStamp == 0) { std::fill(m_Stamp.begin(), m_Stamp.end(), 0u); m_QueryStamp = 1; }
+        return m_QueryStamp;
+    }
+
+    float m_CellSize, m_InvCellSize;
+    std::vector<Aabb> m_Boxes; // by id
+    std::vector<uint32_t> m_Layer, m_Mask;
+    std::vector<CellRange> m_Range;
+    std::vector<uint8_t> m_Alive;
+    std::vector<int> m_FreeIds;
+    int m_Count = 0;
+
+    std::unordered_map<uint64_t, int> m_CellLookup; // (cx, cz) -> m_Cells
+    std::vector<AabbSoA> m_Cells;
+    AabbSoA m_Large; // boxes over MAX_CELLS_PER_BOX cells
+    AabbSoA m_All;   // every id's box (empty if removed), lane = id
+
+    // query scratch
+    mutable std::vector<uint32_t> m_Stamp; // by id, dedups boxes listed in several cells
+    mutable uint32_t m_QueryStamp = 0;
+    mutable std::vector<int> m_Scratch;
+    mutable AabbSoA m_Single;
+};
+
+// Broad-phase cost from 10 to 100k boxes (skeletal_animation --bench-collision): boxes of
+// 0.3-1.5 m scattered at constant density (~1 per 8 m^2, like a busy scene), every one moved
+// each frame. Brute-force all-pairs is shown up to 10k boxes for comparison.
+inline void BenchCollisionWorld(std::ostream& os = std::cout) {
+    using Clock = std::chrono::steady_clock;
+    auto us = [](Clock::time_point a, Clock::time_point b) { return std::chrono::duration<double, std::micro>(b - a).count(); };
+    const int QUERIES = 1000;
+
+    os << "---- collision broad phase, us (queries: per 1000) ----\n";
+    os << std::setw(8) << "boxes" << std::setw(10) << "build" << std::setw(10) << "move all" << std::setw(10) << "pairs"
+       << std::setw(8) << "found" << std::setw(12) << "brute pairs" << std::setw(10) << "overlap" << std::setw(10) << "raycast"
+       << std::setw(10) << "sweep" << "\n";
+
+    for (int count = 10; count <= 100000; count *= 10) {
+        std::mt19937 rng(42);
+        float side = std::sqrt(8.0f * count);
+        std::uniform_real_distribution<float> pos(0.0f, side), size(0.15f, 0.75f), unit(-1.0f, 1.0f);
+        std::vector<Aabb> boxes(count);
+        for (Aabb& b : boxes) {
+            glm::vec3 c(pos(rng), size(rng), pos(rng));
+            b = Aabb::FromCenter(c, glm::vec3(size(rng), size(rng) * 2.0f, size(rng)));
+        }
+
+        CollisionWorld world(2.0f);
+        auto t0 = Clock::now();
+        std::vector<int> ids(count);
+        for (int i = 0; i < count; i++) ids[i] = world.Add(boxes[i]);
+        auto t1 = Clock::now();
+        for (int i = 0; i < count; i++) {
+            glm::vec3 step(unit(rng) * 0.05f, 0.0f, unit(rng) * 0.05f); // ~3 m/s at 60 Hz
+            boxes[i].min += step; boxes[i].max += step;
+        }
+        auto t2 = Clock::now();
+        for (int i = 0; i < count; i++) world.Move(ids[i], boxes[i]);
+        auto t3 = Clock::now();
+        std::vector<std::pair<int, int>> pairs;
+        world.FindPairs(pairs);
+        auto t4 = Clock::now();
+
+        double brute = -1.0;
+        if (count <= 10000) {
+            size_t found = 0;
+            auto b0 = Clock::now();
+            for (int i = 0; i < count; i++)
+                for (int j = i + 1; j < count; j++) found += boxes[i].Overlaps(boxes[j]);
+            brute = us(b0, Clock::now());
+            if (found != pairs.size()) os << "  (mismatch: grid " << pairs.size() << ", brute " << found << ")\n";
+        }
+
+        std::vector<int> hits;
+        size_t sink = 0;
+        auto q0 = Clock::now();
+        for (int q = 0; q < QUERIES; q++) {
+            glm::vec3 c(pos(rng), 1.0f, pos(rng));
+            world.QueryOverlaps(Aabb::FromCenter(c, glm::vec3(1.0f)), hits);
+            sink += hits.size();
+        }
+        auto q1 = Clock::now();
+        RayHit hit;
+        for (int q = 0; q < QUERIES; q++) {
+            glm::vec3 o(pos(rng), 0.5f, pos(rng)), d(unit(rng), 0.0f, unit(rng));
+            sink += world.Raycast(o, d, 20.0f, hit);
+        }
+        auto q2 = Clock::now();
+        for (int q = 0; q < QUERIES; q++) {
+            glm::vec3 from(pos(rng), 1.0f, pos(rng)), to = from + glm::vec3(unit(rng), 0.0f, unit(rng)) * 0.5f;
+            sink += world.Sweep(glm::vec3(0.3f, 1.0f, 0.3f), from, to, hit);
+        }
+        auto q3 = Clock::now();
+
+        os << std::fixed << std::setprecision(1) << std::setw(8) << count << std::setw(10) << us(t0, t1)
+           << std::setw(10) << us(t2, t3) << std::setw(10) << us(t3, t4) << std::setw(8) << pairs.size()
+           << std::setw(12);
+        if (brute >= 0.0) os << brute; else os << "-";
+        os << std::setw(10) << us(q0, q1) << std::setw(10) << us(q1, q2) << std::setw(10) << us(q2, q3) << "\n";
+        (void)sink;
+    }
+}
+
+#endif
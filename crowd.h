@@ -0,0 +1,358 @@
+#ifndef CROWD_H
+#define CROWD_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/shader_m.h>
+#include <learnopengl/model_animation.h>
+
+#include "animation_clip.h"
+#include "clip_animator.h"
+#include "job_system.h"
+#include "anim_lod.h"
+#include "mesh_culling.h"
+#include "baked_palette.h"
+
+// A crowd of background knights sharing the player's Model, each with its own looping clip
+// and phase. Every frame the simulation Packs each visible agent's block into the frame
+// packet (frame_packet.h), and the render thread uploads it to the bone palette TBO as is:
+//
+//   [base + i * stride]     model matrix of agent i
+//   [base + i * stride + 1] its bone palette (boneCount matrices)
+//
+// Draw then issues each mesh once with glDrawElementsInstanced; anim_model.vs finds its
+// block from gl_InstanceID (uniform instanceStride). Plain GL 3.3, so it runs on llvmpipe
+// too. With instancing off every agent gets its own draw calls, for comparison.
+//
+// Agents are animated through an AnimLodPolicy (anim_lod.h) against the camera set with
+// SetLodView: off-screen agents only advance their clip time and aren't uploaded or
+// drawn, far ones are evaluated less often and less deep.
+//
+// With SetBaked every agent plays its clip from a BakedPalettes texture instead: the update
+// only advances clocks (and culls), and a block shrinks to the model matrix plus one
+// playback matrix that anim_model.vs resolves (uniform bakedInstances).
+struct CrowdAgent {
+    glm::vec3 pos{ 0.0f };
+    float yawDeg = 0.0f;
+    ClipAnimator animator;
+
+    // animation LOD state
+    int lod = -1;             // -1: culled (or not evaluated yet)
+    float sinceUpdate = 0.0f; // seconds since the pose was last evaluated
+    float interval = 0.0f;    // seconds between evaluations at this level, 0 = every frame
+    bool blend = false;       // prevPalette holds the pose before the last evaluation
+    int bonesEvaluated = 0;   // this frame
+    int bakedClip = -1;       // its clip in the crowd's BakedPalettes, with SetBaked
+    std::vector<glm::mat4> prevPalette;
+
+    CrowdAgent(const AnimationClip* clip) : animator(clip) {}
+};
+
+class Crowd {
+public:
+    // `count` agents on a square grid starting at `origin` (+x, +z), clips and phases drawn
+    // from a fixed seed so runs are comparable
+    Crowd(const std::vector<const AnimationClip*>& clips, int boneCount, int count,
+          glm::vec3 origin, float spacing = 1.6f, unsigned seed = 1234) {
+        m_BoneCount = boneCount;
+        for (const AnimationClip* clip : clips)
+            if (clip) m_BoneCount = std::max(m_BoneCount, clip->GetBoneCount());
+
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> pickClip(0, std::max(0, (int)clips.size() - 1));
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        int side = std::max(1, (int)std::ceil(std::sqrt((float)count)));
+
+        m_Agents.reserve(count);
+        for (int i = 0; i < count; i++) {
+            const AnimationClip* clip = clips.empty() ? nullptr : clips[pickClip(rng)];
+            m_Agents.emplace_back(clip);
+            CrowdAgent& agent = m_Agents.back();
+            agent.pos = origin + glm::vec3((i % side) * spacing, 0.0f, (i / side) * spacing);
+            agent.yawDeg = unit(rng) * 360.0f;
+            if (clip) agent.animator.SetClipTime(unit(rng) * clip->GetDuration());
+            agent.prevPalette.assign(m_BoneCount, glm::mat4(1.0f));
+        }
+        m_Active = count;
+    }
+
+    // matrices one frame of `count` agents needs in the palette buffer
+    static int PaletteMatricesFor(int count, int boneCount) { return count * (boneCount + 1); }
+
+    void SetActiveCount(int n) { m_Active = std::max(0, std::min(n, (int)m_Agents.size())); }
+    int GetActiveCount() const { return m_Active; }
+    int GetCount() const { return (int)m_Agents.size(); }
+    int GetBoneCount() const { return m_BoneCount; }
+    const glm::vec3& GetAgentPos(int i) const { return m_Agents[i].pos; }
+    // stand every agent on the ground: heightAt(x, z) -> y
+    template <class F>
+    void PlaceOnGround(F&& heightAt) {
+        for (CrowdAgent& agent : m_Agents) agent.pos.y = heightAt(agent.pos.x, agent.pos.z);
+    }
+    int GetStride() const { return m_Baked ? 2 : m_BoneCount + 1; }
+
+    // Play every agent from `baked` (nullptr: back to live poses). Fails, changing nothing,
+    // if an agent's clip isn't in it or the bone counts differ.
+    bool SetBaked(const BakedPalettes* baked) {
+        if (baked) {
+            if (!baked->IsValid() || baked->GetBoneCount() != m_BoneCount) return false;
+            for (const CrowdAgent& agent : m_Agents)
+                if (baked->Find(agent.animator.GetCurrentClip()) < 0) return false;
+        }
+        m_Baked = baked;
+        for (CrowdAgent& agent : m_Agents) {
+            agent.bakedClip = baked ? baked->Find(agent.animator.GetCurrentClip()) : -1;
+            agent.lod = -1; // live poses are stale either way: re-evaluated on the next update
+        }
+        return true;
+    }
+    const BakedPalettes* GetBaked() const { return m_Baked; }
+
+    AnimLodPolicy& GetLodPolicy() { return m_LodPolicy; }
+    // camera for the next update's LOD selection and culling
+    void SetLodView(const AnimLodView& view) { m_LodView = view; }
+
+    void Update(float dt) {
+        for (int i = 0; i < m_Active; i++)
+            UpdateAgent(m_Agents[i], dt);
+    }
+
+    // Update on `jobs`, `grain` agents per job; the poses are ready once `done` is.
+    void UpdateAsync(float dt, JobSystem& jobs, JobCounter& done, int grain = 8) {
+        m_UpdateDt = dt;
+        for (int begin = 0; begin < m_Active; begin += grain)
+            jobs.Kick(&UpdateAgents, this, begin, std::min(m_Active, begin + grain), done);
+    }
+
+    // The block of every visible active agent into `blocks`, packed; safe off the GL thread.
+    // Uploaded as is and drawn with Draw(..., count, ...). Returns the count.
+    int Pack(std::vector<glm::mat4>& blocks) const {
+        int visible = GetVisibleCount();
+        blocks.resize((size_t)visible * GetStride());
+        if (visible > 0) WriteBlocks(blocks.data());
+        return visible;
+    }
+
+    int GetVisibleCount() const {
+        int visible = 0;
+        for (int i = 0; i < m_Active; i++)
+            if (m_Agents[i].lod >= 0) visible++;
+        return visible;
+    }
+
+    // what Draw issues for `count` agents
+    static int DrawCallsFor(const Model& model, int count, bool instanced) {
+        return count == 0 ? 0 : (int)model.meshes.size() * (instanced ? 1 : count);
+    }
+
+    // Add this frame's LOD counters for the active agents (after the update's barrier)
+    void GatherLodStats(AnimLodStats& stats) const {
+        for (int i = 0; i < m_Active; i++) {
+            const CrowdAgent& agent = m_Agents[i];
+            if (agent.lod < 0) stats.culled++;
+            else stats.characters[agent.lod]++;
+            if (agent.bonesEvaluated > 0) stats.updated++;
+            stats.bonesEvaluated += agent.bonesEvaluated;
+            if (const AnimationClip* clip = agent.animator.GetCurrentClip()) stats.bonesFull += clip->GetNodeCount();
+        }
+    }
+
+    // Add the meshes of this frame's agents: drawn ones as submitted, culled ones as culled
+    void GatherCullStats(const ModelCuller& culler, MeshCullStats& stats) const {
+        int triangles = 0;
+        for (int m = 0; m < culler.GetMeshCount(); m++) triangles += culler.GetBounds(m).triangles;
+        int culled = 0;
+        for (int i = 0; i < m_Active; i++)
+            if (m_Agents[i].lod < 0) culled++;
+        stats.meshes += (m_Active - culled) * culler.GetMeshCount();
+        stats.triangles += (m_Active - culled) * triangles;
+        stats.meshesCulled += culled * culler.GetMeshCount();
+        stats.trianglesCulled += culled * triangles;
+    }
+
+    // Draw `count` packed blocks from `base` (a Pack uploaded as is; projection/view already
+    // set on the shader). Returns the number of draw calls issued.
+    int Draw(Model& model, Shader& shader, int base, int count, bool instanced) const {
+        if (base < 0 || count == 0) return 0;
+        const int stride = GetStride();
+        shader.use();
+        shader.setInt("boneCount", m_BoneCount);
+        shader.setInt("instanceStride", stride);
+        shader.setInt("bakedInstances", m_Baked ? 1 : 0);
+
+        int draws = 0;
+        for (Mesh& mesh : model.meshes) {
+            BindMeshTextures(mesh, shader);
+            glBindVertexArray(mesh.VAO);
+            if (instanced) {
+                shader.setInt("bonePaletteBase", base);
+                glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)mesh.indices.size(), GL_UNSIGNED_INT, 0, count);
+                draws++;
+            }
+            else {
+                for (int i = 0; i < count; i++) {
+                    shader.setInt("bonePaletteBase", base + i * stride);
+                    glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)mesh.indices.size(), GL_UNSIGNED_INT, 0, 1);
+                    draws++;
+                }
+            }
+        }
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+
+        shader.setInt("instanceStride", 0);
+        shader.setInt("bakedInstances", 0);
+        return draws;
+    }
+
+private:
+    // model matrix + palette per visible agent, GetStride() matrices each
+    void WriteBlocks(glm::mat4* dst) const {
+        const int stride = GetStride();
+        for (int i = 0; i < m_Active; i++) {
+            const CrowdAgent& agent = m_Agents[i];
+            if (agent.lod < 0) continue;
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), agent.pos);
+            dst[0] = glm::rotate(model, glm::radians(agent.yawDeg), glm::vec3(0, 1, 0));
+            if (m_Baked) {
+                dst[1] = m_Baked->Playback(agent.bakedClip, agent.animator.GetClipTime());
+                dst += stride;
+                continue;
+            }
+
+            // clips bound later may have added bones; pad short palettes with identity
+            const std::vector<glm::mat4>& bones = agent.animator.GetFinalBoneMatrices();
+            int n = std::min((int)bones.size(), m_BoneCount);
+            float t = (agent.blend && agent.interval > 0.0f) ? std::min(agent.sinceUpdate / agent.interval, 1.0f) : 1.0f;
+            if (t < 1.0f) {
+                // between reduced-rate updates: previous pose -> latest, one interval behind
+                for (int b = 0; b < n; b++)
+                    dst[1 + b] = agent.prevPalette[b] + (bones[b] - agent.prevPalette[b]) * t;
+            }
+            else {
+                std::copy(bones.begin(), bones.begin() + n, dst + 1);
+            }
+            std::fill(dst + 1 + n, dst + stride, glm::mat4(1.0f));
+            dst += stride;
+        }
+    }
+
+    static void UpdateAgents(void* ctx, int begin, int end) {
+        Crowd* self = static_cast<Crowd*>(ctx);
+        for (int i = begin; i < end; i++)
+            self->UpdateAgent(self->m_Agents[i], self->m_UpdateDt);
+    }
+
+    void UpdateAgent(CrowdAgent& agent, float dt) const {
+        agent.bonesEvaluated = 0;
+        int lod = SelectAnimLod(m_LodPolicy, m_LodView, agent.pos);
+        if (lod < 0) {
+            agent.animator.AdvanceTime(dt); // keep the clock, skip the pose
+            agent.lod = -1;
+            agent.sinceUpdate = 0.0f;
+            agent.blend = false;
+            return;
+        }
+
+        if (m_Baked) { // the pose comes from the texture: the clock is all there is to update
+            agent.animator.AdvanceTime(dt);
+            agent.lod = lod;
+            agent.blend = false;
+            return;
+        }
+
+        const AnimLodLevel& level = m_LodPolicy.levels[lod];
+        bool stale = agent.lod < 0; // just came into view: evaluate now, nothing to blend from
+        agent.lod = lod;
+        agent.interval = (level.updateHz > 0.0f) ? 1.0f / level.updateHz : 0.0f;
+        agent.sinceUpdate += dt;
+        if (!stale && agent.sinceUpdate < agent.interval) return;
+
+        agent.blend = !stale && agent.interval > 0.0f;
+        if (agent.blend) {
+            const std::vector<glm::mat4>& bones = agent.animator.GetFinalBoneMatrices();
+            std::copy(bones.begin(), bones.begin() + std::min((int)bones.size(), m_BoneCount), agent.prevPalette.begin());
+        }
+        agent.animator.AdvanceTime(agent.sinceUpdate);
+        agent.bonesEvaluated = agent.animator.EvaluatePose(level.maxDepth);
+        agent.sinceUpdate = 0.0f;
+    }
+
+    std::vector<CrowdAgent> m_Agents;
+    int m_BoneCount = 0;
+    int m_Active = 0;
+    float m_UpdateDt = 0.0f;
+    AnimLodPolicy m_LodPolicy;
+    AnimLodView m_LodView;
+    const BakedPalettes* m_Baked = nullptr;
+};
+
+// Frame time as the crowd grows (skeletal_animation --crowd N --crowd-ramp): the active
+// count doubles from 1 up to the crowd size, each step held for `stepSeconds` (the first
+// quarter second of a step is discarded as warm-up), and one row is printed per step.
+class CrowdRamp {
+public:
+    CrowdRamp(Crowd& crowd, float stepSeconds = 3.0f, std::ostream& os = std::cout)
+        : m_Crowd(crowd), m_StepSeconds(stepSeconds), m_Os(os) {
+        m_Crowd.SetActiveCount(1);
+        m_Os << "---- crowd ramp (" << stepSeconds << " s per step) ----\n";
+        m_Os << std::setw(8) << "agents" << std::setw(8) << "draws" << std::setw(12) << "frame ms"
+             << std::setw(12) << "worst ms" << std::setw(12) << "anim ms" << std::setw(10) << "fps" << "\n";
+    }
+
+    bool IsDone() const { return m_Done; }
+
+    // once per frame: wall frame time, animation update (to the barrier) + upload, draws issued
+    void Frame(float frameSeconds, float animSeconds, int draws) {
+        if (m_Done) return;
+        m_Elapsed += frameSeconds;
+        if (m_Elapsed > WARMUP) {
+            m_Frames++;
+            m_FrameSum += frameSeconds;
+            m_AnimSum += animSeconds;
+            m_Worst = std::max(m_Worst, frameSeconds);
+            m_Draws = draws;
+        }
+        if (m_Elapsed < m_StepSeconds || m_Frames == 0) return;
+
+        double frameMs = 1000.0 * m_FrameSum / m_Frames;
+        m_Os << std::setw(8) << m_Crowd.GetActiveCount() << std::setw(8) << m_Draws << std::fixed << std::setprecision(2)
+             << std::setw(12) << frameMs << std::setw(12) << 1000.0 * m_Worst
+             << std::setw(12) << 1000.0 * m_AnimSum / m_Frames << std::setprecision(1)
+             << std::setw(10) << (frameMs > 0.0 ? 1000.0 / frameMs : 0.0) << "\n" << std::flush;
+
+        int active = m_Crowd.GetActiveCount();
+        if (active >= m_Crowd.GetCount()) { m_Done = true; return; }
+        m_Crowd.SetActiveCount(std::min(active * 2, m_Crowd.GetCount()));
+        m_Elapsed = 0.0f;
+        m_Frames = 0;
+        m_FrameSum = m_AnimSum = 0.0;
+        m_Worst = 0.0f;
+    }
+
+private:
+    static constexpr float WARMUP = 0.25f;
+
+    Crowd& m_Crowd;
+    float m_StepSeconds;
+    std::ostream& m_Os;
+    float m_Elapsed = 0.0f;
+    int m_Frames = 0;
+    double m_FrameSum = 0.0, m_AnimSum = 0.0;
+    float m_Worst = 0.0f;
+    int m_Draws = 0;
+    bool m_Done = false;
+};
+
+#endif
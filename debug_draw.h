@@ -0,0 +1,238 @@
+#ifndef DEBUG_DRAW_H
+#define DEBUG_DRAW_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_m.h>
+
+#include "collision_world.h"
+#include "bone_hitbox.h"
+
+// RGBA8, as the vertex colour attribute reads it
+inline uint32_t DebugColor(float r, float g, float b, float a = 1.0f) {
+    auto c = [](float v) { return (uint32_t)std::lround(std::min(std::max(v, 0.0f), 1.0f) * 255.0f); };
+    return c(r) | (c(g) << 8) | (c(b) << 16) | (c(a) << 24);
+}
+
+struct DebugVertex {
+    glm::vec3 pos;
+    uint32_t color;
+};
+
+// Boxes, capsules, skeletons and frustums as line lists, for anything with an
+// AddLine(a, b, color): DebugDraw on the GL thread, DebugLineList anywhere else.
+template<class Derived>
+class DebugShapes {
+public:
+    void AddBox(const Aabb& box, uint32_t color) {
+        glm::vec3 c[8];
+        for (int i = 0; i < 8; i++)
+            c[i] = glm::vec3((i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y, (i & 4) ? box.max.z : box.min.z);
+        AddEdges(c, color);
+    }
+
+    // corners: bit 0 = +x, bit 1 = +y, bit 2 = +z
+    void AddEdges(const glm::vec3 c[8], uint32_t color) {
+        static const int EDGES[24] = { 0,1, 2,3, 4,5, 6,7, 0,2, 1,3, 4,6, 5,7, 0,4, 1,5, 2,6, 3,7 };
+        for (int e = 0; e < 24; e += 2) Line(c[EDGES[e]], c[EDGES[e + 1]], color);
+    }
+
+    // two rings at the ends, four side lines and a half ring over each cap
+    void AddCapsule(const Capsule& capsule, uint32_t color, int segments = 12) {
+        glm::vec3 axis = capsule.b - capsule.a;
+        float len = glm::length(axis);
+        glm::vec3 dir = (len > 1e-6f) ? axis / len : glm::vec3(0, 1, 0);
+        glm::vec3 u = glm::normalize(glm::cross(dir, std::fabs(dir.y) < 0.9f ? glm::vec3(0, 1, 0) : glm::vec3(1, 0, 0)));
+        glm::vec3 v = glm::cross(dir, u);
+        const float r = capsule.radius, step = 6.2831853f / segments;
+        for (int i = 0; i < segments; i++) {
+            float a0 = i * step, a1 = a0 + step;
+            glm::vec3 p0 = (u * std::cos(a0) + v * std::sin(a0)) * r, p1 = (u * std::cos(a1) + v * std::sin(a1)) * r;
+            Line(capsule.a + p0, capsule.a + p1, color);
+            Line(capsule.b + p0, capsule.b + p1, color);
+        }
+        for (const glm::vec3& side : { u, v }) {
+            Line(capsule.a + side * r, capsule.b + side * r, color);
+            Line(capsule.a - side * r, capsule.b - side * r, color);
+            for (int i = 0; i < segments / 2; i++) {
+                float a0 = i * step, a1 = a0 + step;
+                Line(capsule.b + (side * std::cos(a0) + dir * std::sin(a0)) * r, capsule.b + (side * std::cos(a1) + dir * std::sin(a1)) * r, color);
+                Line(capsule.a + (side * std::cos(a0) - dir * std::sin(a0)) * r, capsule.a + (side * std::cos(a1) - dir * std::sin(a1)) * r, color);
+            }
+        }
+    }
+
+    // a line from every node to its parent; `globals` in model space, parents from the clip
+    void AddSkeleton(const std::vector<glm::mat4>& globals, const std::vector<int>& parents, const glm::mat4& model, uint32_t color) {
+        int count = (int)std::min(globals.size(), parents.size());
+        for (int i = 0; i < count; i++) {
+            if (parents[i] < 0) continue;
+            Line(glm::vec3(model * globals[parents[i]][3]), glm::vec3(model * globals[i][3]), color);
+        }
+    }
+
+    // the volume a camera sees, from its projection * view
+    void AddFrustum(const glm::mat4& viewProjection, uint32_t color) {
+        glm::mat4 inv = glm::inverse(viewProjection);
+        glm::vec3 c[8];
+        for (int i = 0; i < 8; i++) {
+            glm::vec4 p = inv * glm::vec4((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 1.0f);
+            c[i] = glm::vec3(p) / p.w;
+        }
+        AddEdges(c, color);
+    }
+
+private:
+    void Line(const glm::vec3& a, const glm::vec3& b, uint32_t color) { static_cast<Derived*>(this)->AddLine(a, b, color); }
+};
+
+// Lines collected off the GL thread (a simulation frame), drawn later with DebugDraw::AddLines.
+class DebugLineList : public DebugShapes<DebugLineList> {
+public:
+    void AddLine(const glm::vec3& a, const glm::vec3& b, uint32_t color) {
+        m_Vertices.push_back({ a, color });
+        m_Vertices.push_back({ b, color });
+    }
+
+    void Clear() { m_Vertices.clear(); } // keeps the capacity: no allocation once warmed up
+    const std::vector<DebugVertex>& GetVertices() const { return m_Vertices; }
+
+private:
+    std::vector<DebugVertex> m_Vertices;
+};
+
+// Immediate-mode debug lines. Anything on the GL thread may add lines, boxes, capsules,
+// skeletons and frustums during the frame; Flush draws the lot with one glDrawArrays.
+//
+// Vertices are written straight into a streaming vertex buffer, a ring of FRAMES regions
+// guarded by fences like the bone palette (bone_palette.h): mapped once, persistently, with
+// ARB_buffer_storage; otherwise staged in memory and copied into the region at Flush. Lines
+// past a frame's capacity are dropped and counted.
+class DebugDraw : public DebugShapes<DebugDraw> {
+public:
+    static const int FRAMES = 3;
+
+    explicit DebugDraw(int maxVerticesPerFrame = 1 << 17) : m_Shader("debug_draw.vs", "debug_draw.fs") {
+        m_Capacity = maxVerticesPerFrame & ~1; // whole lines
+        GLsizeiptr bytes = (GLsizeiptr)m_Capacity * FRAMES * sizeof(DebugVertex);
+
+        glGenVertexArrays(1, &m_VAO);
+        glGenBuffers(1, &m_Buffer);
+        glBindVertexArray(m_VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_Buffer);
+#ifdef GL_ARB_buffer_storage
+        if (GLAD_GL_ARB_buffer_storage) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_ARRAY_BUFFER, bytes, nullptr, flags);
+            m_Persistent = (DebugVertex*)glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, flags);
+        }
+#endif
+        if (!m_Persistent) {
+            glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+            m_Staging.resize(m_Capacity);
+        }
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DebugVertex), (void*)offsetof(DebugVertex, color));
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        m_Write = m_Persistent ? m_Persistent : m_Staging.data();
+    }
+
+    ~DebugDraw() {
+        for (GLsync& fence : m_Fences) {
+            if (fence) glDeleteSync(fence);
+        }
+        if (m_Persistent) {
+            glBindBuffer(GL_ARRAY_BUFFER, m_Buffer);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &m_Buffer);
+        glDeleteVertexArrays(1, &m_VAO);
+    }
+
+    DebugDraw(const DebugDraw&) = delete;
+    DebugDraw& operator=(const DebugDraw&) = delete;
+
+    void AddLine(const glm::vec3& a, const glm::vec3& b, uint32_t color) {
+        if (m_Used + 2 > m_Capacity) { m_Dropped++; return; }
+        m_Write[m_Used++] = { a, color };
+        m_Write[m_Used++] = { b, color };
+    }
+
+    // a DebugLineList's lines, copied in whole lines; past the capacity they're dropped as above
+    void AddLines(const std::vector<DebugVertex>& lines) {
+        int count = (int)lines.size() & ~1;
+        int fit = std::min(count, m_Capacity - m_Used);
+        std::copy(lines.begin(), lines.begin() + fit, m_Write + m_Used);
+        m_Used += fit;
+        m_Dropped += (count - fit) / 2;
+    }
+
+    // Draw everything added since the last Flush in one call and move on to the next ring
+    // region (waiting on its fence, normally long signalled).
+    void Flush(const glm::mat4& viewProjection, bool depthTest = true) {
+        m_LastLines = m_Used / 2;
+        m_LastDropped = m_Dropped;
+        if (m_Used > 0) {
+            GLint first = m_Frame * m_Capacity;
+            if (!m_Persistent) {
+                glBindBuffer(GL_ARRAY_BUFFER, m_Buffer);
+                glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)first * sizeof(DebugVertex), (GLsizeiptr)m_Used * sizeof(DebugVertex), m_Staging.data());
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+            }
+            GLboolean depth = glIsEnabled(GL_DEPTH_TEST);
+            if (depthTest) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+            m_Shader.use();
+            m_Shader.setMat4("viewProjection", viewProjection);
+            glBindVertexArray(m_VAO);
+            glDrawArrays(GL_LINES, first, m_Used);
+            glBindVertexArray(0);
+            if (depth) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+
+            if (m_Persistent) {
+                m_Fences[m_Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                m_Frame = (m_Frame + 1) % FRAMES;
+                if (GLsync& fence = m_Fences[m_Frame]) {
+                    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+                    glDeleteSync(fence);
+                    fence = nullptr;
+                }
+                m_Write = m_Persistent + (size_t)m_Frame * m_Capacity;
+            }
+            else m_Frame = (m_Frame + 1) % FRAMES; // glBufferSubData orders itself against the draws
+        }
+        m_Used = 0;
+        m_Dropped = 0;
+    }
+
+    // as of the last Flush
+    int GetLineCount() const { return m_LastLines; }
+    int GetDroppedCount() const { return m_LastDropped; }
+    bool IsPersistent() const { return m_Persistent != nullptr; }
+
+private:
+    Shader m_Shader;
+    GLuint m_VAO = 0, m_Buffer = 0;
+    DebugVertex* m_Persistent = nullptr;  // whole ring, when persistently mapped
+    std::vector<DebugVertex> m_Staging;   // one region's worth otherwise
+    DebugVertex* m_Write = nullptr;       // this frame's region (or the staging copy)
+    GLsync m_Fences[FRAMES] = {};
+    int m_Capacity = 0; // vertices per frame
+    int m_Used = 0;
+    int m_Frame = 0;
+    int m_Dropped = 0, m_LastDropped = 0, m_LastLines = 0;
+};
+
+#endif
@@ -0,0 +1,13 @@
+#version 330 core
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec4 aColor; // RGBA8, normalized
+
+uniform mat4 viewProjection;
+
+out vec4 vColor;
+
+void main()
+{
+    vColor = aColor;
+    gl_Position = viewProjection * vec4(aPos, 1.0);
+}
@@ -0,0 +1,93 @@
+#ifndef FRAME_PACKET_H
+#define FRAME_PACKET_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "anim_lod.h"
+#include "debug_draw.h"
+#include "mesh_culling.h"
+
+// Simulation / render split. The simulation thread (input -> fixed ticks -> animation)
+// writes one FramePacket per frame: everything the render thread needs, copied out of the
+// simulation's state, so rendering never reads anything the next frame is changing. The
+// render thread owns the GL context and the window; it only uploads and draws packets.
+//
+// Packets travel through a TripleBuffer: the writer fills its back slot and publishes it;
+// the reader takes the newest published one. Neither side ever waits on the other to get
+// a slot: there are three, one each plus the one in between, swapped with a single atomic
+// exchange. Slots are reused, so once the vectors have grown a frame allocates nothing.
+struct FramePacket {
+    uint64_t frame = 0;       // simulation frame, from 1
+    float deltaTime = 0.0f;   // s of wall time this frame simulated
+    float animSeconds = 0.0f; // crowd update to the barrier, for CrowdRamp
+    bool quit = false;        // the replay ran out: close the window
+    double inputTime = -1.0;  // glfwGetTime() of the oldest input event the ticks applied, -1 none
+
+    // camera as simulated (crowd LOD / culling used it)
+    glm::mat4 projection{ 1.0f }, view{ 1.0f };
+    glm::vec3 camPos{ 0.0f };
+    float camYawDeg = 0.0f; // the simulation's (a replay's) camera yaw; the render latches its own otherwise
+
+    // player, interpolated between the last two ticks
+    glm::vec3 renderPos{ 0.0f };
+    glm::mat4 playerModel{ 1.0f };
+    std::vector<glm::mat4> playerPalette;
+
+    // crowd: Crowd::Pack blocks, uploaded as is
+    std::vector<glm::mat4> crowdBlocks;
+    int crowdCount = 0;
+
+    // hitboxes, hit volumes, skeleton (empty with the hitbox view off)
+    DebugLineList debugLines;
+
+    // counters for the window title
+    AnimLodStats lodStats;
+    MeshCullStats crowdCull;
+    int attackHits = 0;
+};
+
+template<class T>
+class TripleBuffer {
+public:
+    // writer: fill Back(), then Publish() it; Back() is then a different, older slot
+    T& Back() { return m_Slots[m_Back]; }
+    void Publish() { m_Back = m_Middle.exchange(m_Back | FRESH, std::memory_order_acq_rel) & INDEX; }
+
+    // reader: Acquire() swaps in the newest published slot if there is one; Front() is
+    // the newest seen so far (default-constructed before the first)
+    bool Acquire() {
+        if (!(m_Middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        m_Front = m_Middle.exchange(m_Front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    const T& Front() const { return m_Slots[m_Front]; }
+
+    // true once the reader has taken the last Publish (or nothing is published)
+    bool IsConsumed() const { return !(m_Middle.load(std::memory_order_acquire) & FRESH); }
+
+    // Spin, then sleep, until `ready()` or `stop` is set. For pacing one side against the
+    // other; a frame apart, the wait is mostly the other side's whole frame.
+    template<class F>
+    static void WaitFor(F&& ready, const std::atomic<bool>& stop) {
+        for (int spins = 0; !ready() && !stop.load(std::memory_order_relaxed); spins++) {
+            if (spins < 64) std::this_thread::yield();
+            else std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+private:
+    static const int INDEX = 3, FRESH = 4;
+
+    T m_Slots[3];
+    std::atomic<int> m_Middle{ 1 };
+    int m_Back = 0;  // writer's
+    int m_Front = 2; // reader's
+};
+
+#endif
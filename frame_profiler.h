@@ -0,0 +1,398 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_m.h>
+
+// Frame profiler: named scopes on the main thread, with optional GPU time per scope from
+// GL_TIME_ELAPSED queries, the last HISTORY frames kept for an overlay and for Chrome trace
+// export (chrome://tracing, Perfetto).
+//
+//   profiler.BeginFrame();
+//   { PROFILE_CPU(gProfiler, "simulation"); ... }
+//   { PROFILE_GPU(gProfiler, "crowd draw"); ... }   // CPU time + GPU time of its GL commands
+//   profiler.EndFrame();
+//
+// Queries are never waited on: each frame's queries sit in a ring of GPU_FRAMES sets and are
+// read back when their set comes round again, so GPU times show up GPU_FRAMES frames late
+// (and are dropped if still not available). TIME_ELAPSED queries can't nest; a GPU scope
+// inside another one is timed on the CPU only.
+//
+// Disabled at runtime, every call returns after one branch; built with
+// FRAME_PROFILER_ENABLED 0 the PROFILE_* macros compile to nothing.
+#ifndef FRAME_PROFILER_ENABLED
+#define FRAME_PROFILER_ENABLED 1
+#endif
+
+struct ProfileEvent {
+    const char* name;  // string literal, not copied
+    double beginUs;    // since the profiler was created
+    double cpuUs;
+    double gpuUs;      // < 0: no GPU time (CPU-only scope, not resolved yet, or dropped)
+    int depth;
+};
+
+struct ProfileFrame {
+    static const int MAX_EVENTS = 64;
+    uint64_t index = 0;
+    double beginUs = 0.0;
+    double durationUs = 0.0;
+    int eventCount = 0;
+    ProfileEvent events[MAX_EVENTS];
+};
+
+class FrameProfiler {
+public:
+    static const int HISTORY = 240;       // frames kept
+    static const int GPU_FRAMES = 4;      // query sets in flight
+    static const int MAX_GPU_SCOPES = 16; // per frame
+    static const int MAX_DEPTH = 16;
+
+    // needs a current GL context (query objects)
+    FrameProfiler() {
+        m_Start = Clock::now();
+        m_History.resize(HISTORY);
+        glGenQueries(GPU_FRAMES * MAX_GPU_SCOPES, &m_Queries[0][0]);
+    }
+    ~FrameProfiler() { glDeleteQueries(GPU_FRAMES * MAX_GPU_SCOPES, &m_Queries[0][0]); }
+
+    FrameProfiler(const FrameProfiler&) = delete;
+    FrameProfiler& operator=(const FrameProfiler&) = delete;
+
+    void SetEnabled(bool enabled) { m_Enabled = enabled; }
+    bool IsEnabled() const { return m_Enabled; }
+
+    void BeginFrame() {
+        if (!m_Enabled) return;
+        m_FrameIndex++;
+        ResolveGpu(m_FrameIndex % GPU_FRAMES); // the set this frame is about to reuse
+
+        ProfileFrame& frame = m_History[m_FrameIndex % HISTORY];
+        frame.index = m_FrameIndex;
+        frame.beginUs = NowUs();
+        frame.durationUs = 0.0;
+        frame.eventCount = 0;
+        m_Current = &frame;
+        m_Depth = 0;
+        m_GpuOpen = -1;
+        m_Recorded = std::min<uint64_t>(m_Recorded + 1, HISTORY);
+    }
+
+    void EndFrame() {
+        if (!m_Current) return;
+        m_Current->durationUs = NowUs() - m_Current->beginUs;
+        m_Current = nullptr;
+    }
+
+    // returns a handle for EndScope, -1 if nothing is recorded
+    int BeginScope(const char* name, bool gpu) {
+        if (!m_Current || m_Current->eventCount >= ProfileFrame::MAX_EVENTS || m_Depth >= MAX_DEPTH) return -1;
+        int id = m_Current->eventCount++;
+        ProfileEvent& e = m_Current->events[id];
+        e.name = name;
+        e.depth = m_Depth++;
+        e.cpuUs = 0.0;
+        e.gpuUs = -1.0;
+
+        int set = (int)(m_FrameIndex % GPU_FRAMES);
+        if (gpu && m_GpuOpen < 0 && m_QueryCount[set] < MAX_GPU_SCOPES) {
+            int q = m_QueryCount[set]++;
+            m_QueryEvent[set][q] = id;
+            m_QueryFrame[set] = m_FrameIndex;
+            glBeginQuery(GL_TIME_ELAPSED, m_Queries[set][q]);
+            m_GpuOpen = id;
+        }
+        e.beginUs = NowUs();
+        return id;
+    }
+
+    void EndScope(int id) {
+        if (!m_Current || id < 0) return;
+        ProfileEvent& e = m_Current->events[id];
+        e.cpuUs = NowUs() - e.beginUs;
+        if (m_GpuOpen == id) {
+            glEndQuery(GL_TIME_ELAPSED);
+            m_GpuOpen = -1;
+        }
+        m_Depth--;
+    }
+
+    uint64_t GetFrameIndex() const { return m_FrameIndex; }
+    uint64_t GetDroppedGpuQueries() const { return m_GpuDropped; }
+
+    // a recorded frame still in the history, else nullptr
+    const ProfileFrame* GetFrame(uint64_t index) const {
+        if (index == 0 || index > m_FrameIndex || m_FrameIndex - index >= m_Recorded) return nullptr;
+        const ProfileFrame& frame = m_History[index % HISTORY];
+        return (frame.index == index) ? &frame : nullptr;
+    }
+
+    // Chrome trace-event JSON of frames [first, last] that are still in the history. CPU
+    // scopes go on the "main" track; GPU times on a second track, placed where the CPU
+    // issued them (TIME_ELAPSED has durations, not GPU timestamps).
+    bool WriteChromeTrace(const std::string& path, uint64_t first, uint64_t last) const {
+        std::ofstream out(path, std::ios::trunc);
+        if (!out) {
+            std::cout << "ERROR::PROFILER: can't write " << path << "\n";
+            return false;
+        }
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"main\"}},\n";
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU (at submit)\"}}";
+        char line[256];
+        int frames = 0;
+        for (uint64_t i = first; i <= last; i++) {
+            const ProfileFrame* frame = GetFrame(i);
+            if (!frame) continue;
+            frames++;
+            std::snprintf(line, sizeof(line), ",\n{\"name\":\"frame %llu\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}",
+                (unsigned long long)frame->index, frame->beginUs, frame->durationUs);
+            out << line;
+            for (int e = 0; e < frame->eventCount; e++) {
+                const ProfileEvent& ev = frame->events[e];
+                std::snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}",
+                    ev.name, ev.beginUs, ev.cpuUs);
+                out << line;
+                if (ev.gpuUs >= 0.0) {
+                    std::snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"cat\":\"gpu\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":2}",
+                        ev.name, ev.beginUs, ev.gpuUs);
+                    out << line;
+                }
+            }
+        }
+        out << "\n]}\n";
+        std::cout << "profiler: wrote " << frames << " frames (" << first << ".." << last << ") to " << path << "\n";
+        return (bool)out;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    double NowUs() const { return std::chrono::duration<double, std::micro>(Clock::now() - m_Start).count(); }
+
+    void ResolveGpu(int set) {
+        ProfileFrame& frame = m_History[m_QueryFrame[set] % HISTORY];
+        bool live = (frame.index == m_QueryFrame[set]);
+        for (int q = 0; q < m_QueryCount[set]; q++) {
+            GLint available = 0;
+            glGetQueryObjectiv(m_Queries[set][q], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) { m_GpuDropped++; continue; }
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(m_Queries[set][q], GL_QUERY_RESULT, &ns);
+            if (live) frame.events[m_QueryEvent[set][q]].gpuUs = ns / 1000.0;
+        }
+        m_QueryCount[set] = 0;
+    }
+
+    Clock::time_point m_Start;
+    bool m_Enabled = false;
+    uint64_t m_FrameIndex = 0;
+    uint64_t m_Recorded = 0;
+    std::vector<ProfileFrame> m_History;
+    ProfileFrame* m_Current = nullptr;
+    int m_Depth = 0;
+
+    GLuint m_Queries[GPU_FRAMES][MAX_GPU_SCOPES] = {};
+    int m_QueryEvent[GPU_FRAMES][MAX_GPU_SCOPES] = {};
+    uint64_t m_QueryFrame[GPU_FRAMES] = {};
+    int m_QueryCount[GPU_FRAMES] = {};
+    int m_GpuOpen = -1; // event with the TIME_ELAPSED query running
+    uint64_t m_GpuDropped = 0;
+};
+
+class ProfileScope {
+public:
+    ProfileScope(FrameProfiler* profiler, const char* name, bool gpu)
+        : m_Profiler(profiler), m_Id(profiler ? profiler->BeginScope(name, gpu) : -1) {}
+    ~ProfileScope() { if (m_Id >= 0) m_Profiler->EndScope(m_Id); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    FrameProfiler* m_Profiler;
+    int m_Id;
+};
+
+#if FRAME_PROFILER_ENABLED
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_CPU(profiler, name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(profiler, name, false)
+#define PROFILE_GPU(profiler, name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(profiler, name, true)
+#else
+#define PROFILE_CPU(profiler, name) ((void)0)
+#define PROFILE_GPU(profiler, name) ((void)0)
+#endif
+
+// On-screen table of rolling stage timings (last AVERAGE_FRAMES frames): one row per scope
+// name with CPU / GPU ms and a bar against a 60 Hz frame, drawn in screen space with a
+// built-in 3x5 pixel font (no text rendering in the project otherwise).
+class ProfilerOverlay {
+public:
+    static const int AVERAGE_FRAMES = 60;
+
+    ProfilerOverlay() : m_Shader("profiler_overlay.vs", "profiler_overlay.fs") {
+        glGenVertexArrays(1, &m_VAO);
+        glGenBuffers(1, &m_VBO);
+        glBindVertexArray(m_VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(2 * sizeof(float)));
+        glBindVertexArray(0);
+    }
+    ~ProfilerOverlay() {
+        glDeleteBuffers(1, &m_VBO);
+        glDeleteVertexArrays(1, &m_VAO);
+    }
+
+    ProfilerOverlay(const ProfilerOverlay&) = delete;
+    ProfilerOverlay& operator=(const ProfilerOverlay&) = delete;
+
+    void Draw(const FrameProfiler& profiler, int width, int height) {
+        Gather(profiler);
+        m_Verts.clear();
+
+        const float S = 2.0f;           // screen pixels per font pixel
+        const float LINE = 7.0f * S;
+        const float BAR_PER_MS = 9.0f;  // 16.7 ms = 150 px
+        const float X = 10.0f, Y = 10.0f, W = 460.0f;
+        float h = LINE * (m_RowCount + 2) + 8.0f;
+        AddRect(X - 6.0f, Y - 6.0f, W, h, 0.0f, 0.0f, 0.0f, 0.6f);
+
+        char text[96];
+        std::snprintf(text, sizeof(text), "FRAME %6.2f MS %5.0f FPS  GPU DROPS %llu", m_FrameMs,
+            m_FrameMs > 0.0 ? 1000.0 / m_FrameMs : 0.0, (unsigned long long)profiler.GetDroppedGpuQueries());
+        AddText(X, Y, S, text, 1.0f, 1.0f, 1.0f);
+        AddText(X, Y + LINE, S, "STAGE                 CPU MS  GPU MS", 0.6f, 0.6f, 0.6f);
+
+        for (int r = 0; r < m_RowCount; r++) {
+            const Row& row = m_Rows[r];
+            float y = Y + LINE * (r + 2);
+            char name[24];
+            int indent = std::min(row.depth, 3);
+            std::snprintf(name, sizeof(name), "%*s%s", indent * 2, "", row.name);
+            double cpu = row.cpuUs / row.frames / 1000.0;
+            if (row.gpuFrames > 0)
+                std::snprintf(text, sizeof(text), "%-20.20s %7.2f %7.2f", name, cpu, row.gpuUs / row.gpuFrames / 1000.0);
+            else
+                std::snprintf(text, sizeof(text), "%-20.20s %7.2f       -", name, cpu);
+            float barX = X + 37.0f * 4.0f * S;
+            AddRect(barX, y, std::min((float)cpu * BAR_PER_MS, W - (barX - X) - 12.0f), 5.0f * S * 0.5f, 0.3f, 0.8f, 0.3f, 0.9f);
+            if (row.gpuFrames > 0) {
+                float gpu = (float)(row.gpuUs / row.gpuFrames / 1000.0);
+                AddRect(barX, y + 5.0f * S * 0.5f, std::min(gpu * BAR_PER_MS, W - (barX - X) - 12.0f), 5.0f * S * 0.5f, 0.9f, 0.5f, 0.2f, 0.9f);
+            }
+            AddText(X, y, S, text, 0.9f, 0.9f, 0.9f);
+        }
+
+        GLboolean depth = glIsEnabled(GL_DEPTH_TEST);
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        m_Shader.use();
+        m_Shader.setVec2("screenSize", glm::vec2((float)width, (float)height));
+        glBindVertexArray(m_VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+        glBufferData(GL_ARRAY_BUFFER, m_Verts.size() * sizeof(float), m_Verts.data(), GL_STREAM_DRAW);
+        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(m_Verts.size() / 6));
+        glBindVertexArray(0);
+        glDisable(GL_BLEND);
+        if (depth) glEnable(GL_DEPTH_TEST);
+    }
+
+private:
+    static const int MAX_ROWS = 24;
+    struct Row {
+        const char* name;
+        int depth;
+        int frames, gpuFrames;
+        double cpuUs, gpuUs;
+    };
+
+    void Gather(const FrameProfiler& profiler) {
+        m_RowCount = 0;
+        m_FrameMs = 0.0;
+        int frames = 0;
+        uint64_t last = profiler.GetFrameIndex();
+        for (uint64_t i = last; i > 0 && last - i < (uint64_t)AVERAGE_FRAMES; i--) {
+            const ProfileFrame* frame = profiler.GetFrame(i);
+            if (!frame || frame->durationUs <= 0.0) continue; // missing or still open
+            frames++;
+            m_FrameMs += frame->durationUs / 1000.0;
+            for (int e = 0; e < frame->eventCount; e++) {
+                const ProfileEvent& ev = frame->events[e];
+                Row* row = FindRow(ev.name, ev.depth);
+                if (!row) continue;
+                row->frames++;
+                row->cpuUs += ev.cpuUs;
+                if (ev.gpuUs >= 0.0) { row->gpuFrames++; row->gpuUs += ev.gpuUs; }
+            }
+        }
+        if (frames > 0) m_FrameMs /= frames;
+    }
+
+    Row* FindRow(const char* name, int depth) {
+        for (int r = 0; r < m_RowCount; r++)
+            if (std::strcmp(m_Rows[r].name, name) == 0) return &m_Rows[r];
+        if (m_RowCount == MAX_ROWS) return nullptr;
+        m_Rows[m_RowCount] = Row{ name, depth, 0, 0, 0.0, 0.0 };
+        return &m_Rows[m_RowCount++];
+    }
+
+    void AddRect(float x, float y, float w, float h, float r, float g, float b, float a) {
+        if (w <= 0.0f || h <= 0.0f) return;
+        const float corners[6][2] = { { x, y }, { x + w, y }, { x + w, y + h }, { x, y }, { x + w, y + h }, { x, y + h } };
+        for (const auto& c : corners) {
+            const float v[6] = { c[0], c[1], r, g, b, a };
+            m_Verts.insert(m_Verts.end(), v, v + 6);
+        }
+    }
+
+    // 3x5 glyphs, rows top to bottom, 3 bits each (MSB = left); unknown characters are blank
+    static uint16_t Glyph(char c) {
+        static const uint16_t GLYPHS[] = {
+            0x7B6F, 0x2C97, 0x73E7, 0x73CF, 0x5BC9, 0x79CF, 0x79EF, 0x7249, 0x7BEF, 0x7BCF, // 0-9
+            0x2BED, 0x6BAE, 0x3923, 0x6B6E, 0x79A7, 0x79A4, 0x396B, 0x5BED, 0x7497, 0x126A, // A-J
+            0x5BAD, 0x4927, 0x5FED, 0x6B6D, 0x2B6A, 0x6BA4, 0x2B73, 0x6BAD, 0x388E, 0x7492, // K-T
+            0x5B6F, 0x5B6A, 0x5BFD, 0x5AAD, 0x5A92, 0x72A7,                                 // U-Z
+            0x0002, 0x0410, 0x01C0, 0x12A4, 0x0007, 0x52A5, 0x2922, 0x224A,                 // . : - / _ % ( )
+        };
+        static const char PUNCTUATION[] = ".:-/_%()";
+        if (c >= 'a' && c <= 'z') c = (char)(c - 'a' + 'A');
+        if (c >= '0' && c <= '9') return GLYPHS[c - '0'];
+        if (c >= 'A' && c <= 'Z') return GLYPHS[10 + c - 'A'];
+        const char* p = (c != '\0') ? std::strchr(PUNCTUATION, c) : nullptr;
+        return p ? GLYPHS[36 + (p - PUNCTUATION)] : 0;
+    }
+
+    void AddText(float x, float y, float s, const char* text, float r, float g, float b) {
+        for (; *text; text++, x += 4.0f * s) {
+            uint16_t bits = Glyph(*text);
+            for (int i = 0; i < 15; i++)
+                if (bits & (1 << (14 - i))) AddRect(x + (i % 3) * s, y + (i / 3) * s, s, s, r, g, b, 1.0f);
+        }
+    }
+
+    Shader m_Shader;
+    GLuint m_VAO = 0, m_VBO = 0;
+    std::vector<float> m_Verts; // x, y (pixels, top-left origin), rgba; capacity kept across frames
+    Row m_Rows[MAX_ROWS];
+    int m_RowCount = 0;
+    double m_FrameMs = 0.0;
+};
+
+#endif
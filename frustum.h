@@ -0,0 +1,53 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// View frustum as six inward-facing planes (xyz = normal, w = distance), extracted from a
+// projection * view matrix (Gribb & Hartmann). A point p is inside a plane when
+// dot(plane.xyz, p) + plane.w >= 0. The tests are conservative: something reported as
+// visible may still be just outside a corner, never the other way round.
+struct Frustum {
+    enum { LEFT, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, PLANE_COUNT };
+    glm::vec4 planes[PLANE_COUNT];
+
+    Frustum() { for (glm::vec4& p : planes) p = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); } // contains everything
+    explicit Frustum(const glm::mat4& viewProjection) { Set(viewProjection); }
+
+    void Set(const glm::mat4& m) {
+        // glm is column-major: row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+        glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+        planes[LEFT] = row3 + row0;
+        planes[RIGHT] = row3 - row0;
+        planes[BOTTOM] = row3 + row1;
+        planes[TOP] = row3 - row1;
+        planes[NEAR_PLANE] = row3 + row2;
+        planes[FAR_PLANE] = row3 - row2;
+        for (glm::vec4& p : planes) {
+            float len = glm::length(glm::vec3(p));
+            if (len > 0.0f) p /= len;
+        }
+    }
+
+    bool IntersectsSphere(const glm::vec3& center, float radius) const {
+        for (const glm::vec4& p : planes)
+            if (glm::dot(glm::vec3(p), center) + p.w < -radius) return false;
+        return true;
+    }
+
+    // axis-aligned box: only the corner furthest along each plane's normal is tested
+    bool IntersectsAABB(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+        for (const glm::vec4& p : planes) {
+            glm::vec3 corner(p.x >= 0.0f ? boxMax.x : boxMin.x,
+                             p.y >= 0.0f ? boxMax.y : boxMin.y,
+                             p.z >= 0.0f ? boxMax.z : boxMin.z);
+            if (glm::dot(glm::vec3(p), corner) + p.w < 0.0f) return false;
+        }
+        return true;
+    }
+};
+
+#endif
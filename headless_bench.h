@@ -0,0 +1,194 @@
+#ifndef HEADLESS_BENCH_H
+#define HEADLESS_BENCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+#include "input_replay.h"
+
+// Pieces of the headless benchmark (skeletal_animation --bench-sim): scripted input,
+// per-stage frame time samples, heap allocation counting and peak RSS, and the JSON report.
+// The simulation itself is the game's own (SimulateTick); no window or GL context is made.
+
+// ---- heap allocation counter ----
+// Only in a bench build (HEADLESS_BENCH_COUNT_ALLOCS 1): global operator new / delete are
+// replaced with counting versions (one relaxed atomic add per allocation, on every thread),
+// so the game itself keeps the standard allocator. Define HEADLESS_BENCH_IMPLEMENTATION in
+// exactly one .cpp before including.
+#ifndef HEADLESS_BENCH_COUNT_ALLOCS
+#define HEADLESS_BENCH_COUNT_ALLOCS 0
+#endif
+
+struct AllocCounter {
+    static constexpr bool ENABLED = HEADLESS_BENCH_COUNT_ALLOCS != 0;
+    static inline std::atomic<uint64_t> allocations{ 0 };
+    static uint64_t Get() { return allocations.load(std::memory_order_relaxed); }
+};
+
+#if defined(HEADLESS_BENCH_IMPLEMENTATION) && HEADLESS_BENCH_COUNT_ALLOCS
+void* operator new(std::size_t size) {
+    AllocCounter::allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+#endif
+
+// peak resident set size of this process, bytes (0 if unknown)
+inline uint64_t PeakRssBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return (uint64_t)pmc.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return (uint64_t)usage.ru_maxrss;        // bytes
+#else
+    return (uint64_t)usage.ru_maxrss * 1024; // KiB
+#endif
+#endif
+}
+
+// ---- scripted input ----
+// Comma or semicolon separated steps, each "<verb> [seconds]":
+//   idle, walk, run, back, strafe      hold for `seconds` (default 1)
+//   roll, attack, jump                 press for one tick, then let go for `seconds` (default 1)
+//   turn <degrees>                     rotate the camera yaw, takes no time
+// e.g. "run 10, roll, attack, jump". Compiled to one InputFrame per tick.
+class InputScript {
+public:
+    static constexpr const char* DEFAULT = "idle 1, walk 3, run 10, roll, attack, jump, turn 90, strafe 3, back 2, idle 1";
+
+    // false (and a message in `error`) on an unknown verb or bad number
+    bool Compile(const std::string& text, float tickRate, std::string& error) {
+        m_Frames.clear();
+        float yawDeg = 0.0f;
+        std::string normalized = text;
+        std::replace(normalized.begin(), normalized.end(), ';', ',');
+        std::istringstream steps(normalized);
+        std::string step;
+        while (std::getline(steps, step, ',')) {
+            std::istringstream words(step);
+            std::string verb;
+            if (!(words >> verb)) continue;
+            float value = 1.0f;
+            bool hasValue = (bool)(words >> value);
+            if (!hasValue && !words.eof()) { error = "bad number in \"" + step + "\""; return false; }
+            if (verb == "turn") { yawDeg += hasValue ? value : 90.0f; continue; }
+
+            InputFrame held;
+            held.camYawDeg = yawDeg;
+            uint32_t tap = 0;
+            if (verb == "idle") {}
+            else if (verb == "walk") held.moveY = 1.0f;
+            else if (verb == "run") { held.moveY = 1.0f; held.buttons = INPUT_RUN; }
+            else if (verb == "back") held.moveY = -1.0f;
+            else if (verb == "strafe") { held.moveX = 1.0f; held.buttons = INPUT_STRAFE; }
+            else if (verb == "roll") tap = INPUT_ROLL;
+            else if (verb == "attack") tap = INPUT_ATTACK;
+            else if (verb == "jump") tap = INPUT_JUMP;
+            else { error = "unknown step \"" + verb + "\""; return false; }
+
+            if (tap) {
+                InputFrame press = held;
+                press.buttons = tap;
+                Append(press, 1, tickRate);
+            }
+            Append(held, std::max(0, (int)std::lround(value * tickRate)), tickRate);
+        }
+        if (m_Frames.empty()) { error = "empty script"; return false; }
+        return true;
+    }
+
+    int GetTickCount() const { return (int)m_Frames.size(); }
+    const InputFrame& Frame(int tick) const { return m_Frames[tick]; }
+
+private:
+    void Append(InputFrame frame, int ticks, float tickRate) {
+        for (int i = 0; i < ticks; i++) {
+            frame.tick = (uint32_t)m_Frames.size();
+            frame.time = frame.tick / tickRate;
+            m_Frames.push_back(frame);
+        }
+    }
+
+    std::vector<InputFrame> m_Frames;
+};
+
+// ---- per-stage samples ----
+// Reserve up front: Add never allocates within the measured frames.
+struct StageSamples {
+    std::string name;
+    std::vector<double> ms;
+
+    StageSamples(const std::string& stageName, int frames) : name(stageName) { ms.reserve(frames); }
+    void Add(double sampleMs) { ms.push_back(sampleMs); }
+
+    // nearest rank, p in [0, 1]
+    static double Percentile(std::vector<double> sorted, double p) {
+        if (sorted.empty()) return 0.0;
+        std::sort(sorted.begin(), sorted.end());
+        size_t rank = (size_t)std::ceil(p * sorted.size());
+        return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+    }
+    double Mean() const {
+        double sum = 0.0;
+        for (double v : ms) sum += v;
+        return ms.empty() ? 0.0 : sum / ms.size();
+    }
+    double Max() const { return ms.empty() ? 0.0 : *std::max_element(ms.begin(), ms.end()); }
+};
+
+// {"stage": {"mean_ms", "p50_ms", "p99_ms", "max_ms"}, ...}
+inline void WriteStagesJson(std::ostream& os, const std::vector<StageSamples>& stages, const char* indent) {
+    os << "{\n";
+    for (size_t i = 0; i < stages.size(); i++) {
+        const StageSamples& s = stages[i];
+        os << indent << "  \"" << s.name << "\": { \"mean_ms\": " << s.Mean()
+           << ", \"p50_ms\": " << StageSamples::Percentile(s.ms, 0.50)
+           << ", \"p99_ms\": " << StageSamples::Percentile(s.ms, 0.99)
+           << ", \"max_ms\": " << s.Max() << " }" << (i + 1 < stages.size() ? "," : "") << "\n";
+    }
+    os << indent << "}";
+}
+
+// script text as a JSON string literal
+inline std::string JsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if ((unsigned char)c >= 0x20) out += c;
+    }
+    return out + "\"";
+}
+
+#endif
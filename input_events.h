@@ -0,0 +1,192 @@
+#ifndef INPUT_EVENTS_H
+#define INPUT_EVENTS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Timestamped key / mouse-button events, from the window thread's GLFW callbacks to the
+// simulation. Polling glfwGetKey once a frame only sees the state at that instant: a tap
+// that starts and ends between two polls is lost, and every press waits for the next
+// frame's poll. Events keep each transition with the time it was delivered, so the
+// simulation hands it to the tick it happened in.
+struct InputEvent {
+    double time = 0.0; // glfwGetTime() when delivered
+    uint32_t bits = 0; // the bound bits the key / button drives
+    bool down = false;
+};
+
+// One producer (the window thread), one consumer (the simulation), lock-free. Full, it
+// drops new events and counts them; the consumer empties it every frame.
+class InputEventQueue {
+public:
+    static const uint32_t CAPACITY = 1024; // power of two
+
+    bool Push(const InputEvent& event) {
+        uint32_t head = m_Head.load(std::memory_order_relaxed);
+        if (head - m_Tail.load(std::memory_order_acquire) >= CAPACITY) {
+            m_Dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_Events[head & (CAPACITY - 1)] = event;
+        m_Head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // every event pushed so far, oldest first
+    template<class F>
+    void Drain(F&& fn) {
+        uint32_t tail = m_Tail.load(std::memory_order_relaxed);
+        uint32_t head = m_Head.load(std::memory_order_acquire);
+        for (; tail != head; tail++) fn(m_Events[tail & (CAPACITY - 1)]);
+        m_Tail.store(tail, std::memory_order_release);
+    }
+
+    uint32_t GetDroppedCount() const { return m_Dropped.load(std::memory_order_relaxed); }
+
+private:
+    InputEvent m_Events[CAPACITY];
+    std::atomic<uint32_t> m_Head{ 0 }, m_Tail{ 0 };
+    std::atomic<uint32_t> m_Dropped{ 0 };
+};
+
+// Held bits rebuilt from the events and cut into ticks: Advance(t) applies every event
+// delivered up to `t`. Pressed bits are the ones that went down in that interval, kept even
+// if they came up again before it ended, so a tap shorter than a tick still reaches it.
+class InputTicker {
+public:
+    // move everything queued so far into the pending list (consumer side)
+    void Take(InputEventQueue& queue) {
+        queue.Drain([this](const InputEvent& event) { m_Pending.push_back(event); });
+    }
+
+    // Returns the delivery time of the oldest event applied, or -1 if there was none.
+    double Advance(double time) {
+        m_Pressed = 0;
+        double oldest = -1.0;
+        size_t n = 0;
+        for (; n < m_Pending.size() && m_Pending[n].time <= time; n++) {
+            const InputEvent& event = m_Pending[n];
+            if (event.down) {
+                m_Pressed |= event.bits & ~m_Held;
+                m_Held |= event.bits;
+            }
+            else m_Held &= ~event.bits;
+            if (oldest < 0.0) oldest = event.time;
+        }
+        m_Pending.erase(m_Pending.begin(), m_Pending.begin() + n);
+        return oldest;
+    }
+
+    uint32_t GetHeld() const { return m_Held; }
+    uint32_t GetPressed() const { return m_Pressed; }
+
+private:
+    std::vector<InputEvent> m_Pending; // delivered after the last Advance, in order
+    uint32_t m_Held = 0, m_Pressed = 0;
+};
+
+// Input-to-present latency, every frame. After the frame's last draw, Submit puts a
+// GL_TIMESTAMP query in the command stream along with the frame's input times; once the
+// result is in (a frame or two later, never waited on unless every slot is busy) the GPU time
+// is mapped onto glfwGetTime() and two latencies are recorded:
+//
+//   input:  oldest key / button event the frame's ticks applied -> GPU done (frames with input)
+//   camera: camera latch (the last mouse poll before drawing) -> GPU done (every frame)
+//
+// GPU done is the earliest the frame can reach the screen; a vsync'd flip adds up to a refresh.
+class LatencyMeter {
+public:
+    static const int FRAMES = 4; // queries in flight
+
+    struct Stats {
+        int frames = 0, inputFrames = 0;
+        double inputSum = 0.0, inputMax = 0.0;   // s
+        double cameraSum = 0.0, cameraMax = 0.0; // s
+
+        void Reset() { *this = Stats(); }
+        void Print(std::ostream& os) const {
+            os << std::fixed << std::setprecision(1) << "input -> GPU done "
+               << (inputFrames ? 1000.0 * inputSum / inputFrames : 0.0) << " ms avg, " << 1000.0 * inputMax << " max ("
+               << inputFrames << " frames with input); camera latch -> GPU done "
+               << (frames ? 1000.0 * cameraSum / frames : 0.0) << " ms avg, " << 1000.0 * cameraMax << " max ("
+               << frames << " frames)\n" << std::defaultfloat;
+        }
+    };
+
+    // needs a current GL context (query objects)
+    LatencyMeter() { glGenQueries(FRAMES, m_Queries); }
+    ~LatencyMeter() { glDeleteQueries(FRAMES, m_Queries); }
+
+    LatencyMeter(const LatencyMeter&) = delete;
+    LatencyMeter& operator=(const LatencyMeter&) = delete;
+
+    // After the frame's last draw. inputTime < 0: no input event reached this frame.
+    // `now` is glfwGetTime(), read next to the GPU clock to line the two up.
+    void Submit(double inputTime, double latchTime, double now) {
+        Frame& frame = m_Frames[m_Next];
+        if (frame.pending) Resolve(frame, true); // every slot busy: the GPU is FRAMES behind
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        glQueryCounter(m_Queries[m_Next], GL_TIMESTAMP);
+        frame.inputTime = inputTime;
+        frame.latchTime = latchTime;
+        frame.clockOffset = now - (double)gpuNow * 1e-9;
+        frame.pending = true;
+        m_Next = (m_Next + 1) % FRAMES;
+    }
+
+    // once a frame: record whatever finished
+    void Update() {
+        for (Frame& frame : m_Frames)
+            if (frame.pending) Resolve(frame, false);
+    }
+
+    // since the last TakeWindow / since the start
+    Stats TakeWindow() { Stats s = m_Window; m_Window.Reset(); return s; }
+    const Stats& GetTotal() const { return m_Total; }
+
+private:
+    struct Frame {
+        double inputTime = -1.0, latchTime = 0.0, clockOffset = 0.0;
+        bool pending = false;
+    };
+
+    void Resolve(Frame& frame, bool wait) {
+        GLuint query = m_Queries[&frame - m_Frames];
+        if (!wait) {
+            GLuint available = 0;
+            glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) return;
+        }
+        GLuint64 gpuDone = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpuDone);
+        frame.pending = false;
+
+        double done = (double)gpuDone * 1e-9 + frame.clockOffset;
+        double camera = std::max(0.0, done - frame.latchTime);
+        double input = frame.inputTime >= 0.0 ? std::max(0.0, done - frame.inputTime) : -1.0;
+        for (Stats* s : { &m_Window, &m_Total }) {
+            s->frames++;
+            s->cameraSum += camera;
+            s->cameraMax = std::max(s->cameraMax, camera);
+            if (input >= 0.0) {
+                s->inputFrames++;
+                s->inputSum += input;
+                s->inputMax = std::max(s->inputMax, input);
+            }
+        }
+    }
+
+    GLuint m_Queries[FRAMES] = {};
+    Frame m_Frames[FRAMES];
+    int m_Next = 0;
+    Stats m_Window, m_Total;
+};
+
+#endif
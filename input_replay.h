@@ -0,0 +1,152 @@
+#ifndef INPUT_REPLAY_H
+#define INPUT_REPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Player input for one simulation tick. The simulation reads nothing else from the window,
+// so feeding the same frames to the same build reproduces a run exactly; the camera yaw is
+// included because movement is camera-relative.
+enum InputButton : uint32_t {
+    INPUT_ROLL = 1u << 0,   // space
+    INPUT_ATTACK = 1u << 1, // left mouse
+    INPUT_JUMP = 1u << 2,   // E
+    INPUT_RUN = 1u << 3,    // left shift
+    INPUT_STRAFE = 1u << 4, // right mouse: face the camera
+};
+
+struct InputFrame {
+    uint32_t tick = 0;
+    float time = 0.0f;        // wall-clock seconds when sampled (informational, not simulated)
+    float moveX = 0.0f;       // A/D
+    float moveY = 0.0f;       // S/W
+    float camYawDeg = 0.0f;
+    uint32_t buttons = 0;     // InputButton bits held
+    uint32_t pressed = 0;     // InputButton bits that went down during the tick, even if released again
+
+    bool Held(uint32_t button) const { return (buttons & button) != 0; }
+    bool Pressed(uint32_t button) const { return (pressed & button) != 0; }
+};
+
+// Input recording (<name>.inrec):
+//
+//   InputFileHeader
+//   { InputFrame frame; uint32_t stateHash; }[frameCount]
+//
+// stateHash is the simulation state after that tick (see SimStateHash in
+// skeletal_animation.cpp); a replay compares against it and reports the first tick
+// that diverged. Host byte order, like the clip cache.
+const char INPUT_FILE_MAGIC[4] = { 'K', 'I', 'N', 'P' };
+const uint32_t INPUT_FILE_VERSION = 2; // 2: InputFrame::pressed
+
+struct InputFileHeader {
+    char magic[4];
+    uint32_t version;
+    float tickRate; // ticks per second the recording was made at
+    uint32_t frameCount;
+};
+
+struct InputFileRecord {
+    InputFrame frame;
+    uint32_t stateHash;
+};
+
+static_assert(sizeof(InputFileHeader) == 16, "InputFileHeader layout changed, bump INPUT_FILE_VERSION");
+static_assert(sizeof(InputFileRecord) == 32, "InputFileRecord layout changed, bump INPUT_FILE_VERSION");
+
+// FNV-1a, for hashing simulation state bit-for-bit
+inline uint32_t HashBytes(const void* data, size_t size, uint32_t hash = 2166136261u) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) hash = (hash ^ p[i]) * 16777619u;
+    return hash;
+}
+
+// Collects one record per tick in memory and writes them out at the end (32 bytes a tick,
+// ~115 KB per minute at 60 Hz).
+class InputRecorder {
+public:
+    explicit InputRecorder(float tickRate) : m_TickRate(tickRate) {}
+
+    void Add(const InputFrame& frame, uint32_t stateHash) { m_Records.push_back({ frame, stateHash }); }
+    int GetFrameCount() const { return (int)m_Records.size(); }
+
+    bool Save(const std::string& path) const {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cout << "ERROR::INPUT_RECORDER: can't write " << path << "\n";
+            return false;
+        }
+        InputFileHeader header;
+        std::memcpy(header.magic, INPUT_FILE_MAGIC, 4);
+        header.version = INPUT_FILE_VERSION;
+        header.tickRate = m_TickRate;
+        header.frameCount = (uint32_t)m_Records.size();
+        out.write((const char*)&header, sizeof(header));
+        out.write((const char*)m_Records.data(), m_Records.size() * sizeof(InputFileRecord));
+        return (bool)out;
+    }
+
+private:
+    float m_TickRate;
+    std::vector<InputFileRecord> m_Records;
+};
+
+// Plays a recording back one tick at a time and checks the resulting state against it.
+class InputReplay {
+public:
+    bool Load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        InputFileHeader header;
+        if (!in || !in.read((char*)&header, sizeof(header)) ||
+            std::memcmp(header.magic, INPUT_FILE_MAGIC, 4) != 0 || header.version != INPUT_FILE_VERSION) {
+            std::cout << "ERROR::INPUT_REPLAY: " << path << " is not an input recording (version " << INPUT_FILE_VERSION << ")\n";
+            return false;
+        }
+        m_Records.resize(header.frameCount);
+        if (!in.read((char*)m_Records.data(), m_Records.size() * sizeof(InputFileRecord))) {
+            std::cout << "ERROR::INPUT_REPLAY: " << path << " is truncated\n";
+            m_Records.clear();
+            return false;
+        }
+        m_TickRate = header.tickRate;
+        m_Next = 0;
+        m_FirstMismatch = -1;
+        return true;
+    }
+
+    float GetTickRate() const { return m_TickRate; }
+    int GetFrameCount() const { return (int)m_Records.size(); }
+    int GetPosition() const { return m_Next; }
+    bool IsDone() const { return m_Next >= (int)m_Records.size(); }
+
+    // input for the next tick; false once the recording is exhausted
+    bool Next(InputFrame& out) {
+        if (IsDone()) return false;
+        out = m_Records[m_Next].frame;
+        return true;
+    }
+
+    // state after the tick Next() returned; advances to the following one
+    void Check(uint32_t stateHash) {
+        if (IsDone()) return;
+        if (m_FirstMismatch < 0 && stateHash != m_Records[m_Next].stateHash)
+            m_FirstMismatch = (int)m_Records[m_Next].frame.tick;
+        m_Next++;
+    }
+
+    // tick of the first divergence, -1 if every checked tick matched
+    int GetFirstMismatch() const { return m_FirstMismatch; }
+
+private:
+    std::vector<InputFileRecord> m_Records;
+    float m_TickRate = 0.0f;
+    int m_Next = 0;
+    int m_FirstMismatch = -1;
+};
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Per-frame CPU jobs (animation updates etc.) over a fixed set of worker threads with
+// work stealing. Unlike ThreadPool in asset_loader.h (futures, one-off loading tasks),
+// jobs here are tiny and frequent: a job is a function pointer + context + index range,
+// nothing is allocated per job, and the thread that waits helps run jobs.
+//
+// Every thread owns a deque. A thread pushes and pops its own work at the back (LIFO,
+// cache-warm); an idle thread steals from the front of someone else's. Threads that are
+// not workers (the main thread) share slot 0.
+//
+//   JobCounter done;
+//   jobs.ParallelFor(count, grain, fn, done);  // fn(begin, end), must outlive the Wait
+//   ... other work ...
+//   jobs.Wait(done);                           // barrier
+struct JobCounter {
+    std::atomic<int> pending{ 0 };
+    bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+class JobSystem {
+public:
+    using JobFn = void (*)(void* ctx, int begin, int end);
+
+    // workerCount < 0: one per hardware thread, minus the caller's
+    explicit JobSystem(int workerCount = -1) {
+        if (workerCount < 0)
+            workerCount = std::max(0, (int)std::thread::hardware_concurrency() - 1);
+        m_Queues.reserve(workerCount + 1);
+        for (int i = 0; i <= workerCount; i++)
+            m_Queues.emplace_back(new WorkQueue());
+        for (int i = 1; i <= workerCount; i++)
+            m_Workers.emplace_back([this, i] { WorkerLoop(i); });
+    }
+
+    ~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(m_SleepLock);
+            m_Stop = true;
+        }
+        m_Wake.notify_all();
+        for (std::thread& t : m_Workers) t.join();
+        for (WorkQueue* q : m_Queues) delete q;
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // threads that run jobs, including the one calling Wait
+    int GetThreadCount() const { return (int)m_Workers.size() + 1; }
+
+    void Kick(JobFn fn, void* ctx, int begin, int end, JobCounter& counter) {
+        counter.pending.fetch_add(1, std::memory_order_relaxed);
+        Job job{ fn, ctx, begin, end, &counter };
+        if (!m_Queues[ThisSlot()]->Push(job)) {
+            Run(job); // deque full: just do it here
+            return;
+        }
+        // seq_cst here and in WorkerLoop: each side writes one counter then reads the other,
+        // and anything weaker lets both read the old value (no notify, worker asleep)
+        m_Queued.fetch_add(1, std::memory_order_seq_cst);
+        if (m_Sleeping.load(std::memory_order_seq_cst) > 0) {
+            { std::lock_guard<std::mutex> lock(m_SleepLock); }
+            m_Wake.notify_one();
+        }
+    }
+
+    // fn(begin, end) over [0, count) in chunks of `grain`; fn is referenced, not copied
+    template <class F>
+    void ParallelFor(int count, int grain, F& fn, JobCounter& counter) {
+        grain = std::max(1, grain);
+        for (int begin = 0; begin < count; begin += grain)
+            Kick(&CallRange<F>, &fn, begin, std::min(count, begin + grain), counter);
+    }
+
+    // run queued jobs (ours first, then stolen) until every job on `counter` has finished
+    void Wait(JobCounter& counter) {
+        int slot = ThisSlot();
+        while (!counter.IsDone()) {
+            if (!RunOne(slot)) std::this_thread::yield();
+        }
+    }
+
+private:
+    struct Job {
+        JobFn fn;
+        void* ctx;
+        int begin, end;
+        JobCounter* counter;
+    };
+
+    // fixed ring; the owner works at the back, thieves take from the front
+    struct WorkQueue {
+        static const size_t CAPACITY = 1024;
+        std::mutex lock;
+        Job ring[CAPACITY];
+        size_t head = 0, tail = 0;
+
+        bool Push(const Job& job) {
+            std::lock_guard<std::mutex> guard(lock);
+            if (tail - head == CAPACITY) return false;
+            ring[tail++ % CAPACITY] = job;
+            return true;
+        }
+        bool Pop(Job& out) {
+            std::lock_guard<std::mutex> guard(lock);
+            if (tail == head) return false;
+            out = ring[--tail % CAPACITY];
+            return true;
+        }
+        bool Steal(Job& out) {
+            std::lock_guard<std::mutex> guard(lock);
+            if (tail == head) return false;
+            out = ring[head++ % CAPACITY];
+            return true;
+        }
+    };
+
+    template <class F>
+    static void CallRange(void* ctx, int begin, int end) { (*static_cast<F*>(ctx))(begin, end); }
+
+    static void Run(const Job& job) {
+        job.fn(job.ctx, job.begin, job.end);
+        job.counter->pending.fetch_sub(1, std::memory_order_release);
+    }
+
+    bool RunOne(int slot) {
+        Job job;
+        bool found = m_Queues[slot]->Pop(job);
+        for (size_t i = 1; !found && i < m_Queues.size(); i++)
+            found = m_Queues[(slot + i) % m_Queues.size()]->Steal(job);
+        if (!found) return false;
+        m_Queued.fetch_sub(1, std::memory_order_relaxed);
+        Run(job);
+        return true;
+    }
+
+    void WorkerLoop(int slot) {
+        t_Owner = this;
+        t_Slot = slot;
+        const int SPINS = 64; // stay hot briefly between the bursts of a frame
+        int idle = 0;
+        while (true) {
+            if (RunOne(slot)) { idle = 0; continue; }
+            if (++idle < SPINS) { std::this_thread::yield(); continue; }
+
+            std::unique_lock<std::mutex> lock(m_SleepLock);
+            m_Sleeping.fetch_add(1, std::memory_order_seq_cst);
+            m_Wake.wait(lock, [this] { return m_Stop || m_Queued.load(std::memory_order_seq_cst) > 0; });
+            m_Sleeping.fetch_sub(1, std::memory_order_acq_rel);
+            if (m_Stop) return;
+            idle = 0;
+        }
+    }
+
+    int ThisSlot() const { return (t_Owner == this) ? t_Slot : 0; }
+
+    static thread_local const JobSystem* t_Owner;
+    static thread_local int t_Slot;
+
+    std::vector<WorkQueue*> m_Queues; // [0] = non-worker threads
+    std::vector<std::thread> m_Workers;
+    std::atomic<int> m_Queued{ 0 };
+    std::atomic<int> m_Sleeping{ 0 };
+    std::mutex m_SleepLock;
+    std::condition_variable m_Wake;
+    bool m_Stop = false;
+};
+
+inline thread_local const JobSystem* JobSystem::t_Owner = nullptr;
+inline thread_local int JobSystem::t_Slot = 0;
+
+#endif
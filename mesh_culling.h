@@ -0,0 +1,297 @@
+#ifndef MESH_CULLING_H
+#define MESH_CULLING_H
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_m.h>
+#include <learnopengl/model_animation.h>
+
+#include "collision_world.h"
+#include "frustum.h"
+
+// box around `box` after the affine transform `m` (Arvo)
+inline Aabb TransformAabb(const Aabb& box, const glm::mat4& m) {
+    Aabb out{ glm::vec3(m[3]), glm::vec3(m[3]) };
+    for (int c = 0; c < 3; c++) {
+        glm::vec3 a = glm::vec3(m[c]) * box.min[c], b = glm::vec3(m[c]) * box.max[c];
+        out.min += glm::min(a, b);
+        out.max += glm::max(a, b);
+    }
+    return out;
+}
+
+// Bounds of one skinned mesh, built once from its bind-pose vertices. Every bone gets the
+// box of the bind-space vertices it influences; a skinned vertex is a weighted sum of its
+// bones' transforms of the bind position, so it lies inside the union of those boxes after
+// their palette matrices (plus the origin where the weights sum to less than one: assimp
+// influences past the fourth are dropped). That makes the pose box conservative for any
+// pose at the cost of a few box transforms per mesh.
+struct MeshBounds {
+    Aabb bind{ glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) }; // all vertices, bind pose
+    std::vector<int> bones;        // palette indices influencing the mesh
+    std::vector<Aabb> boneBoxes;   // their bind-space vertex boxes
+    bool rigid = false;            // some vertex is drawn unskinned (no or out-of-range bones)
+    bool toOrigin = false;         // some vertex's weights sum to less than one
+    int triangles = 0;
+
+    MeshBounds() {}
+    MeshBounds(const Mesh& mesh, int boneCount) {
+        triangles = (int)mesh.indices.size() / 3;
+        std::vector<int> slot(boneCount, -1);
+        for (const Vertex& v : mesh.vertices) {
+            Grow(bind, v.Position);
+            float weight = 0.0f;
+            bool skinned = false;
+            for (int i = 0; i < MAX_BONE_INFLUENCE; i++) {
+                int bone = v.m_BoneIDs[i];
+                if (bone < 0) continue;
+                if (bone >= boneCount) { skinned = false; break; } // the shader falls back to the bind position
+                if (slot[bone] < 0) {
+                    slot[bone] = (int)bones.size();
+                    bones.push_back(bone);
+                    boneBoxes.push_back(Aabb{ glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) });
+                }
+                Grow(boneBoxes[slot[bone]], v.Position);
+                weight += v.m_Weights[i];
+                skinned = true;
+            }
+            if (!skinned) rigid = true;
+            else if (weight < 0.999f) toOrigin = true;
+        }
+    }
+
+    // model-space box for a palette of `count` matrices; no palette = the bind pose
+    Aabb Pose(const glm::mat4* palette, int count) const {
+        if (!palette || count <= 0 || bones.empty()) return bind;
+        Aabb out = rigid ? bind : Aabb{ glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+        if (toOrigin) Grow(out, glm::vec3(0.0f));
+        for (size_t b = 0; b < bones.size(); b++) {
+            if (bones[b] >= count) { Union(out, boneBoxes[b]); continue; }
+            Union(out, TransformAabb(boneBoxes[b], palette[bones[b]]));
+        }
+        return out;
+    }
+
+    static void Grow(Aabb& box, const glm::vec3& p) { box.min = glm::min(box.min, p); box.max = glm::max(box.max, p); }
+    static void Union(Aabb& box, const Aabb& o) { box.min = glm::min(box.min, o.min); box.max = glm::max(box.max, o.max); }
+};
+
+// same sampler naming as Mesh::Draw (texture_diffuseN, texture_specularN, ...), for draws
+// that bind their own VAO
+inline void BindMeshTextures(const Mesh& mesh, Shader& shader) {
+    unsigned int diffuseNr = 1, specularNr = 1, normalNr = 1, heightNr = 1;
+    for (unsigned int i = 0; i < mesh.textures.size(); i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        const std::string& name = mesh.textures[i].type;
+        std::string number;
+        if (name == "texture_diffuse") number = std::to_string(diffuseNr++);
+        else if (name == "texture_specular") number = std::to_string(specularNr++);
+        else if (name == "texture_normal") number = std::to_string(normalNr++);
+        else if (name == "texture_height") number = std::to_string(heightNr++);
+        shader.setInt(name + number, (int)i);
+        glBindTexture(GL_TEXTURE_2D, mesh.textures[i].id);
+    }
+}
+
+// per-frame submission counters (ModelCuller and Crowd::GatherCullStats add to them)
+struct MeshCullStats {
+    int meshes = 0, meshesCulled = 0; // submitted / rejected by the frustum
+    int meshesOccluded = 0;           // rejected by an occlusion query
+    int triangles = 0, trianglesCulled = 0;
+
+    void Reset() { *this = MeshCullStats(); }
+    void Add(const MeshCullStats& o) {
+        meshes += o.meshes; meshesCulled += o.meshesCulled; meshesOccluded += o.meshesOccluded;
+        triangles += o.triangles; trianglesCulled += o.trianglesCulled;
+    }
+};
+
+// Frustum (and optionally occlusion) culling for one skinned Model, mesh by mesh, in place of
+// Model::Draw.
+//
+//   Cull  poses every mesh's bounds, tests them against the frustum and, with occlusion on,
+//         draws the boxes of the survivors into GL_ANY_SAMPLES_PASSED queries (no colour or
+//         depth writes) against whatever is already in the depth buffer: call it after the
+//         big occluders (terrain) are drawn.
+//   Draw  submits the meshes that passed.
+//
+// Query results are read a frame later, only once available, so the CPU never waits on the
+// GPU; a mesh coming out from behind an occluder may therefore show a frame late. A camera
+// inside a mesh's box always counts as visible (the box's near faces would be clipped).
+class ModelCuller {
+public:
+    explicit ModelCuller(Model& model) : m_Model(model) {
+        int boneCount = model.GetBoneCount();
+        for (const Mesh& mesh : model.meshes) m_Bounds.emplace_back(mesh, boneCount);
+        m_Meshes.resize(m_Bounds.size());
+    }
+
+    ~ModelCuller() {
+        for (MeshState& mesh : m_Meshes)
+            if (mesh.query) glDeleteQueries(1, &mesh.query);
+        if (m_BoxVAO) {
+            glDeleteVertexArrays(1, &m_BoxVAO);
+            glDeleteBuffers(1, &m_BoxVBO);
+            glDeleteBuffers(1, &m_BoxEBO);
+        }
+        delete m_BoxShader;
+    }
+
+    ModelCuller(const ModelCuller&) = delete;
+    ModelCuller& operator=(const ModelCuller&) = delete;
+
+    void SetOcclusion(bool enabled) { m_Occlusion = enabled; }
+    bool GetOcclusion() const { return m_Occlusion; }
+
+    // `palette`: the draw's final bone matrices (null = bind pose); stats are this call's
+    void Cull(const glm::mat4& model, const glm::mat4* palette, int paletteCount,
+              const glm::mat4& viewProjection, const glm::vec3& camPos) {
+        m_Stats.Reset();
+        Frustum frustum(viewProjection);
+        bool queries = m_Occlusion && CreateBoxMesh();
+        if (queries) BeginQueries(viewProjection);
+
+        for (size_t i = 0; i < m_Meshes.size(); i++) {
+            MeshState& mesh = m_Meshes[i];
+            const int triangles = m_Bounds[i].triangles;
+            mesh.world = TransformAabb(m_Bounds[i].Pose(palette, paletteCount), model);
+            mesh.visible = frustum.IntersectsAABB(mesh.world.min, mesh.world.max);
+            if (!mesh.visible) {
+                mesh.occluded = false; // whatever it was last seen behind may have moved
+                m_Stats.meshesCulled++;
+                m_Stats.trianglesCulled += triangles;
+                continue;
+            }
+            if (queries) Query(mesh, camPos);
+            else mesh.occluded = false;
+
+            if (mesh.occluded) {
+                mesh.visible = false;
+                m_Stats.meshesOccluded++;
+                m_Stats.trianglesCulled += triangles;
+                continue;
+            }
+            m_Stats.meshes++;
+            m_Stats.triangles += triangles;
+        }
+        if (queries) EndQueries();
+    }
+
+    // the meshes that passed the last Cull (shader set up as for Model::Draw)
+    void Draw(Shader& shader) {
+        for (size_t i = 0; i < m_Meshes.size(); i++)
+            if (m_Meshes[i].visible) m_Model.meshes[i].Draw(shader);
+    }
+
+    const MeshCullStats& GetStats() const { return m_Stats; }
+    // passed the last Cull
+    bool IsVisible(int mesh) const { return m_Meshes[mesh].visible; }
+    int GetMeshCount() const { return (int)m_Bounds.size(); }
+    const MeshBounds& GetBounds(int mesh) const { return m_Bounds[mesh]; }
+    // world box of a mesh as of the last Cull
+    const Aabb& GetWorldBounds(int mesh) const { return m_Meshes[mesh].world; }
+
+private:
+    struct MeshState {
+        Aabb world;
+        bool visible = true;
+        bool occluded = false;   // last query result
+        GLuint query = 0;
+        bool pending = false;    // query issued, result not read yet
+    };
+
+    // read last frame's result if it's in; issue a new query once the old one is consumed
+    void Query(MeshState& mesh, const glm::vec3& camPos) {
+        if (mesh.pending) {
+            GLint available = 0;
+            glGetQueryObjectiv(mesh.query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint samples = 0;
+                glGetQueryObjectuiv(mesh.query, GL_QUERY_RESULT, &samples);
+                mesh.occluded = (samples == 0);
+                mesh.pending = false;
+            }
+        }
+        const float margin = 0.05f;
+        Aabb box{ mesh.world.min - glm::vec3(margin), mesh.world.max + glm::vec3(margin) };
+        Aabb padded{ box.min - glm::vec3(NEAR_MARGIN), box.max + glm::vec3(NEAR_MARGIN) };
+        if (padded.Overlaps(Aabb{ camPos, camPos })) {
+            mesh.occluded = false;
+            return;
+        }
+        if (mesh.pending) return;
+
+        if (!mesh.query) glGenQueries(1, &mesh.query);
+        m_BoxShader->setVec3("boxMin", box.min);
+        m_BoxShader->setVec3("boxMax", box.max);
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, mesh.query);
+        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, 0);
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+        mesh.pending = true;
+    }
+
+    void BeginQueries(const glm::mat4& viewProjection) {
+        m_DepthTest = glIsEnabled(GL_DEPTH_TEST);
+        m_CullFace = glIsEnabled(GL_CULL_FACE);
+        glEnable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthMask(GL_FALSE);
+        m_BoxShader->use();
+        m_BoxShader->setMat4("viewProjection", viewProjection);
+        glBindVertexArray(m_BoxVAO);
+    }
+
+    void EndQueries() {
+        glBindVertexArray(0);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthMask(GL_TRUE);
+        if (!m_DepthTest) glDisable(GL_DEPTH_TEST);
+        if (m_CullFace) glEnable(GL_CULL_FACE);
+    }
+
+    // unit cube, corners 0..1, scaled into place by occlusion_box.vs
+    bool CreateBoxMesh() {
+        if (m_BoxVAO) return true;
+        static const float corners[24] = { 0,0,0, 1,0,0, 0,1,0, 1,1,0, 0,0,1, 1,0,1, 0,1,1, 1,1,1 };
+        static const uint8_t faces[36] = {
+            0,2,1, 1,2,3,  4,5,6, 5,7,6,  0,1,4, 1,5,4,
+            2,6,3, 3,6,7,  0,4,2, 2,4,6,  1,3,5, 3,7,5,
+        };
+        m_BoxShader = new Shader("occlusion_box.vs", "occlusion_box.fs");
+        glGenVertexArrays(1, &m_BoxVAO);
+        glGenBuffers(1, &m_BoxVBO);
+        glGenBuffers(1, &m_BoxEBO);
+        glBindVertexArray(m_BoxVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_BoxVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_BoxEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(faces), faces, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return true;
+    }
+
+    static constexpr float NEAR_MARGIN = 0.2f; // > the near plane, so a box this close isn't clipped open
+
+    Model& m_Model;
+    std::vector<MeshBounds> m_Bounds;
+    std::vector<MeshState> m_Meshes;
+    MeshCullStats m_Stats;
+    bool m_Occlusion = false;
+
+    Shader* m_BoxShader = nullptr;
+    GLuint m_BoxVAO = 0, m_BoxVBO = 0, m_BoxEBO = 0;
+    GLboolean m_DepthTest = GL_TRUE, m_CullFace = GL_FALSE;
+};
+
+#endif
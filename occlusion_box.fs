@@ -0,0 +1,8 @@
+#version 330 core
+out vec4 FragColor;
+
+// colour writes are masked off; only the samples passing the depth test count
+void main()
+{
+    FragColor = vec4(1.0);
+}
@@ -0,0 +1,343 @@
+#ifndef PACKED_MESH_H
+#define PACKED_MESH_H
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_m.h>
+#include <learnopengl/model_animation.h>
+
+#include "collision_world.h"
+
+// Skinned vertex as anim_model.vs reads it, 20 bytes instead of Mesh's ~90: only the streams
+// the shader uses, quantized.
+//
+//   pos      unorm16 x3 within the model's bind-pose box (positionScale / positionOffset undo
+//            it in the shader); w pads to 4-byte alignment
+//   uv       half x2 (tiling UVs go past 0..1)
+//   bones    ubyte x4 palette indices; unused slots are 0 with weight 0
+//   weights  unorm8 x4, summing to exactly 255
+//
+// Normals, tangents and bitangents are dropped: the shader doesn't light anything yet.
+struct PackedVertex {
+    uint16_t pos[4];
+    uint16_t uv[2];
+    uint8_t bones[4];
+    uint8_t weights[4];
+};
+static_assert(sizeof(PackedVertex) == 20, "PackedVertex is uploaded as raw bytes");
+
+inline uint16_t FloatToHalf(float f) {
+    uint32_t x;
+    std::memcpy(&x, &f, 4);
+    uint16_t sign = (uint16_t)((x >> 16) & 0x8000);
+    int exponent = (int)((x >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = x & 0x7FFFFF;
+    if (exponent <= 0) return sign;                              // too small: signed zero
+    if (exponent >= 31) return (uint16_t)(sign | 0x7C00);        // too large (or inf / nan): inf
+    uint16_t h = (uint16_t)(sign | (exponent << 10) | (mantissa >> 13));
+    return (uint16_t)(h + ((mantissa >> 12) & 1));               // round half up (carries into the exponent correctly)
+}
+
+// Average cache miss ratio: post-transform vertex cache misses per triangle for a FIFO of
+// `cacheSize` entries (0.5 is the best a regular grid mesh gets, 3 the worst)
+inline float VertexCacheAcmr(const std::vector<uint32_t>& indices, int cacheSize = 16) {
+    if (indices.size() < 3) return 0.0f;
+    std::vector<uint32_t> fifo(cacheSize, UINT32_MAX);
+    int head = 0, misses = 0;
+    for (uint32_t v : indices) {
+        if (std::find(fifo.begin(), fifo.end(), v) != fifo.end()) continue;
+        fifo[head] = v;
+        head = (head + 1) % cacheSize;
+        misses++;
+    }
+    return (float)misses / (indices.size() / 3);
+}
+
+// Reorder triangles for the post-transform vertex cache (Forsyth, "Linear-speed vertex cache
+// optimisation"): greedily emit the best-scoring triangle, preferring vertices recently used
+// (an LRU model of the cache) and vertices with few triangles left. Degenerate triangles (a
+// repeated vertex) draw nothing and would break the per-vertex triangle lists; they go last.
+inline std::vector<uint32_t> OptimizeVertexCache(const std::vector<uint32_t>& allIndices, uint32_t vertexCount) {
+    const int CACHE = 32;
+    std::vector<uint32_t> indices, degenerate;
+    indices.reserve(allIndices.size());
+    for (size_t i = 0; i + 2 < allIndices.size(); i += 3) {
+        const uint32_t* tri = &allIndices[i];
+        std::vector<uint32_t>& dst = (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2]) ? degenerate : indices;
+        dst.insert(dst.end(), tri, tri + 3);
+    }
+    const size_t triCount = indices.size() / 3;
+    std::vector<uint32_t> out;
+    out.reserve(allIndices.size());
+    if (triCount == 0) return degenerate;
+
+    auto vertexScore = [](int cachePos, int remaining) {
+        if (remaining == 0) return -1.0f;
+        float score = 0.0f;
+        if (cachePos >= 0) score = (cachePos < 3) ? 0.75f : std::pow(1.0f - (cachePos - 3) / float(CACHE - 3), 1.5f);
+        return score + 2.0f / std::sqrt((float)remaining);
+    };
+
+    std::vector<int> remaining(vertexCount, 0), cachePos(vertexCount, -1), triStart(vertexCount + 1, 0);
+    for (uint32_t v : indices) remaining[v]++;
+    for (uint32_t v = 0; v < vertexCount; v++) triStart[v + 1] = triStart[v] + remaining[v];
+    std::vector<uint32_t> vertTris(indices.size());
+    std::vector<int> fill(triStart.begin(), triStart.end() - 1);
+    for (size_t t = 0; t < triCount; t++)
+        for (int k = 0; k < 3; k++) vertTris[fill[indices[t * 3 + k]]++] = (uint32_t)t;
+
+    std::vector<float> vScore(vertexCount), tScore(triCount);
+    std::vector<bool> emitted(triCount, false);
+    for (uint32_t v = 0; v < vertexCount; v++) vScore[v] = vertexScore(-1, remaining[v]);
+    for (size_t t = 0; t < triCount; t++)
+        tScore[t] = vScore[indices[t * 3]] + vScore[indices[t * 3 + 1]] + vScore[indices[t * 3 + 2]];
+
+    std::vector<uint32_t> cache, next;
+    size_t scan = 0; // every triangle before this one is emitted
+    int best = -1;
+    for (size_t emittedCount = 0; emittedCount < triCount; emittedCount++) {
+        if (best < 0) { // nothing in the cache to continue from: the best of the rest
+            float bestScore = -FLT_MAX;
+            while (emitted[scan]) scan++;
+            for (size_t t = scan; t < triCount; t++)
+                if (!emitted[t] && tScore[t] > bestScore) { bestScore = tScore[t]; best = (int)t; }
+        }
+        emitted[best] = true;
+        next.clear();
+        for (int k = 0; k < 3; k++) {
+            uint32_t v = indices[best * 3 + k];
+            out.push_back(v);
+            next.push_back(v);
+            remaining[v]--;
+            // drop the triangle from v's list
+            for (int i = triStart[v]; i < triStart[v] + remaining[v] + 1; i++)
+                if (vertTris[i] == (uint32_t)best) { std::swap(vertTris[i], vertTris[triStart[v] + remaining[v]]); break; }
+        }
+        for (uint32_t v : cache)
+            if (std::find(next.begin(), next.end(), v) == next.end()) next.push_back(v);
+        for (size_t i = CACHE; i < next.size(); i++) { // fell out: rescore what they're in
+            uint32_t v = next[i];
+            cachePos[v] = -1;
+            vScore[v] = vertexScore(-1, remaining[v]);
+            for (int j = triStart[v]; j < triStart[v] + remaining[v]; j++) {
+                uint32_t t = vertTris[j];
+                tScore[t] = vScore[indices[t * 3]] + vScore[indices[t * 3 + 1]] + vScore[indices[t * 3 + 2]];
+            }
+        }
+        if (next.size() > (size_t)CACHE) next.resize(CACHE);
+        cache.swap(next);
+
+        // rescore the cached vertices and their triangles; the best of those comes next
+        for (int i = 0; i < (int)cache.size(); i++) {
+            cachePos[cache[i]] = i;
+            vScore[cache[i]] = vertexScore(i, remaining[cache[i]]);
+        }
+        best = -1;
+        float bestScore = -FLT_MAX;
+        for (uint32_t v : cache) {
+            for (int i = triStart[v]; i < triStart[v] + remaining[v]; i++) {
+                uint32_t t = vertTris[i];
+                tScore[t] = vScore[indices[t * 3]] + vScore[indices[t * 3 + 1]] + vScore[indices[t * 3 + 2]];
+                if (tScore[t] > bestScore) { bestScore = tScore[t]; best = (int)t; }
+            }
+        }
+    }
+    out.insert(out.end(), degenerate.begin(), degenerate.end());
+    return out;
+}
+
+// Renumber vertices in order of first use, so the vertex fetch walks the buffer forwards.
+// Fills `remap[old] = new` (UINT32_MAX for unreferenced vertices, which are dropped).
+inline uint32_t OptimizeVertexFetch(std::vector<uint32_t>& indices, uint32_t vertexCount, std::vector<uint32_t>& remap) {
+    remap.assign(vertexCount, UINT32_MAX);
+    uint32_t next = 0;
+    for (uint32_t& v : indices) {
+        if (remap[v] == UINT32_MAX) remap[v] = next++;
+        v = remap[v];
+    }
+    return next;
+}
+
+struct PackedMeshStats {
+    int vertices = 0, triangles = 0;
+    uint64_t bytesBefore = 0, bytesAfter = 0; // vertex + index buffers
+    float acmrBefore = 0.0f, acmrAfter = 0.0f;  // FIFO 16
+
+    void Add(const PackedMeshStats& o) {
+        float tris = (float)std::max(1, triangles + o.triangles);
+        acmrBefore = (acmrBefore * triangles + o.acmrBefore * o.triangles) / tris;
+        acmrAfter = (acmrAfter * triangles + o.acmrAfter * o.triangles) / tris;
+        vertices += o.vertices; triangles += o.triangles;
+        bytesBefore += o.bytesBefore; bytesAfter += o.bytesAfter;
+    }
+};
+
+// Cook step for a loaded skinned Model: every mesh's vertices are packed into PackedVertex,
+// its triangles reordered for the vertex cache and its vertices for fetch order, then
+// uploaded. The meshes' own VAOs (and the buffers behind them) are replaced, so Mesh::Draw,
+// ModelCuller and Crowd draw the packed data unchanged; Bind / Unbind the shader's
+// dequantization around those draws.
+//
+// The source is the Model's CPU copy (Model loads and uploads the fat format itself), so the
+// cook runs once at load; it takes a few milliseconds for the knight.
+class PackedModel {
+public:
+    explicit PackedModel(Model& model) {
+        const int boneCount = model.GetBoneCount();
+        m_Vertices.resize(model.meshes.size());
+        if (boneCount > 256) {
+            std::cout << "ERROR::PACKED_MESH: " << boneCount << " bones don't fit byte indices, keeping the float vertices\n";
+            return;
+        }
+        Aabb box{ glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+        for (const Mesh& mesh : model.meshes)
+            for (const Vertex& v : mesh.vertices) { box.min = glm::min(box.min, v.Position); box.max = glm::max(box.max, v.Position); }
+        if (box.min.x > box.max.x) return;
+        m_Offset = box.min;
+        m_Scale = glm::max(box.max - box.min, glm::vec3(1e-6f));
+
+        for (size_t i = 0; i < model.meshes.size(); i++) {
+            PackedMeshStats stats;
+            if (!Pack(model.meshes[i], m_Vertices[i], stats)) continue;
+            m_Stats.Add(stats);
+            m_Packed++;
+        }
+    }
+
+    PackedModel(const PackedModel&) = delete;
+    PackedModel& operator=(const PackedModel&) = delete;
+
+    ~PackedModel() {
+        for (GLuint vao : m_VAOs) glDeleteVertexArrays(1, &vao);
+        if (!m_Buffers.empty()) glDeleteBuffers((GLsizei)m_Buffers.size(), m_Buffers.data());
+    }
+
+    // before drawing the model's meshes with `shader` / after (leaves float positions on)
+    void Bind(Shader& shader) const {
+        shader.setInt("packedVertices", m_Packed > 0 ? 1 : 0);
+        shader.setVec3("positionScale", m_Scale);
+        shader.setVec3("positionOffset", m_Offset);
+    }
+    static void Unbind(Shader& shader) { shader.setInt("packedVertices", 0); }
+
+    int GetPackedCount() const { return m_Packed; }
+    // per Model mesh; empty for a mesh that wasn't packed. The CPU copy, in buffer order
+    const std::vector<PackedVertex>& GetVertices(int mesh) const { return m_Vertices[mesh]; }
+    const glm::vec3& GetPositionScale() const { return m_Scale; }
+    const glm::vec3& GetPositionOffset() const { return m_Offset; }
+    const PackedMeshStats& GetStats() const { return m_Stats; }
+    // largest position error the quantization introduces, model units
+    float GetMaxPositionError() const { return std::max(m_Scale.x, std::max(m_Scale.y, m_Scale.z)) / 65535.0f * 0.5f; }
+
+    void PrintReport(std::ostream& os = std::cout) const {
+        const PackedMeshStats& s = m_Stats;
+        os << "---- packed meshes (" << m_Packed << ") ----\n" << std::fixed << std::setprecision(2)
+           << "  " << s.vertices << " vertices, " << s.triangles << " triangles\n"
+           << "  bytes/vertex " << sizeof(Vertex) << " -> " << sizeof(PackedVertex)
+           << ", buffers " << s.bytesBefore / 1024 << " -> " << s.bytesAfter / 1024 << " KB\n"
+           << "  ACMR (FIFO 16) " << s.acmrBefore << " -> " << s.acmrAfter << "\n"
+           << "  max position error " << std::setprecision(5) << GetMaxPositionError() << "\n";
+    }
+
+private:
+    bool Pack(Mesh& mesh, std::vector<PackedVertex>& packed, PackedMeshStats& stats) {
+        const uint32_t vertexCount = (uint32_t)mesh.vertices.size();
+        if (vertexCount == 0 || mesh.indices.size() < 3) return false;
+        std::vector<uint32_t> indices(mesh.indices.begin(), mesh.indices.end());
+        stats.triangles = (int)(indices.size() / 3);
+        stats.bytesBefore = (uint64_t)vertexCount * sizeof(Vertex) + indices.size() * sizeof(uint32_t);
+        stats.acmrBefore = VertexCacheAcmr(indices);
+
+        indices = OptimizeVertexCache(indices, vertexCount);
+        std::vector<uint32_t> remap;
+        uint32_t used = OptimizeVertexFetch(indices, vertexCount, remap);
+        stats.acmrAfter = VertexCacheAcmr(indices);
+        stats.vertices = (int)used;
+
+        packed.assign(used, PackedVertex());
+        for (uint32_t v = 0; v < vertexCount; v++)
+            if (remap[v] != UINT32_MAX) packed[remap[v]] = PackVertex(mesh.vertices[v]);
+
+        // indices stay 32-bit: Mesh::Draw and Crowd::Draw draw GL_UNSIGNED_INT
+        GLuint vao = 0, buffers[2] = {};
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(2, buffers);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+        glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(PackedVertex), packed.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+        const GLsizei stride = sizeof(PackedVertex);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, pos));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, uv));
+        glEnableVertexAttribArray(5);
+        glVertexAttribIPointer(5, 4, GL_UNSIGNED_BYTE, stride, (void*)offsetof(PackedVertex, bones));
+        glEnableVertexAttribArray(6);
+        glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(PackedVertex, weights));
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        ReleaseMeshBuffers(mesh.VAO);
+        mesh.VAO = vao;
+        mesh.indices.assign(indices.begin(), indices.end()); // same count; Mesh::Draw reads the size
+        m_VAOs.push_back(vao);
+        m_Buffers.insert(m_Buffers.end(), buffers, buffers + 2);
+
+        stats.bytesAfter = (uint64_t)used * sizeof(PackedVertex) + indices.size() * sizeof(uint32_t);
+        return true;
+    }
+
+    PackedVertex PackVertex(const Vertex& v) const {
+        PackedVertex p = {};
+        glm::vec3 n = glm::clamp((v.Position - m_Offset) / m_Scale, glm::vec3(0.0f), glm::vec3(1.0f));
+        for (int c = 0; c < 3; c++) p.pos[c] = (uint16_t)std::lround(n[c] * 65535.0f);
+        p.uv[0] = FloatToHalf(v.TexCoords.x);
+        p.uv[1] = FloatToHalf(v.TexCoords.y);
+
+        // weights to 8 bits, the rounding remainder on the largest so they still sum to one
+        int sum = 0, largest = -1;
+        for (int i = 0; i < MAX_BONE_INFLUENCE && i < 4; i++) {
+            if (v.m_BoneIDs[i] < 0 || v.m_Weights[i] <= 0.0f) continue;
+            p.bones[i] = (uint8_t)std::min(v.m_BoneIDs[i], 255);
+            p.weights[i] = (uint8_t)std::lround(std::min(v.m_Weights[i], 1.0f) * 255.0f);
+            sum += p.weights[i];
+            if (largest < 0 || p.weights[i] > p.weights[largest]) largest = i;
+        }
+        if (largest >= 0 && sum != 255) p.weights[largest] = (uint8_t)std::min(std::max(p.weights[largest] + 255 - sum, 0), 255);
+        return p;
+    }
+
+    // the VAO's element and vertex buffers (Mesh keeps their names private), then the VAO
+    static void ReleaseMeshBuffers(GLuint vao) {
+        if (!vao) return;
+        GLint ebo = 0, vbo = 0;
+        glBindVertexArray(vao);
+        glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &ebo);
+        glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &vbo);
+        glBindVertexArray(0);
+        GLuint names[2] = { (GLuint)vbo, (GLuint)ebo };
+        glDeleteBuffers(2, names);
+        glDeleteVertexArrays(1, &vao);
+    }
+
+    glm::vec3 m_Scale{ 1.0f }, m_Offset{ 0.0f };
+    int m_Packed = 0;
+    PackedMeshStats m_Stats;
+    std::vector<std::vector<PackedVertex>> m_Vertices;
+    std::vector<GLuint> m_VAOs, m_Buffers;
+};
+
+#endif
@@ -0,0 +1,425 @@
+#ifndef POSE_BLEND_H
+#define POSE_BLEND_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include "animation_clip.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define POSE_BLEND_SSE 1
+#endif
+
+// Local (parent-relative) pose of a skeleton, structure-of-arrays: one float stream per
+// component, each padded to a multiple of 4 nodes so the blends below run 4 nodes per
+// SSE op. Padding lanes hold an identity transform so normalizing them is harmless.
+class LocalPose {
+public:
+    enum Stream { TX, TY, TZ, RX, RY, RZ, RW, SX, SY, SZ, STREAMS };
+
+    // setup only; everything else works in place
+    void Resize(int nodeCount) {
+        m_Count = nodeCount;
+        m_Stride = (nodeCount + 3) & ~3;
+        m_Data.assign((size_t)m_Stride * STREAMS, 0.0f);
+        SetIdentity();
+    }
+
+    void SetIdentity() {
+        std::fill(m_Data.begin(), m_Data.end(), 0.0f);
+        std::fill_n((*this)[RW], m_Stride, 1.0f);
+        std::fill_n((*this)[SX], 3 * m_Stride, 1.0f); // SX, SY, SZ are adjacent
+    }
+
+    // all zero, for AccumulatePose
+    void Clear() { std::fill(m_Data.begin(), m_Data.end(), 0.0f); }
+
+    // same-sized poses only (no reallocation)
+    void CopyFrom(const LocalPose& other) { std::copy(other.m_Data.begin(), other.m_Data.end(), m_Data.begin()); }
+    void Swap(LocalPose& other) { m_Data.swap(other.m_Data); std::swap(m_Count, other.m_Count); std::swap(m_Stride, other.m_Stride); }
+
+    int GetCount() const { return m_Count; }
+    int GetStride() const { return m_Stride; }
+    float* operator[](int stream) { return m_Data.data() + (size_t)stream * m_Stride; }
+    const float* operator[](int stream) const { return m_Data.data() + (size_t)stream * m_Stride; }
+
+    void Set(int node, const glm::vec3& t, const glm::quat& r, const glm::vec3& s) {
+        float* d = m_Data.data() + node;
+        d[TX * m_Stride] = t.x; d[TY * m_Stride] = t.y; d[TZ * m_Stride] = t.z;
+        d[RX * m_Stride] = r.x; d[RY * m_Stride] = r.y; d[RZ * m_Stride] = r.z; d[RW * m_Stride] = r.w;
+        d[SX * m_Stride] = s.x; d[SY * m_Stride] = s.y; d[SZ * m_Stride] = s.z;
+    }
+
+    // T * R * S, built the same way as AnimationClip::SampleTrack
+    glm::mat4 GetMatrix(int node) const {
+        const float* d = m_Data.data() + node;
+        glm::quat r(d[RW * m_Stride], d[RX * m_Stride], d[RY * m_Stride], d[RZ * m_Stride]);
+        glm::mat4 m = glm::mat4_cast(r);
+        m[0] *= d[SX * m_Stride];
+        m[1] *= d[SY * m_Stride];
+        m[2] *= d[SZ * m_Stride];
+        m[3] = glm::vec4(d[TX * m_Stride], d[TY * m_Stride], d[TZ * m_Stride], 1.0f);
+        return m;
+    }
+
+private:
+    std::vector<float> m_Data;
+    int m_Count = 0;
+    int m_Stride = 0;
+};
+
+// out = a..b at t: lerp for translation and scale, nlerp along the shorter arc for rotation.
+// Reference version; BlendPoses is the one to call.
+inline void BlendPosesScalar(const LocalPose& a, const LocalPose& b, float t, LocalPose& out) {
+    const int n = a.GetStride();
+    for (int s : { LocalPose::TX, LocalPose::TY, LocalPose::TZ, LocalPose::SX, LocalPose::SY, LocalPose::SZ }) {
+        const float* pa = a[s];
+        const float* pb = b[s];
+        float* po = out[s];
+        for (int i = 0; i < n; i++) po[i] = pa[i] + (pb[i] - pa[i]) * t;
+    }
+    for (int i = 0; i < n; i++) {
+        float dot = a[LocalPose::RX][i] * b[LocalPose::RX][i] + a[LocalPose::RY][i] * b[LocalPose::RY][i]
+                  + a[LocalPose::RZ][i] * b[LocalPose::RZ][i] + a[LocalPose::RW][i] * b[LocalPose::RW][i];
+        float tb = (dot < 0.0f) ? -t : t;
+        float r[4], len2 = 0.0f;
+        for (int c = 0; c < 4; c++) {
+            r[c] = a[LocalPose::RX + c][i] * (1.0f - t) + b[LocalPose::RX + c][i] * tb;
+            len2 += r[c] * r[c];
+        }
+        float inv = (len2 > 0.0f) ? 1.0f / std::sqrt(len2) : 0.0f;
+        for (int c = 0; c < 4; c++) out[LocalPose::RX + c][i] = r[c] * inv;
+    }
+}
+
+inline void BlendPoses(const LocalPose& a, const LocalPose& b, float t, LocalPose& out) {
+#ifdef POSE_BLEND_SSE
+    const int n = a.GetStride();
+    const __m128 vt = _mm_set1_ps(t);
+    const __m128 vs = _mm_set1_ps(1.0f - t);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    for (int s : { LocalPose::TX, LocalPose::TY, LocalPose::TZ, LocalPose::SX, LocalPose::SY, LocalPose::SZ }) {
+        const float* pa = a[s];
+        const float* pb = b[s];
+        float* po = out[s];
+        for (int i = 0; i < n; i += 4) {
+            __m128 va = _mm_loadu_ps(pa + i);
+            _mm_storeu_ps(po + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(pb + i), va), vt)));
+        }
+    }
+    for (int i = 0; i < n; i += 4) {
+        __m128 ax = _mm_loadu_ps(a[LocalPose::RX] + i), bx = _mm_loadu_ps(b[LocalPose::RX] + i);
+        __m128 ay = _mm_loadu_ps(a[LocalPose::RY] + i), by = _mm_loadu_ps(b[LocalPose::RY] + i);
+        __m128 az = _mm_loadu_ps(a[LocalPose::RZ] + i), bz = _mm_loadu_ps(b[LocalPose::RZ] + i);
+        __m128 aw = _mm_loadu_ps(a[LocalPose::RW] + i), bw = _mm_loadu_ps(b[LocalPose::RW] + i);
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)),
+                                _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+        // flip b's sign where the two are more than 180 degrees apart
+        __m128 tb = _mm_xor_ps(vt, _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), signBit));
+        __m128 rx = _mm_add_ps(_mm_mul_ps(ax, vs), _mm_mul_ps(bx, tb));
+        __m128 ry = _mm_add_ps(_mm_mul_ps(ay, vs), _mm_mul_ps(by, tb));
+        __m128 rz = _mm_add_ps(_mm_mul_ps(az, vs), _mm_mul_ps(bz, tb));
+        __m128 rw = _mm_add_ps(_mm_mul_ps(aw, vs), _mm_mul_ps(bw, tb));
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)),
+                                 _mm_add_ps(_mm_mul_ps(rz, rz), _mm_mul_ps(rw, rw)));
+        __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(len2, _mm_set1_ps(1e-20f))));
+        _mm_storeu_ps(out[LocalPose::RX] + i, _mm_mul_ps(rx, inv));
+        _mm_storeu_ps(out[LocalPose::RY] + i, _mm_mul_ps(ry, inv));
+        _mm_storeu_ps(out[LocalPose::RZ] + i, _mm_mul_ps(rz, inv));
+        _mm_storeu_ps(out[LocalPose::RW] + i, _mm_mul_ps(rw, inv));
+    }
+#else
+    BlendPosesScalar(a, b, t, out);
+#endif
+}
+
+// acc += w * src, rotations sign-aligned to what acc already holds. Start from Clear() and
+// finish with NormalizeRotations(): an n-way nlerp.
+inline void AccumulatePose(LocalPose& acc, const LocalPose& src, float w) {
+    const int n = acc.GetStride();
+    for (int s : { LocalPose::TX, LocalPose::TY, LocalPose::TZ, LocalPose::SX, LocalPose::SY, LocalPose::SZ }) {
+        const float* ps = src[s];
+        float* pa = acc[s];
+        for (int i = 0; i < n; i++) pa[i] += ps[i] * w;
+    }
+    float* ax = acc[LocalPose::RX]; float* ay = acc[LocalPose::RY]; float* az = acc[LocalPose::RZ]; float* aw = acc[LocalPose::RW];
+    const float* sx = src[LocalPose::RX]; const float* sy = src[LocalPose::RY]; const float* sz = src[LocalPose::RZ]; const float* sw = src[LocalPose::RW];
+    for (int i = 0; i < n; i++) {
+        float dot = ax[i] * sx[i] + ay[i] * sy[i] + az[i] * sz[i] + aw[i] * sw[i];
+        float ws = (dot < 0.0f) ? -w : w;
+        ax[i] += sx[i] * ws; ay[i] += sy[i] * ws; az[i] += sz[i] * ws; aw[i] += sw[i] * ws;
+    }
+}
+
+inline void NormalizeRotations(LocalPose& pose) {
+    const int n = pose.GetStride();
+    float* x = pose[LocalPose::RX]; float* y = pose[LocalPose::RY]; float* z = pose[LocalPose::RZ]; float* w = pose[LocalPose::RW];
+    for (int i = 0; i < n; i++) {
+        float len2 = x[i] * x[i] + y[i] * y[i] + z[i] * z[i] + w[i] * w[i];
+        if (len2 <= 0.0f) { x[i] = y[i] = z[i] = 0.0f; w[i] = 1.0f; continue; }
+        float inv = 1.0f / std::sqrt(len2);
+        x[i] *= inv; y[i] *= inv; z[i] *= inv; w[i] *= inv;
+    }
+}
+
+// Player animator with blending, in place of ClipAnimator's hard cuts:
+//  - Play(clip, fade) crossfades from the pose on screen (frozen at the moment of the
+//    switch) to the new clip, so a fade costs one clip sample plus one blend, not two samples;
+//  - the locomotion blend space mixes idle / walk / run / walk_backward / strafe_left /
+//    strafe_right from a character-space gait vector, with the cycles phase-synced so feet
+//    line up. At most five clips carry weight at once, and zero-weight clips aren't sampled.
+// Every clip is registered up front (AddClip / SetLocomotionClips), which sizes all pose
+// buffers, cursors and track maps; nothing is allocated per frame.
+class BlendAnimator {
+public:
+    static const int MAX_CLIPS = 16;
+    enum Locomotion { IDLE, WALK, RUN, WALK_BACKWARD, STRAFE_LEFT, STRAFE_RIGHT, LOCOMOTION_CLIPS };
+
+    // `skeleton`: the clip whose hierarchy (bound to the model) the poses are built on
+    explicit BlendAnimator(const AnimationClip* skeleton) : m_Skeleton(skeleton) {
+        int nodeCount = skeleton->GetNodeCount();
+        for (LocalPose* pose : { &m_Bind, &m_Target, &m_From, &m_Output, &m_Scratch })
+            pose->Resize(nodeCount);
+        m_GlobalTransforms.assign(nodeCount, glm::mat4(1.0f));
+        m_FinalBoneMatrices.assign(skeleton->GetBoneCount(), glm::mat4(1.0f));
+
+        const std::vector<glm::mat4>& bind = skeleton->GetNodeBindLocal();
+        for (int i = 0; i < nodeCount; i++) {
+            glm::vec3 scale(glm::length(glm::vec3(bind[i][0])), glm::length(glm::vec3(bind[i][1])), glm::length(glm::vec3(bind[i][2])));
+            glm::mat3 rotation(glm::vec3(bind[i][0]) / scale.x, glm::vec3(bind[i][1]) / scale.y, glm::vec3(bind[i][2]) / scale.z);
+            m_Bind.Set(i, glm::vec3(bind[i][3]), glm::normalize(glm::quat_cast(rotation)), scale);
+        }
+        m_Output.CopyFrom(m_Bind);
+        std::fill(std::begin(m_LocomotionSlots), std::end(m_LocomotionSlots), -1);
+    }
+
+    // setup only: register a clip; returns its slot (or the existing one), -1 if full
+    int AddClip(const AnimationClip* clip) {
+        if (!clip) return -1;
+        int existing = FindSlot(clip);
+        if (existing >= 0 || m_SlotCount == MAX_CLIPS) return existing;
+
+        Slot& slot = m_Slots[m_SlotCount];
+        slot.clip = clip;
+        slot.time = 0.0f;
+        slot.cursors.assign(clip->GetTracks().size(), TrackCursor());
+        // skeleton node -> this clip's track, by name (-1 = hold the bind pose)
+        slot.nodeTrack.assign(m_Skeleton->GetNodeCount(), -1);
+        for (int i = 0; i < m_Skeleton->GetNodeCount(); i++)
+            slot.nodeTrack[i] = clip->FindTrack(m_Skeleton->GetNodeNames()[i]);
+
+        if (clip->GetBoneCount() > (int)m_FinalBoneMatrices.size())
+            m_FinalBoneMatrices.resize(clip->GetBoneCount(), glm::mat4(1.0f));
+        return m_SlotCount++;
+    }
+
+    // setup only; any clip may be null (that direction then falls back to its neighbours)
+    void SetLocomotionClips(const AnimationClip* idle, const AnimationClip* walk, const AnimationClip* run,
+                            const AnimationClip* walkBackward, const AnimationClip* strafeLeft, const AnimationClip* strafeRight) {
+        const AnimationClip* clips[LOCOMOTION_CLIPS] = { idle, walk, run, walkBackward, strafeLeft, strafeRight };
+        for (int i = 0; i < LOCOMOTION_CLIPS; i++) m_LocomotionSlots[i] = AddClip(clips[i]);
+    }
+
+    // crossfade to a registered clip (looping, or holding its last frame)
+    void Play(const AnimationClip* clip, float fadeSeconds, bool loop = true) {
+        int slot = FindSlot(clip);
+        if (slot < 0) return;
+        BeginFade(fadeSeconds);
+        m_Current = slot;
+        m_Loop = loop;
+        m_Slots[slot].time = 0.0f;
+    }
+
+    // crossfade to the locomotion blend space; no-op if already there
+    void PlayLocomotion(float fadeSeconds) {
+        if (m_Current == LOCOMOTION) return;
+        BeginFade(fadeSeconds);
+        m_Current = LOCOMOTION;
+        m_Phase = 0.0f;
+    }
+
+    bool IsInLocomotion() const { return m_Current == LOCOMOTION; }
+
+    // Character-space gait, x = right, y = forward. Length 0 = idle, 1 = walk, 2 = run
+    // (run is forward only; sideways/backwards stay on the walk clips). Smoothed over time.
+    void SetLocomotionInput(const glm::vec2& gait) { m_GaitTarget = gait; }
+    glm::vec2 GetLocomotionInput() const { return m_Gait; }
+
+    void UpdateAnimation(float dt) {
+        m_Gait += (m_GaitTarget - m_Gait) * std::min(1.0f, dt * GAIT_DAMPING);
+
+        if (m_Current == LOCOMOTION) SampleLocomotion(dt, m_Target);
+        else if (m_Current >= 0) {
+            Slot& slot = m_Slots[m_Current];
+            slot.time += slot.clip->GetTicksPerSecond() * dt;
+            float duration = slot.clip->GetDuration();
+            if (duration > 0.0f) slot.time = m_Loop ? std::fmod(slot.time, duration) : std::min(slot.time, duration);
+            SampleSlot(slot, m_Target);
+        }
+        else m_Target.CopyFrom(m_Bind);
+
+        if (m_FadeDuration > 0.0f) {
+            m_FadeElapsed += dt;
+            float f = std::min(m_FadeElapsed / m_FadeDuration, 1.0f);
+            BlendPoses(m_From, m_Target, f, m_Output);
+            if (f >= 1.0f) m_FadeDuration = 0.0f;
+        }
+        else m_Output.Swap(m_Target);
+
+        Compose();
+    }
+
+    const std::vector<glm::mat4>& GetFinalBoneMatrices() const { return m_FinalBoneMatrices; }
+    const std::vector<glm::mat4>& GetGlobalTransforms() const { return m_GlobalTransforms; }
+    const LocalPose& GetLocalPose() const { return m_Output; }
+    // clip being played, or nullptr in the blend space
+    const AnimationClip* GetCurrentClip() const { return m_Current >= 0 ? m_Slots[m_Current].clip : nullptr; }
+
+private:
+    static const int LOCOMOTION = -2;
+    static constexpr float GAIT_DAMPING = 8.0f; // 1/s
+    static constexpr float MIN_WEIGHT = 1e-3f;
+
+    struct Slot {
+        const AnimationClip* clip = nullptr;
+        float time = 0.0f; // ticks
+        std::vector<TrackCursor> cursors;
+        std::vector<int> nodeTrack;
+    };
+
+    int FindSlot(const AnimationClip* clip) const {
+        for (int i = 0; i < m_SlotCount; i++)
+            if (m_Slots[i].clip == clip) return i;
+        return -1;
+    }
+
+    void BeginFade(float fadeSeconds) {
+        if (fadeSeconds <= 0.0f) { m_FadeDuration = 0.0f; return; }
+        m_From.CopyFrom(m_Output); // freeze what's on screen now
+        m_FadeDuration = fadeSeconds;
+        m_FadeElapsed = 0.0f;
+    }
+
+    void SampleSlot(Slot& slot, LocalPose& out) {
+        const int nodeCount = m_Skeleton->GetNodeCount();
+        glm::vec3 t, s;
+        glm::quat r;
+        for (int i = 0; i < nodeCount; i++) {
+            int track = slot.nodeTrack[i];
+            if (track < 0) {
+                for (int c = 0; c < LocalPose::STREAMS; c++) out[c][i] = m_Bind[c][i];
+                continue;
+            }
+            slot.clip->SampleTrackTRS(track, slot.time, &slot.cursors[track], t, r, s);
+            out.Set(i, t, r, s);
+        }
+    }
+
+    // blend-space weights for the current gait (sum 1)
+    void LocomotionWeights(float weights[LOCOMOTION_CLIPS]) const {
+        std::fill(weights, weights + LOCOMOTION_CLIPS, 0.0f);
+        float speed = glm::length(m_Gait);
+        float moving = std::min(speed, 1.0f);
+        weights[IDLE] = 1.0f - moving;
+        if (speed > 1e-4f) {
+            glm::vec2 dir = m_Gait / speed;
+            float fwd = std::max(dir.y, 0.0f), back = std::max(-dir.y, 0.0f);
+            float right = std::max(dir.x, 0.0f), left = std::max(-dir.x, 0.0f);
+            float sum = fwd + back + right + left;
+            float run = glm::clamp(speed - 1.0f, 0.0f, 1.0f);
+            weights[WALK] = moving * fwd / sum * (1.0f - run);
+            weights[RUN] = moving * fwd / sum * run;
+            weights[WALK_BACKWARD] = moving * back / sum;
+            weights[STRAFE_LEFT] = moving * left / sum;
+            weights[STRAFE_RIGHT] = moving * right / sum;
+        }
+
+        // directions without a clip hand their weight to the walk (or idle) clip
+        for (int i = RUN; i < LOCOMOTION_CLIPS; i++) {
+            if (m_LocomotionSlots[i] >= 0 || weights[i] == 0.0f) continue;
+            weights[(i == RUN && m_LocomotionSlots[WALK] >= 0) ? WALK : IDLE] += weights[i];
+            weights[i] = 0.0f;
+        }
+        if (m_LocomotionSlots[WALK] < 0) { weights[IDLE] += weights[WALK]; weights[WALK] = 0.0f; }
+    }
+
+    void SampleLocomotion(float dt, LocalPose& out) {
+        float weights[LOCOMOTION_CLIPS];
+        LocomotionWeights(weights);
+
+        // moving cycles share one normalized phase, advanced at their weighted mean length
+        float cycleWeight = 0.0f, cycleSeconds = 0.0f;
+        for (int i = WALK; i < LOCOMOTION_CLIPS; i++) {
+            if (weights[i] <= 0.0f) continue;
+            const AnimationClip* clip = m_Slots[m_LocomotionSlots[i]].clip;
+            if (clip->GetTicksPerSecond() <= 0.0f) continue;
+            cycleWeight += weights[i];
+            cycleSeconds += weights[i] * clip->GetDuration() / clip->GetTicksPerSecond();
+        }
+        if (cycleWeight > 0.0f && cycleSeconds > 0.0f)
+            m_Phase = std::fmod(m_Phase + dt * cycleWeight / cycleSeconds, 1.0f);
+
+        int used = 0;
+        for (int i = 0; i < LOCOMOTION_CLIPS; i++) {
+            if (weights[i] < MIN_WEIGHT || m_LocomotionSlots[i] < 0) weights[i] = 0.0f;
+            else used++;
+        }
+        if (used == 0) { out.CopyFrom(m_Bind); return; }
+
+        if (used > 1) out.Clear();
+        for (int i = 0; i < LOCOMOTION_CLIPS; i++) {
+            if (weights[i] == 0.0f) continue;
+            Slot& slot = m_Slots[m_LocomotionSlots[i]];
+            float duration = slot.clip->GetDuration();
+            if (i == IDLE) {
+                // idle isn't a stride cycle: it keeps its own clock
+                slot.time += slot.clip->GetTicksPerSecond() * dt;
+                if (duration > 0.0f) slot.time = std::fmod(slot.time, duration);
+            }
+            else slot.time = m_Phase * duration;
+
+            if (used == 1) { SampleSlot(slot, out); break; }
+            SampleSlot(slot, m_Scratch);
+            AccumulatePose(out, m_Scratch, weights[i]);
+        }
+        if (used > 1) NormalizeRotations(out);
+    }
+
+    // local pose -> global -> skinning matrices, one pass in hierarchy order
+    void Compose() {
+        const int nodeCount = m_Skeleton->GetNodeCount();
+        const int* parents = m_Skeleton->GetNodeParents().data();
+        const int* bones = m_Skeleton->GetNodeBones().data();
+        const glm::mat4* offsets = m_Skeleton->GetNodeOffsets().data();
+        int boneCount = (int)m_FinalBoneMatrices.size();
+
+        for (int i = 0; i < nodeCount; i++) {
+            glm::mat4 local = m_Output.GetMatrix(i);
+            m_GlobalTransforms[i] = (parents[i] >= 0) ? m_GlobalTransforms[parents[i]] * local : local;
+            if (bones[i] >= 0 && bones[i] < boneCount)
+                m_FinalBoneMatrices[bones[i]] = m_GlobalTransforms[i] * offsets[i];
+        }
+    }
+
+    const AnimationClip* m_Skeleton;
+    Slot m_Slots[MAX_CLIPS];
+    int m_SlotCount = 0;
+    int m_LocomotionSlots[LOCOMOTION_CLIPS];
+
+    int m_Current = -1; // slot, LOCOMOTION, or -1 (bind pose)
+    bool m_Loop = true;
+    float m_Phase = 0.0f;
+    glm::vec2 m_Gait{ 0.0f }, m_GaitTarget{ 0.0f };
+    float m_FadeDuration = 0.0f, m_FadeElapsed = 0.0f;
+
+    LocalPose m_Bind, m_Target, m_From, m_Output, m_Scratch;
+    std::vector<glm::mat4> m_GlobalTransforms;
+    std::vector<glm::mat4> m_FinalBoneMatrices;
+};
+
+#endif
@@ -0,0 +1,13 @@
+#version 330 core
+layout(location = 0) in vec2 aPos;   // pixels, origin top-left
+layout(location = 1) in vec4 aColor;
+
+uniform vec2 screenSize;
+
+out vec4 Color;
+
+void main()
+{
+    Color = aColor;
+    gl_Position = vec4(aPos.x / screenSize.x * 2.0 - 1.0, 1.0 - aPos.y / screenSize.y * 2.0, 0.0, 1.0);
+}
@@ -11,8 +11,41 @@
 #include <learnopengl/animator.h>
 #include <learnopengl/model_animation.h>
 
+#include "animation_clip.h"
+#include "clip_animator.h"
+#include "clip_cache.h"
+#include "asset_loader.h"
+#include "texture_cache.h"
+#include "bone_palette.h"
+#include "anim_bench.h"
+#include "crowd.h"
+#include "collision_world.h"
+#include "bone_hitbox.h"
+#include "debug_draw.h"
+#include "terrain.h"
+#include "mesh_culling.h"
+#include "packed_mesh.h"
+#include "skin_cache.h"
+#include "pose_blend.h"
+#include "input_replay.h"
+#define HEADLESS_BENCH_IMPLEMENTATION // --bench-sim's counting operator new (with HEADLESS_BENCH_COUNT_ALLOCS), defined once here
+#include "headless_bench.h"
+#include "frame_profiler.h"
+#include "frame_packet.h"
+#include "input_events.h"
+
 #include <iostream>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <map>
+#include <thread>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
@@ -21,12 +54,19 @@
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 
 // ---------- Settings ----------
 const unsigned int SCR_WIDTH = 1280;
 const unsigned int SCR_HEIGHT = 720;
 const float PLAYER_JUMP_SPEED = 5.0f;
 const float PLAYER_GRAVITY = -9.8f * 2.0f; // stronger gravity for snappier jump
+const float LOOP_FADE = 0.2f;      // s, crossfade into looping animations / locomotion
+const float ONE_SHOT_FADE = 0.1f;  // s, crossfade into roll / attack / jump
+const float SIM_HZ = 60.0f;        // simulation ticks per second, whatever the frame rate
+const float SIM_DT = 1.0f / SIM_HZ;
+const float SIM_MAX_FRAME = 0.25f; // s of frame time simulated at most per frame
 
 // ---------- Player / Camera ----------
 struct Player {
@@ -67,26 +107,58 @@ struct Hitbox {
             std::abs(center.y - other.center.y) <= (halfExtents.y + other.halfExtents.y) &&
             std::abs(center.z - other.center.z) <= (halfExtents.z + other.halfExtents.z);
     }
+    Aabb bounds() const { return Aabb::FromCenter(center, halfExtents); }
 };
 
 Hitbox playerHitbox;
-GLuint hitboxVAO = 0, hitboxVBO = 0, hitboxEBO = 0;
-Shader* hitboxShader = nullptr;
+// every character's hitbox, for queries at scale (see collision_world.h)
+enum CollisionLayer : uint32_t { COLLIDE_PLAYER = 1u << 0, COLLIDE_CHARACTER = 1u << 1 };
+CollisionWorld* gCollision = nullptr;
+int playerCollider = -1;
+// pose-driven hit volumes (see bone_hitbox.h): the player's hurt capsules, the attack's
+// pre-sampled sword sweep, and who the current swing has hit
+BoneHitboxes* gPlayerVolumes = nullptr;
+const AttackSweep* gAttackSweep = nullptr;
+std::vector<int> attackHits;
+std::vector<int> attackCandidates; // query scratch
 
 // ---------- Timing ----------
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// player pose at the previous tick, for interpolating the render between ticks
+struct SimSnapshot {
+    glm::vec3 pos{ 0.0f };
+    float yawDeg = 0.0f;
+};
+// what the window thread sampled for a simulation frame besides the input events: the orbit
+// camera (the mouse callbacks move it) and the hitbox view toggle
+struct InputSnapshot {
+    OrbitCam cam;
+    bool showHitbox = true;
+};
+InputReplay* gReplay = nullptr; // --replay: input comes from a recording, the mouse doesn't turn the camera
+
 // ---------- Mouse state ----------
 bool firstMouse = true;
 double lastX = SCR_WIDTH / 2.0;
 double lastY = SCR_HEIGHT / 2.0;
 
+// ---------- Input events ----------
+// keys / buttons as timestamped events (see input_events.h), from the GLFW callbacks to the
+// simulation. Movement keys ride as bits above the InputButton ones until they become moveX / moveY.
+enum MoveBit : uint32_t { MOVE_FORWARD = 1u << 16, MOVE_BACK = 1u << 17, MOVE_RIGHT = 1u << 18, MOVE_LEFT = 1u << 19 };
+const uint32_t MOVE_BITS = MOVE_FORWARD | MOVE_BACK | MOVE_RIGHT | MOVE_LEFT;
+InputEventQueue gInputEvents;
+
 // ---------- Input edges ----------
 bool prevLMB = false;
 bool prevSpace = false;
 bool prevE = false; // jump key edge
 bool prevShift = false; // run key edge
+bool prevH = false; // hitbox toggle edge (render side, not simulated)
+bool prevF3 = false, prevF4 = false; // profiler overlay / trace dump edges
+bool prevF5 = false; // occlusion query toggle edge
 
 // ---------- Animation State ----------
 enum class ActionState { Idle, Moving, Running, Rolling, Attacking, Jumping };
@@ -96,47 +168,59 @@ float actionTimeLeft = 0.0f;
 // ---------- GL / Content ----------
 Shader* gShader = nullptr;
 Model* gModel = nullptr;
+BonePaletteBuffer* gBonePalette = nullptr;
+const int BONE_PALETTE_UNIT = 8; // texture unit for the palette TBO, above the ones Mesh::Draw uses
+const int BAKED_PALETTE_UNIT = 9; // --crowd-baked clips (see baked_palette.h)
+
+const AnimationClip* gIdle = nullptr, * gWalk = nullptr, * gRun = nullptr, * gRoll = nullptr, * gAttack = nullptr, * gJump = nullptr;
+BlendAnimator* gAnimator = nullptr;
+Crowd* gCrowd = nullptr; // --crowd N (see crowd.h)
+JobSystem* gJobs = nullptr; // per-frame animation jobs (see job_system.h)
+FrameProfiler* gProfiler = nullptr; // stage timings; F3 overlay, F4 trace dump (see frame_profiler.h)
+
+// clips under resources/objects/models/, cooked to <name>.dae.clip (see clip_cache.h)
+const char* const CLIP_NAMES[] = {
+    "idle", "walk", "walk_backward", "run", "strafe_left", "strafe_right", "roll", "attack", "jump"
+};
 
-Animation* gIdle = nullptr, * gWalk = nullptr, * gRun = nullptr, * gRoll = nullptr, * gAttack = nullptr, * gJump = nullptr;
-Animator* gAnimator = nullptr;
-
-// Ground geometry
-GLuint groundVAO = 0, groundVBO = 0, groundEBO = 0;
+// Ground: streamed height-map chunks (see terrain.h)
+TerrainHeights* gTerrain = nullptr;
 unsigned int groundTex = 0; // id for ground texture
+const float GROUND_SNAP = 0.5f; // m: a grounded player follows the terrain down steps up to this, deeper drops are falls
 
 // ----- helpers -----
 static inline float radiansf(float d) { return d * 0.017453292519943295f; }
 
-void PlayLoop(Animation* anim) {
-    gAnimator->PlayAnimation(anim);
+std::string ClipPath(const std::string& name) {
+    return FileSystem::getPath("resources/objects/models/" + name + ".dae");
+}
+
+// idle / walk / run all live in the locomotion blend space; the gait input picks the mix
+void PlayLoop(const AnimationClip* anim) {
+    if (anim == gIdle || anim == gWalk || anim == gRun) gAnimator->PlayLocomotion(LOOP_FADE);
+    else gAnimator->Play(anim, LOOP_FADE, true);
 }
-void PlayOneShot(Animation* anim, float& outSec) {
-    gAnimator->PlayAnimation(anim);
+void PlayOneShot(const AnimationClip* anim, float& outSec) {
+    gAnimator->Play(anim, ONE_SHOT_FADE, false);
     float durTicks = anim->GetDuration();
     float tps = anim->GetTicksPerSecond();
     outSec = (tps > 0.0f) ? durTicks / tps : 0.7f; // fallback
 }
 
 // เวกเตอร์ forward/right “ตามกล้อง” (ใช้กับ WASD)
-glm::vec3 CameraForward() {
-    float yaw = radiansf(cam.yawDeg);
-    float pit = radiansf(cam.pitchDeg);
-    glm::vec3 f;
-    f.x = std::cos(pit) * std::sin(yaw);
-    f.y = std::sin(pit);
-    f.z = std::cos(pit) * std::cos(yaw);
-    // ใช้เฉพาะบนระนาบ XZ สำหรับทิศเดิน
-    f.y = 0.0f;
-    if (glm::length(f) < 1e-6f) f = glm::vec3(0, 0, 1);
+// only the yaw matters on the XZ plane; pitch isn't part of the recorded input, so it must not leak in
+glm::vec3 CameraForward(float yawDeg) {
+    float yaw = radiansf(yawDeg);
+    glm::vec3 f(std::sin(yaw), 0.0f, std::cos(yaw));
     return glm::normalize(f);
 }
-glm::vec3 CameraRight() {
-    glm::vec3 f = CameraForward();
+glm::vec3 CameraRight(float yawDeg) {
+    glm::vec3 f = CameraForward(yawDeg);
     return glm::normalize(glm::cross(f, glm::vec3(0, 1, 0)));
 }
 
 // กล้อง: คำนวณตำแหน่งและ view
-void ComputeCamera(glm::vec3& outPos, glm::mat4& outView) {
+void ComputeCamera(const OrbitCam& cam, const glm::vec3& playerPos, glm::vec3& outPos, glm::mat4& outView) {
     // ทิศทางกล้องเต็ม (รวม pitch)
     float yaw = radiansf(cam.yawDeg);
     float pit = radiansf(cam.pitchDeg);
@@ -145,130 +229,634 @@ void ComputeCamera(glm::vec3& outPos, glm::mat4& outView) {
     dir.y = std::sin(pit);
     dir.z = std::cos(pit) * std::cos(yaw);
 
-    glm::vec3 target = player.pos + glm::vec3(0, player.height + cam.lookOffset, 0);
+    glm::vec3 target = playerPos + glm::vec3(0, player.height + cam.lookOffset, 0);
     outPos = target - dir * cam.distance + glm::vec3(0, cam.height, 0);
     outView = glm::lookAt(outPos, target, glm::vec3(0, 1, 0));
 }
 
-// สร้างพื้นเป็นสี่เหลี่ยมใหญ่ (ตำแหน่ง, นอร์มัล, เท็กซ์โค)
-void CreateGround() {
-    const float S = 100.0f; // ครึ่งหนึ่ง (รวมคือ 200x200)
-    // pos(x,y,z) normal(x,y,z) tex(u,v)
-    float verts[] = {
-        -S, 0.0f, -S,   0,1,0,   0.0f, 0.0f,
-         S, 0.0f, -S,   0,1,0,  50.0f, 0.0f,
-         S, 0.0f,  S,   0,1,0,  50.0f,50.0f,
-        -S, 0.0f,  S,   0,1,0,   0.0f,50.0f
-    };
-    unsigned int idx[] = { 0,1,2,  0,2,3 };
-
-    glGenVertexArrays(1, &groundVAO);
-    glGenBuffers(1, &groundVBO);
-    glGenBuffers(1, &groundEBO);
-
-    glBindVertexArray(groundVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, groundVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, groundEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(idx), idx, GL_STATIC_DRAW);
-
-    // สมมติ anim_model.vs ใช้ layout:
-    // location 0: position, 1: normal, 2: texcoord
-    GLsizei stride = (3 + 3 + 2) * sizeof(float);
-    glEnableVertexAttribArray(0); glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
-    glEnableVertexAttribArray(1); glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2); glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
-
-    glBindVertexArray(0);
+// height of the ground under (x, z); flat without a terrain
+float GroundHeight(float x, float z) {
+    return gTerrain ? gTerrain->HeightAt(x, z) : 0.0f;
+}
+
+// cooked chunks under resources/terrain; any chunk without a file is generated
+TerrainSource MakeTerrainSource() {
+    TerrainSource source;
+    source.directory = FileSystem::getPath("resources/terrain");
+    return source;
 }
 
 // load a 2D texture from path and return GL id (0 on fail)
+// (synchronous; startup goes through LoadTextureAsync instead)
 unsigned int LoadTexture(const std::string& path) {
-    int width, height, nrChannels;
     // stbi flip already set in main
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
-    if (!data) {
-        std::cout << "Failed to load texture: " << path << "\n";
-        return 0;
+    return UploadTexture(DecodeImage(path));
+}
+
+// Swap the Model's textures for cooked ones (see texture_cache.h) where a fresh .tex exists.
+// Model decodes its images itself while it parses; the stb_image copies are freed as the
+// compressed ones arrive.
+void StreamModelTextures(TextureStreamer& streamer, Model& model) {
+    for (const Texture& loaded : model.textures_loaded) {
+        unsigned int old = loaded.id;
+        streamer.Request(model.directory + "/" + loaded.path, [&model, old](unsigned int tex) {
+            for (Mesh& mesh : model.meshes)
+                for (Texture& t : mesh.textures)
+                    if (t.id == old) t.id = tex;
+            for (Texture& t : model.textures_loaded)
+                if (t.id == old) t.id = tex;
+            glDeleteTextures(1, &old);
+        });
     }
+}
 
-    GLenum format = GL_RGB;
-    if (nrChannels == 1) format = GL_RED;
-    else if (nrChannels == 3) format = GL_RGB;
-    else if (nrChannels == 4) format = GL_RGBA;
+// one tick's InputFrame: the held / pressed bits after the events up to the tick's end
+InputFrame TickInput(const InputTicker& ticker, float camYawDeg, double time) {
+    InputFrame in;
+    uint32_t held = ticker.GetHeld();
+    in.time = (float)time;
+    in.moveY = ((held & MOVE_FORWARD) ? 1.0f : 0.0f) - ((held & MOVE_BACK) ? 1.0f : 0.0f);
+    in.moveX = ((held & MOVE_RIGHT) ? 1.0f : 0.0f) - ((held & MOVE_LEFT) ? 1.0f : 0.0f);
+    in.camYawDeg = camYawDeg;
+    in.buttons = held & ~MOVE_BITS;
+    in.pressed = ticker.GetPressed() & ~MOVE_BITS;
+    return in;
+}
 
-    unsigned int tex;
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
+// One fixed simulation step: state machine, gravity, movement, hitbox and the player's pose.
+// Reads nothing but `in`, so a recorded input stream replays exactly.
+void SimulateTick(const InputFrame& in, float dt) {
+    glm::vec2 move(in.moveX, in.moveY);
+    bool rollHeld = in.Held(INPUT_ROLL);
+    bool attackHeld = in.Held(INPUT_ATTACK);
+    bool jumpHeld = in.Held(INPUT_JUMP);
+    bool runHeld = in.Held(INPUT_RUN);
+    // a press is a new hold, or a tap the input events caught between two ticks
+    bool rollPressed = in.Pressed(INPUT_ROLL) || (rollHeld && !prevSpace);
+    bool attackPressed = in.Pressed(INPUT_ATTACK) || (attackHeld && !prevLMB);
+    bool jumpPressed = in.Pressed(INPUT_JUMP) || (jumpHeld && !prevE);
+
+    // ===== STATE MACHINE =====
+    if (state == ActionState::Rolling || state == ActionState::Attacking) {
+        actionTimeLeft -= dt;
+        if (actionTimeLeft <= 0.0f) {
+            if (glm::length(move) > 0.0f) {
+                if (runHeld) { state = ActionState::Running; PlayLoop(gRun); }
+                else { state = ActionState::Moving; PlayLoop(gWalk); }
+            }
+            else {
+                state = ActionState::Idle;   PlayLoop(gIdle);
+            }
+        }
+    }
+    else if (state == ActionState::Jumping)
+    {
+        // landing handled by gravity block below; keep playing jump until landed
+        if (player.isGrounded)
+        {
+            // landed this frame
+            if (glm::length(move) > 0.0f) {
+                if (runHeld) { state = ActionState::Running; PlayLoop(gRun); }
+                else { state = ActionState::Moving; PlayLoop(gWalk); }
+            }
+            else { state = ActionState::Idle; PlayLoop(gIdle); }
+        }
+    }
+    else {
+        if (jumpPressed && player.isGrounded) {
+            // start jump
+            state = ActionState::Jumping;
+            PlayOneShot(gJump, actionTimeLeft);
+            player.yVelocity = PLAYER_JUMP_SPEED;
+            player.isGrounded = false;
+        }
+        else if (rollPressed) {
+            state = ActionState::Rolling;  PlayOneShot(gRoll, actionTimeLeft);
+        }
+        else if (attackPressed) {
+            state = ActionState::Attacking; PlayOneShot(gAttack, actionTimeLeft);
+            attackHits.clear();
+        }
+        else {
+            // If moving and holding shift -> running
+            if (glm::length(move) > 0.0f) {
+                if (runHeld) {
+                    if (state != ActionState::Running) { state = ActionState::Running; PlayLoop(gRun); }
+                }
+                else {
+                    if (state != ActionState::Moving) { state = ActionState::Moving; PlayLoop(gWalk); }
+                }
+            }
+            else {
+                if (state != ActionState::Idle) { state = ActionState::Idle;   PlayLoop(gIdle); }
+            }
+        }
+    }
 
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    // ===== GRAVITY / JUMP =====
+    if (!player.isGrounded)
+    {
+        player.yVelocity += PLAYER_GRAVITY * dt;
+        player.pos.y += player.yVelocity * dt;
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        float groundY = GroundHeight(player.pos.x, player.pos.z);
+        if (player.pos.y <= groundY)
+        {
+            player.pos.y = groundY;
+            player.yVelocity = 0.0f;
+            player.isGrounded = true;
+            // state change handled at top of loop (or force here)
+            if (state == ActionState::Jumping) {
+                if (glm::length(move) > 0.0f) {
+                    if (runHeld) { state = ActionState::Running; PlayLoop(gRun); }
+                    else { state = ActionState::Moving; PlayLoop(gWalk); }
+                }
+                else { state = ActionState::Idle; PlayLoop(gIdle); }
+            }
+        }
+    }
 
-    stbi_image_free(data);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    return tex;
-}
+    // ===== MOVEMENT =====
+    glm::vec3 camF = CameraForward(in.camYawDeg);
+    glm::vec3 camR = CameraRight(in.camYawDeg);
+    glm::vec3 wishDir = glm::vec3(0.0f);
+    if (glm::length(move) > 1e-6f) {
+        wishDir = glm::normalize(camF * move.y + camR * move.x);
+        if (glm::any(glm::isnan(wishDir))) wishDir = glm::vec3(0);
+    }
 
-void CreateHitboxMesh() {
-    float verts[] = {
-        // 8 corner points of unit cube centered at origin
-        -0.5f,-0.5f,-0.5f,  0.5f,-0.5f,-0.5f,  0.5f,0.5f,-0.5f,  -0.5f,0.5f,-0.5f,
-        -0.5f,-0.5f,0.5f,   0.5f,-0.5f,0.5f,   0.5f,0.5f,0.5f,   -0.5f,0.5f,0.5f
-    };
-    unsigned int idx[] = {
-        0,1, 1,2, 2,3, 3,0, // bottom
-        4,5, 5,6, 6,7, 7,4, // top
-        0,4, 1,5, 2,6, 3,7  // sides
-    };
+    if (state == ActionState::Moving || state == ActionState::Idle || state == ActionState::Jumping || state == ActionState::Running) {
+        float spd = 0.0f;
+        if (state == ActionState::Moving) spd = player.moveSpeed;
+        else if (state == ActionState::Running) spd = player.runSpeed;
+        else spd = 0.0f;
+        // allow limited air-control while jumping
+        if (state == ActionState::Jumping) spd *= 0.6f;
+        player.pos += wishDir * spd * dt;
+
+        if (in.Held(INPUT_STRAFE)) {
+            player.yawDeg = in.camYawDeg; // keep facing the camera; walk_backward / strafe clips take over
+        }
+        else if (glm::length(wishDir) > 0.0f) {
+            // หันตัวละครไปทิศการเคลื่อนที่ (souls-like)
+            player.yawDeg = glm::degrees(std::atan2(wishDir.x, wishDir.z));
+        }
+    }
+    else if (state == ActionState::Rolling) {
+        // กลิ้งพุ่งไปข้างหน้า “ตามทิศตัวละคร” (ไม่ใช่ทิศกล้อง)
+        glm::vec3 forwardChar = glm::normalize(glm::vec3(std::sin(radiansf(player.yawDeg)), 0, std::cos(radiansf(player.yawDeg))));
+        glm::vec3 step = forwardChar * player.rollSpeed * dt;
+        // swept against the other characters so a fast roll stops at them instead of tunnelling
+        glm::vec3 center = player.pos + glm::vec3(0, player.height / 1.25f, 0);
+        RayHit hit;
+        if (gCollision && gCollision->Sweep(glm::vec3(0.3f, player.height, 0.3f), center, center + step, hit,
+                                            COLLIDE_CHARACTER, playerCollider))
+            step *= std::max(0.0f, hit.t - 0.01f);
+        player.pos += step;
+    }
 
-    glGenVertexArrays(1, &hitboxVAO);
-    glGenBuffers(1, &hitboxVBO);
-    glGenBuffers(1, &hitboxEBO);
+    // ===== GROUND CONTACT =====
+    // on the ground: follow the terrain under the new position; walking off a drop starts a fall
+    if (player.isGrounded) {
+        float groundY = GroundHeight(player.pos.x, player.pos.z);
+        if (player.pos.y - groundY > GROUND_SNAP) { player.isGrounded = false; player.yVelocity = 0.0f; }
+        else player.pos.y = groundY;
+    }
 
-    glBindVertexArray(hitboxVAO);
+    // blend-space input: movement in character space, length 1 = walk, 2 = run
+    glm::vec2 gait(0.0f);
+    if (state == ActionState::Moving || state == ActionState::Running) {
+        glm::vec3 forwardChar(std::sin(radiansf(player.yawDeg)), 0.0f, std::cos(radiansf(player.yawDeg)));
+        glm::vec3 rightChar = glm::cross(forwardChar, glm::vec3(0, 1, 0));
+        gait = glm::vec2(glm::dot(wishDir, rightChar), glm::dot(wishDir, forwardChar))
+             * (state == ActionState::Running ? 2.0f : 1.0f);
+    }
+    gAnimator->SetLocomotionInput(gait);
+
+    prevSpace = rollHeld;
+    prevLMB = attackHeld;
+    prevE = jumpHeld;
+    prevShift = runHeld;
+
+    playerHitbox.center = player.pos + glm::vec3(0, player.height / 1.25f, 0);
+    playerHitbox.halfExtents = glm::vec3(0.3f, player.height, 0.3f);
+
+    gAnimator->UpdateAnimation(dt);
+
+    // ===== HIT VOLUMES =====
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), player.pos);
+    model = glm::rotate(model, radiansf(player.yawDeg), glm::vec3(0, 1, 0));
+    if (gPlayerVolumes) gPlayerVolumes->Update(gAnimator->GetGlobalTransforms(), model);
+    if (gCollision) gCollision->Move(playerCollider, gPlayerVolumes ? gPlayerVolumes->GetBounds() : playerHitbox.bounds());
+
+    // the sword samples the attack clip passed through this tick (clip time after the update
+    // above is duration - timeLeft + dt), tested against the other characters' boxes
+    if (state == ActionState::Attacking && gAttackSweep && gCollision) {
+        float clipTime = gAttackSweep->GetDuration() - actionTimeLeft + dt;
+        gAttackSweep->ForEachActive(clipTime - dt, clipTime, [&](const AttackSweep::Sample& sample) {
+            Capsule sword;
+            sword.a = glm::vec3(model * glm::vec4(sample.capsule.a, 1.0f));
+            sword.b = glm::vec3(model * glm::vec4(sample.capsule.b, 1.0f));
+            sword.radius = sample.capsule.radius;
+            gCollision->QueryOverlaps(sword.Bounds(), attackCandidates, COLLIDE_CHARACTER);
+            for (int id : attackCandidates) {
+                if (std::find(attackHits.begin(), attackHits.end(), id) != attackHits.end()) continue;
+                if (CapsuleOverlapsAabb(sword, gCollision->GetBox(id))) attackHits.push_back(id);
+            }
+        });
+    }
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, hitboxVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+// everything SimulateTick carries from one tick to the next, for replay verification
+uint32_t SimStateHash() {
+    uint32_t h = HashBytes(&player.pos, sizeof(player.pos));
+    h = HashBytes(&player.yawDeg, sizeof(player.yawDeg), h);
+    h = HashBytes(&player.yVelocity, sizeof(player.yVelocity), h);
+    h = HashBytes(&player.isGrounded, sizeof(player.isGrounded), h);
+    h = HashBytes(&state, sizeof(state), h);
+    h = HashBytes(&actionTimeLeft, sizeof(actionTimeLeft), h);
+    for (int id : attackHits) h = HashBytes(&id, sizeof(id), h);
+    bool edges[] = { prevSpace, prevLMB, prevE, prevShift };
+    return HashBytes(edges, sizeof(edges), h);
+}
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, hitboxEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(idx), idx, GL_STATIC_DRAW);
+// the player and every crowd agent (standing still, so added once) in one collision world
+CollisionWorld* CreateCollisionWorld(const Crowd* crowd) {
+    CollisionWorld* world = new CollisionWorld(2.0f);
+    Hitbox box;
+    box.halfExtents = glm::vec3(0.3f, player.height, 0.3f);
+    for (int i = 0; crowd && i < crowd->GetCount(); i++) {
+        box.center = crowd->GetAgentPos(i) + glm::vec3(0, player.height / 1.25f, 0);
+        world->Add(box.bounds(), COLLIDE_CHARACTER);
+    }
+    playerCollider = world->Add(playerHitbox.bounds(), COLLIDE_PLAYER, COLLIDE_CHARACTER);
+    return world;
+}
 
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+// Headless run of the real simulation (SimulateTick, the player's blend) plus `characters`
+// crowd agents on the job system, driven by an InputScript. One JSON report: per-stage
+// frame time percentiles, heap allocations per frame (null unless built with
+// HEADLESS_BENCH_COUNT_ALLOCS 1), peak RSS and the final state hash (identical across runs of
+// the same build and script). No window, no GL.
+int RunHeadlessBench(const std::string& script, int characters, int repeat, bool lod, const std::string& jsonPath) {
+    InputScript input;
+    std::string error;
+    if (!input.Compile(script, SIM_HZ, error)) {
+        std::cout << "ERROR::BENCH_SIM: " << error << "\n";
+        return 1;
+    }
 
-    glBindVertexArray(0);
+    // cooked clips bound to one shared bone map (a Model would need GL)
+    std::map<std::string, BoneInfo> boneInfoMap;
+    int boneCount = 0;
+    std::vector<AnimationClip> clips;
+    clips.reserve(sizeof(CLIP_NAMES) / sizeof(CLIP_NAMES[0])); // stable addresses
+    for (const char* name : CLIP_NAMES) {
+        clips.push_back(ClipCache::LoadUnbound(ClipPath(name)));
+        clips.back().BindToSkeleton(boneInfoMap, boneCount);
+    }
+    // CLIP_NAMES order
+    AnimationClip& idleAnim = clips[0], & walkAnim = clips[1], & walkBackwardAnim = clips[2], & runAnim = clips[3];
+    AnimationClip& strafeLeftAnim = clips[4], & strafeRightAnim = clips[5];
+    gIdle = &idleAnim; gWalk = &walkAnim; gRun = &runAnim; gRoll = &clips[6]; gAttack = &clips[7]; gJump = &clips[8];
+
+    BlendAnimator animator(gIdle);
+    animator.SetLocomotionClips(&idleAnim, &walkAnim, &runAnim, &walkBackwardAnim, &strafeLeftAnim, &strafeRightAnim);
+    animator.AddClip(gRoll);
+    animator.AddClip(gAttack);
+    animator.AddClip(gJump);
+    animator.PlayLocomotion(0.0f);
+    gAnimator = &animator;
+    BoneHitboxes playerVolumes(*gIdle, KNIGHT_VOLUMES, KNIGHT_VOLUME_COUNT);
+    AttackSweep attackSweep(*gAttack, KNIGHT_VOLUMES, KNIGHT_VOLUME_COUNT);
+    gPlayerVolumes = &playerVolumes;
+    gAttackSweep = &attackSweep;
+
+    JobSystem jobs;
+    std::vector<const AnimationClip*> loops = { &idleAnim, &walkAnim, &walkBackwardAnim, &runAnim, &strafeLeftAnim, &strafeRightAnim };
+    TerrainHeights terrainHeights(MakeTerrainSource());
+    gTerrain = &terrainHeights;
+    Crowd crowd(loops, boneCount, std::max(0, characters), glm::vec3(-20.0f, 0.0f, 4.0f));
+    crowd.PlaceOnGround(GroundHeight);
+    crowd.GetLodPolicy().enabled = lod;
+    gCollision = CreateCollisionWorld(&crowd);
+    glm::mat4 projection = glm::perspective(glm::radians(50.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 300.0f);
+
+    const int ticks = input.GetTickCount() * std::max(1, repeat);
+    std::vector<StageSamples> stages = { { "sim", ticks }, { "crowd", ticks }, { "frame", ticks } };
+    std::vector<uint64_t> allocs;
+    allocs.reserve(ticks);
+
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+    auto runBegin = Clock::now();
+    for (int t = 0; t < ticks; t++) {
+        InputFrame in = input.Frame(t % input.GetTickCount());
+        in.tick = (uint32_t)t;
+        uint64_t allocBegin = AllocCounter::Get();
+
+        auto t0 = Clock::now();
+        SimulateTick(in, SIM_DT);
+        auto t1 = Clock::now();
+        cam.yawDeg = in.camYawDeg;
+        glm::vec3 camPos; glm::mat4 view;
+        ComputeCamera(cam, player.pos, camPos, view);
+        crowd.SetLodView(AnimLodView(projection, view, camPos));
+        JobCounter done;
+        crowd.UpdateAsync(SIM_DT, jobs, done);
+        jobs.Wait(done);
+        auto t2 = Clock::now();
+
+        allocs.push_back(AllocCounter::Get() - allocBegin);
+        stages[0].Add(ms(t1 - t0));
+        stages[1].Add(ms(t2 - t1));
+        stages[2].Add(ms(t2 - t0));
+    }
+    double wallSeconds = ms(Clock::now() - runBegin) / 1000.0;
+    gAnimator = nullptr;
+    gPlayerVolumes = nullptr;
+    gAttackSweep = nullptr;
+    gTerrain = nullptr;
+    delete gCollision;
+    gCollision = nullptr;
+
+    uint64_t allocTotal = 0, allocMax = 0;
+    for (uint64_t a : allocs) { allocTotal += a; allocMax = std::max(allocMax, a); }
+
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(4);
+    json << "{\n"
+         << "  \"benchmark\": \"sim\",\n"
+         << "  \"script\": " << JsonString(script) << ",\n"
+         << "  \"characters\": " << crowd.GetCount() << ",\n"
+         << "  \"anim_lod\": " << (lod ? "true" : "false") << ",\n"
+         << "  \"threads\": " << jobs.GetThreadCount() << ",\n"
+         << "  \"tick_rate\": " << SIM_HZ << ",\n"
+         << "  \"ticks\": " << ticks << ",\n"
+         << "  \"wall_seconds\": " << wallSeconds << ",\n"
+         << "  \"stages\": ";
+    WriteStagesJson(json, stages, "  ");
+    json << ",\n"
+         << "  \"allocations\": ";
+    if (AllocCounter::ENABLED)
+        json << "{ \"per_frame_mean\": " << (ticks > 0 ? (double)allocTotal / ticks : 0.0)
+             << ", \"per_frame_max\": " << allocMax << ", \"total\": " << allocTotal << " },\n";
+    else json << "null,\n";
+    json << "  \"peak_rss_bytes\": " << PeakRssBytes() << ",\n"
+         << "  \"state_hash\": " << SimStateHash() << "\n"
+         << "}\n";
+
+    std::cout << json.str();
+    if (!jsonPath.empty()) {
+        std::ofstream out(jsonPath, std::ios::trunc);
+        out << json.str();
+        if (!out) { std::cout << "ERROR::BENCH_SIM: can't write " << jsonPath << "\n"; return 1; }
+    }
+    return 0;
 }
 
+int main(int argc, char** argv) {
+    // Offline and benchmark modes: the first argument picks one, which runs and exits before
+    // any game option below is parsed or validated.
+    const char* mode = argc > 1 ? argv[1] : "";
+
+    // ---- Offline: cook every clip to its binary cache and exit (no window needed) ----
+    // --cook [keysPerSecond]: optionally resample to uniform keys (O(1) lookup, more memory)
+    if (std::strcmp(mode, "--cook") == 0) {
+        float keysPerSecond = (argc > 2) ? (float)std::atof(argv[2]) : 0.0f;
+        int failed = 0;
+        for (const char* name : CLIP_NAMES) {
+            std::string path = ClipPath(name);
+            bool ok = ClipCache::Cook(path, keysPerSecond);
+            std::cout << (ok ? "cooked " : "FAILED ") << ClipCache::CachePathFor(path) << "\n";
+            if (!ok) failed++;
+        }
+        return failed ? 1 : 0;
+    }
 
-void DrawHitbox(Hitbox& hb) {
-    if (!hb.visible) return;
+    // ---- Offline: cook compressed clips, or report what compression would do ----
+    // --cook-compressed / --bench-compression [positionError] [rotationErrorDegrees]
+    if (std::strcmp(mode, "--cook-compressed") == 0 || std::strcmp(mode, "--bench-compression") == 0) {
+        ClipCompression settings;
+        if (argc > 2) settings.positionError = (float)std::atof(argv[2]);
+        if (argc > 3) settings.rotationError = glm::radians((float)std::atof(argv[3]));
+
+        if (std::strcmp(mode, "--bench-compression") == 0) {
+            std::vector<NamedClip> clips;
+            for (const char* name : CLIP_NAMES)
+                clips.push_back({ name, AnimationClip(ClipPath(name)) }); // from the source, never a compressed cache
+            ReportClipCompression(clips, settings);
+            return 0;
+        }
+        int failed = 0;
+        for (const char* name : CLIP_NAMES) {
+            std::string path = ClipPath(name);
+            bool ok = ClipCache::Cook(path, 0.0f, &settings);
+            std::cout << (ok ? "cooked " : "FAILED ") << ClipCache::CachePathFor(path) << " (compressed)\n";
+            if (!ok) failed++;
+        }
+        return failed ? 1 : 0;
+    }
 
-    hitboxShader->use();
+    // ---- Offline: keyframe lookup micro-benchmark over the shipped clips ----
+    // --bench-keys [seconds]
+    if (std::strcmp(mode, "--bench-keys") == 0) {
+        float seconds = (argc > 2) ? (float)std::atof(argv[2]) : 10.0f;
+        std::vector<NamedClip> clips;
+        for (const char* name : CLIP_NAMES)
+            clips.push_back({ name, ClipCache::LoadUnbound(ClipPath(name)) });
+        BenchKeyframeSampling(clips, seconds);
+        return 0;
+    }
 
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, hb.center);
-    model = glm::scale(model, hb.halfExtents * 2.0f);
+    // ---- Offline: pose blending cost per bone ----
+    // --bench-blend [seconds]
+    if (std::strcmp(mode, "--bench-blend") == 0) {
+        float seconds = (argc > 2) ? (float)std::atof(argv[2]) : 5.0f;
+        std::vector<NamedClip> clips;
+        for (const char* name : CLIP_NAMES)
+            clips.push_back({ name, ClipCache::LoadUnbound(ClipPath(name)) });
+        BenchPoseBlending(clips, seconds);
+        return 0;
+    }
 
-    glm::mat4 projection = glm::perspective(glm::radians(50.0f),
-        (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 300.0f);
-    glm::vec3 camPos; glm::mat4 view;
-    ComputeCamera(camPos, view);
+    // ---- Offline: parallel animation update scaling over thread counts ----
+    // --bench-jobs [characters] [seconds]
+    if (std::strcmp(mode, "--bench-jobs") == 0) {
+        int characters = (argc > 2) ? std::atoi(argv[2]) : 256;
+        float seconds = (argc > 3) ? (float)std::atof(argv[3]) : 5.0f;
+        std::vector<NamedClip> clips;
+        for (const char* name : CLIP_NAMES)
+            clips.push_back({ name, ClipCache::LoadUnbound(ClipPath(name)) });
+        BenchParallelAnimation(clips, characters, seconds);
+        return 0;
+    }
 
-    hitboxShader->setMat4("projection", projection);
-    hitboxShader->setMat4("view", view);
-    hitboxShader->setMat4("model", model);
+    // ---- Offline: block-compress every model texture with its mips (see texture_cache.h) ----
+    // --cook-textures
+    if (std::strcmp(mode, "--cook-textures") == 0) {
+        stbi_set_flip_vertically_on_load(true); // as the game decodes them
+        std::string dir = FileSystem::getPath("resources/objects/models/textures");
+        std::error_code ec;
+        int failed = 0;
+        uint64_t uncompressed = 0, cooked = 0;
+        double decodeMs = 0.0;
+        for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+            std::string ext = entry.path().extension().string();
+            if (ext != ".png" && ext != ".jpg" && ext != ".jpeg" && ext != ".tga") continue;
+            TextureCache::CookStats stats;
+            bool ok = TextureCache::Cook(entry.path().string(), &stats);
+            std::cout << (ok ? "cooked " : "FAILED ") << TextureCache::CachePathFor(entry.path().string());
+            if (ok) std::cout << " (" << stats.width << "x" << stats.height << " BC" << stats.format << ", " << stats.mips << " mips, "
+                              << stats.uncompressedBytes / 1024 << " -> " << stats.cookedBytes / 1024 << " KB)";
+            std::cout << "\n";
+            if (!ok) { failed++; continue; }
+            uncompressed += stats.uncompressedBytes;
+            cooked += stats.cookedBytes;
+            decodeMs += stats.decodeMs;
+        }
+        if (ec) { std::cout << "ERROR::TEXTURE_CACHE: can't list " << dir << "\n"; return 1; }
+        std::cout << "texture memory " << uncompressed / 1024 << " KB -> " << cooked / 1024 << " KB, source decode "
+                  << decodeMs << " ms saved per launch\n";
+        return failed ? 1 : 0;
+    }
 
-    glBindVertexArray(hitboxVAO);
-    glDrawElements(GL_LINES, 24, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-}
+    // ---- Offline: write the generated terrain chunks within `radius` chunks of the origin ----
+    // --cook-terrain [radius]
+    if (std::strcmp(mode, "--cook-terrain") == 0) {
+        int radius = (argc > 2) ? std::max(0, std::atoi(argv[2])) : 8;
+        TerrainSource source = MakeTerrainSource();
+        int written = 0;
+        for (int cz = -radius; cz <= radius; cz++)
+            for (int cx = -radius; cx <= radius; cx++)
+                written += source.Write(source.Generate(cx, cz));
+        std::cout << "wrote " << written << " terrain chunks to " << source.directory << "\n";
+        return written == (2 * radius + 1) * (2 * radius + 1) ? 0 : 1;
+    }
+
+    // ---- Offline: CPU skinning, scalar vs SSE2 (the reference --preskin validates against) ----
+    // --bench-skinning [vertices]
+    if (std::strcmp(mode, "--bench-skinning") == 0) {
+        BenchCpuSkinning(argc > 2 ? std::max(1, std::atoi(argv[2])) : 100000);
+        return 0;
+    }
+
+    // ---- Offline: collision broad phase from 10 to 100k boxes ----
+    // --bench-collision
+    if (std::strcmp(mode, "--bench-collision") == 0) {
+        BenchCollisionWorld();
+        return 0;
+    }
+
+    // ---- Headless: scripted simulation benchmark, JSON report ----
+    // --bench-sim [--script "run 10, roll, attack, jump"] [--characters N] [--repeat K] [--lod] [--json out.json]
+    if (std::strcmp(mode, "--bench-sim") == 0) {
+        std::string script = InputScript::DEFAULT, jsonPath;
+        int characters = 64, repeat = 1;
+        bool lod = false;
+        for (int i = 2; i < argc; i++) {
+            if (std::strcmp(argv[i], "--script") == 0 && i + 1 < argc) script = argv[++i];
+            else if (std::strcmp(argv[i], "--characters") == 0 && i + 1 < argc) characters = std::atoi(argv[++i]);
+            else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) repeat = std::atoi(argv[++i]);
+            else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) jsonPath = argv[++i];
+            else if (std::strcmp(argv[i], "--lod") == 0) lod = true;
+        }
+        return RunHeadlessBench(script, characters, repeat, lod, jsonPath);
+    }
+
+    // ---- Crowd options: --crowd N [--crowd-ramp] [--crowd-no-instancing] [--no-anim-lod] [--crowd-baked [samplesPerSecond]] ----
+    int crowdCount = 0;
+    bool crowdRamp = false, crowdInstanced = true, crowdLod = true, crowdBaked = false;
+    float bakeRate = 30.0f;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--crowd") == 0 && i + 1 < argc) crowdCount = std::max(0, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--crowd-ramp") == 0) crowdRamp = true;
+        else if (std::strcmp(argv[i], "--crowd-no-instancing") == 0) crowdInstanced = false;
+        else if (std::strcmp(argv[i], "--no-anim-lod") == 0) crowdLod = false;
+        else if (std::strcmp(argv[i], "--crowd-baked") == 0) {
+            crowdBaked = true;
+            if (i + 1 < argc && std::atof(argv[i + 1]) > 0.0) bakeRate = (float)std::atof(argv[++i]);
+        }
+    }
+
+    // ---- Simulation input: --record <file> | --replay <file> [--replay-fast] ----
+    std::string recordPath, replayPath;
+    bool replayFast = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) recordPath = argv[++i];
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) replayPath = argv[++i];
+        else if (std::strcmp(argv[i], "--replay-fast") == 0) replayFast = true;
+    }
+    InputReplay replay;
+    if (!replayPath.empty()) {
+        if (!replay.Load(replayPath)) return 1;
+        if (replay.GetTickRate() != SIM_HZ)
+            std::cout << "Warning: " << replayPath << " was recorded at " << replay.GetTickRate() << " Hz, simulating at " << SIM_HZ << " Hz\n";
+        gReplay = &replay;
+    }
+    else replayFast = false;
+    InputRecorder* recorder = recordPath.empty() ? nullptr : new InputRecorder(SIM_HZ);
+
+    // ---- Threads: --single-thread (simulation and rendering in turn on the window thread, as a baseline) ----
+    bool simThreaded = true;
+    for (int i = 1; i < argc; i++)
+        if (std::strcmp(argv[i], "--single-thread") == 0) simThreaded = false;
+
+    // ---- Input: --latency (input-to-present latency once a second; a summary at exit either way) ----
+    bool latencyReport = false;
+    for (int i = 1; i < argc; i++)
+        if (std::strcmp(argv[i], "--latency") == 0) latencyReport = true;
+
+    // ---- Culling: --occlusion (occlusion queries for the player's meshes from the start; F5 toggles) ----
+    bool occlusionQueries = false;
+    for (int i = 1; i < argc; i++)
+        if (std::strcmp(argv[i], "--occlusion") == 0) occlusionQueries = true;
+
+    // ---- Skinning: --preskin (the player is skinned once per frame into buffers, then drawn unskinned
+    // in both passes of a depth prepass) | --preskin-validate (also read the first frame back, stalling,
+    // and compare with CPU skinning) | --depth-prepass (the prepass alone: each pass skins again) ----
+    bool preskin = false, preskinValidate = false, depthPrepass = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--preskin") == 0) preskin = depthPrepass = true;
+        else if (std::strcmp(argv[i], "--preskin-validate") == 0) preskin = preskinValidate = depthPrepass = true;
+        else if (std::strcmp(argv[i], "--depth-prepass") == 0) depthPrepass = true;
+    }
+
+    // ---- Profiler: --profile (overlay from the start) | --trace <file> <firstFrame> <frameCount> ----
+    bool profileOverlay = false;
+    std::string tracePath;
+    uint64_t traceFirst = 0, traceCount = 0;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--profile") == 0) profileOverlay = true;
+        else if (std::strcmp(argv[i], "--trace") == 0 && i + 3 < argc) {
+            tracePath = argv[++i];
+            traceFirst = (uint64_t)std::max(1, std::atoi(argv[++i]));
+            traceCount = (uint64_t)std::max(1, std::atoi(argv[++i]));
+        }
+    }
+    if (traceCount > (uint64_t)FrameProfiler::HISTORY) {
+        std::cout << "Warning: --trace keeps at most " << FrameProfiler::HISTORY << " frames\n";
+        traceCount = FrameProfiler::HISTORY;
+    }
+
+    // ---- Start loading clips / textures on worker threads while the window comes up ----
+    // Flip once globally for stb (match your model textures / UVs); must be set before any decode starts
+    stbi_set_flip_vertically_on_load(true);
+
+    AssetLoader loader;
+    std::map<std::string, std::future<AnimationClip>> pendingClips;
+    for (const char* name : CLIP_NAMES) {
+        std::string path = ClipPath(name);
+        pendingClips[name] = loader.Async(std::string("clip ") + name, [path] { return ClipCache::LoadUnbound(path); });
+    }
+
+    // ---- Terrain heights (chunks load on demand; the meshes stream in once GL is up) ----
+    TerrainHeights terrainHeights(MakeTerrainSource());
+    gTerrain = &terrainHeights;
+
+    // cooked textures stream in on their own worker, smallest mips first (see texture_cache.h)
+    TextureStreamer textureStreamer;
 
-int main() {
     // ---- GLFW/GL setup ----
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -284,6 +872,8 @@ int main() {
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
     // จับเมาส์ (เหมือนเกม)
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
@@ -292,34 +882,63 @@ int main() {
         return -1;
     }
 
-    // Flip once globally for stb (match your model textures / UVs)
-    stbi_set_flip_vertically_on_load(true);
     glEnable(GL_DEPTH_TEST);
 
+    // ---- Load ground texture (change path if needed) ----
+    // the cooked file if there is one; otherwise decoded on a worker, the upload queued for the GL thread
+    std::string groundTexPath = FileSystem::getPath("resources/objects/models/textures/ground.png");
+    if (!textureStreamer.Request(groundTexPath, [](unsigned int tex) { groundTex = tex; }))
+        LoadTextureAsync(loader, groundTexPath, &groundTex);
+
     // ---- Shaders ----
     Shader ourShader("anim_model.vs", "anim_model.fs");
     gShader = &ourShader;
 
-    // หลังจาก gShader โหลดเสร็จ
-    hitboxShader = new Shader(
-        "hitbox.vs", // vertex shader
-        "hitbox.fs"  // fragment shader
-    );
+    // hitboxes, hit volumes, skeletons: batched lines, one draw per frame
+    DebugDraw debugDraw;
     std::cout << FileSystem::getPath("anim_model.fs") << "\n";
 
     // ---- Load Model & Animations ----
-    Model  ourModel(FileSystem::getPath("resources/objects/models/idle.dae"));
+    // Model uploads its meshes/textures while parsing, so it stays on this thread (overlapping the workers)
+    Model ourModel = loader.Main("model idle.dae", [] { return Model(FileSystem::getPath("resources/objects/models/idle.dae")); });
     gModel = &ourModel;
+    ModelCuller playerCuller(ourModel); // mesh bounds from the bind pose
+    playerCuller.SetOcclusion(occlusionQueries);
+    StreamModelTextures(textureStreamer, ourModel);
+    // 20-byte quantized vertices, cache-ordered triangles, in place of the Model's own buffers
+    PackedModel packedModel(ourModel);
+    packedModel.PrintReport();
+    SkinCache* skinCache = preskin ? new SkinCache(ourModel, packedModel) : nullptr;
+    if (skinCache && !skinCache->IsValid()) {
+        std::cout << "ERROR::SKIN_CACHE: no packed meshes to skin, --preskin ignored\n";
+        delete skinCache;
+        skinCache = nullptr;
+    }
+    bool skinValidated = !preskinValidate;
 
-    Animation idleAnim(FileSystem::getPath("resources/objects/models/idle.dae"), &ourModel);
-    Animation walkAnim(FileSystem::getPath("resources/objects/models/walk.dae"), &ourModel);
-    Animation walkBackwardAnim(FileSystem::getPath("resources/objects/models/walk_backward.dae"), &ourModel);
-    Animation runAnim(FileSystem::getPath("resources/objects/models/run.dae"), &ourModel);
-    Animation strafeLeftAnim(FileSystem::getPath("resources/objects/models/strafe_left.dae"), &ourModel);
-    Animation strafeRightAnim(FileSystem::getPath("resources/objects/models/strafe_right.dae"), &ourModel);
-    Animation rollAnim(FileSystem::getPath("resources/objects/models/roll.dae"), &ourModel);
-    Animation attackAnim(FileSystem::getPath("resources/objects/models/attack.dae"), &ourModel);
-    Animation jumpAnim(FileSystem::getPath("resources/objects/models/jump.dae"), &ourModel);
+    // wait for the workers, running their queued GL uploads as they arrive
+    loader.Finish();
+
+    // clips come from the binary cache; a missing or stale cache is re-cooked from the .dae.
+    // bind in a fixed order so bone ids don't depend on which worker finished first
+    auto takeClip = [&](const char* name) {
+        AnimationClip clip = pendingClips[name].get();
+        clip.BindToModel(ourModel);
+        return clip;
+    };
+    AnimationClip idleAnim = takeClip("idle");
+    AnimationClip walkAnim = takeClip("walk");
+    AnimationClip walkBackwardAnim = takeClip("walk_backward");
+    AnimationClip runAnim = takeClip("run");
+    AnimationClip strafeLeftAnim = takeClip("strafe_left");
+    AnimationClip strafeRightAnim = takeClip("strafe_right");
+    AnimationClip rollAnim = takeClip("roll");
+    AnimationClip attackAnim = takeClip("attack");
+    AnimationClip jumpAnim = takeClip("jump");
+
+    loader.PrintReport();
+    textureStreamer.Update(); // whatever mip tails are in already, so most textures are usable from the first frame
+    bool texturesReported = false;
 
     gIdle = &idleAnim;
     gWalk = &walkAnim;
@@ -328,16 +947,68 @@ int main() {
     gAttack = &attackAnim;
     gJump = &jumpAnim;
 
-    Animator animator(gIdle);
+    // player: crossfades + locomotion blend space (see pose_blend.h); every clip registered up front
+    BlendAnimator animator(gIdle);
+    animator.SetLocomotionClips(&idleAnim, &walkAnim, &runAnim, &walkBackwardAnim, &strafeLeftAnim, &strafeRightAnim);
+    animator.AddClip(gRoll);
+    animator.AddClip(gAttack);
+    animator.AddClip(gJump);
+    animator.PlayLocomotion(0.0f);
     gAnimator = &animator;
+    gJobs = new JobSystem();
+
+    // ---- Hit volumes: hurt capsules on the player's bones, the sword's sweep baked from the attack clip ----
+    BoneHitboxes playerVolumes(idleAnim, KNIGHT_VOLUMES, KNIGHT_VOLUME_COUNT);
+    AttackSweep attackSweep(attackAnim, KNIGHT_VOLUMES, KNIGHT_VOLUME_COUNT);
+    gPlayerVolumes = &playerVolumes;
+    gAttackSweep = &attackSweep;
+    std::cout << "attack sweep: " << attackSweep.GetSampleCount() << " samples, " << attackSweep.GetActiveCount() << " active\n";
+
+    // ---- Crowd: background knights on looping clips, in a block behind the spawn point ----
+    CrowdRamp* crowdRampReport = nullptr;
+    BakedPalettes* bakedPalettes = nullptr;
+    if (crowdCount > 0) {
+        std::vector<const AnimationClip*> loops = { &idleAnim, &walkAnim, &walkBackwardAnim, &runAnim, &strafeLeftAnim, &strafeRightAnim };
+        gCrowd = new Crowd(loops, ourModel.GetBoneCount(), crowdCount, glm::vec3(-20.0f, 0.0f, 4.0f));
+        gCrowd->PlaceOnGround(GroundHeight);
+        gCrowd->GetLodPolicy().enabled = crowdLod;
+        // every loop pre-sampled into a texture: no pose evaluation for the crowd at all
+        if (crowdBaked) {
+            bakedPalettes = new BakedPalettes(loops, gCrowd->GetBoneCount(), bakeRate);
+            if (gCrowd->SetBaked(bakedPalettes)) {
+                bakedPalettes->Bind(BAKED_PALETTE_UNIT);
+                bakedPalettes->PrintReport(gCrowd->GetCount());
+            }
+            else {
+                std::cout << "ERROR::BAKED_PALETTES: the crowd's clips couldn't be baked, --crowd-baked ignored\n";
+                delete bakedPalettes;
+                bakedPalettes = nullptr;
+            }
+        }
+        if (crowdRamp) {
+            glfwSwapInterval(0); // measure frame time, not vsync
+            crowdRampReport = new CrowdRamp(*gCrowd);
+        }
+    }
+    gCollision = CreateCollisionWorld(gCrowd);
+
+    // ---- Bone palette (TBO ring, read by anim_model.vs): the player plus every crowd block ----
+    int paletteMatrices = ourModel.GetBoneCount();
+    if (gCrowd) paletteMatrices += Crowd::PaletteMatricesFor(gCrowd->GetCount(), gCrowd->GetBoneCount());
+    gBonePalette = new BonePaletteBuffer(paletteMatrices);
+    gProfiler = new FrameProfiler();
+    gProfiler->SetEnabled(profileOverlay || !tracePath.empty());
+    ProfilerOverlay* profilerOverlay = new ProfilerOverlay();
+    LatencyMeter* latency = new LatencyMeter();
+    float latencyElapsed = 0.0f;
+    gShader->use();
+    gShader->setInt("bonePalette", BONE_PALETTE_UNIT);
+    gShader->setInt("bakedPalettes", BAKED_PALETTE_UNIT); // a buffer sampler left on unit 0 would clash with texture_diffuse1
 
     // ---- Ground ----
-    CreateGround();
+    TerrainRenderer terrain(terrainHeights);
 
-    // ---- Load ground texture (change path if needed) ----
-    std::string groundTexPath = FileSystem::getPath("resources/objects/models/textures/ground.png");
-    groundTex = LoadTexture(groundTexPath);
-    if (groundTex == 0) {
+    if (groundTex == 0 && textureStreamer.IsIdle()) {
         std::cout << "Warning: ground texture not loaded, ground will still draw with shader default.\n";
     }
 
@@ -348,168 +1019,223 @@ int main() {
     // We'll set that before drawing the ground only (Model::Draw is expected to set its own sampler uniforms).
 
     // toggle hitbox ก่อน main loop
-    CreateHitboxMesh();
     bool showHitbox = true;
 
-    // -------- Main loop --------
-    while (!glfwWindowShouldClose(window)) {
-        // --- timing ---
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        // --- input ---
-        glm::vec2 moveInput(0.0f);
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) moveInput.y += 1.0f;
-        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) moveInput.y -= 1.0f;
-        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) moveInput.x += 1.0f;
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) moveInput.x -= 1.0f;
-
-        bool spaceNow = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
-        bool lmbNow = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
-        bool eNow = glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS;
-        bool shiftNow = glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS;
-
-        // toggle hitbox with H (edge detect)
-        if (glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS && !prevLMB) showHitbox = !showHitbox;
-        prevLMB = (glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS);
-
-        // --- update player state, gravity, movement ---
-        // ===== STATE MACHINE =====
-        if (state == ActionState::Rolling || state == ActionState::Attacking) {
-            actionTimeLeft -= deltaTime;
-            if (actionTimeLeft <= 0.0f) {
-                if (glm::length(moveInput) > 0.0f) {
-                    if (shiftNow) { state = ActionState::Running; PlayLoop(gRun); }
-                    else { state = ActionState::Moving; PlayLoop(gWalk); }
-                }
-                else {
-                    state = ActionState::Idle;   PlayLoop(gIdle);
-                }
-            }
-        }
-        else if (state == ActionState::Jumping)
+    AnimLodStats lodStats;
+    MeshCullStats cullStats; // player + crowd, summed over the frames below
+    int statsFrames = 0;
+    float statsElapsed = 0.0f;
+
+    float simAccumulator = 0.0f; // frame time not yet simulated
+    uint32_t simTick = 0;
+    uint64_t simFrame = 0;
+    SimSnapshot simPrev{ player.pos, player.yawDeg };
+    OrbitCam simCam = cam; // the simulation's copy; the mouse callbacks move `cam` on the window thread
+    InputTicker inputTicker; // key / button events -> ticks
+    double simTime = glfwGetTime();
+    if (replayFast) glfwSwapInterval(0);
+    auto runBegin = std::chrono::steady_clock::now();
+
+    // ---- Simulation half: input -> fixed ticks -> animation -> one FramePacket (see frame_packet.h) ----
+    // No GL in here, so it runs on its own thread (or inline with --single-thread). `frameTime`
+    // is glfwGetTime() at the start of the frame, the clock the input events are stamped with.
+    auto simulateFrame = [&](const InputSnapshot& sampled, double frameTime, FrameProfiler* profiler, FramePacket& packet) {
+        float frameSeconds = (float)(frameTime - simTime);
+        simTime = frameTime;
+        float replayYaw = simCam.yawDeg;
+        simCam = sampled.cam;
+        if (gReplay) simCam.yawDeg = replayYaw; // the camera follows the recording
+        packet.frame = ++simFrame;
+        packet.deltaTime = frameSeconds;
+        packet.quit = false;
+        packet.inputTime = -1.0;
+
+        // --- simulation: fixed ticks of SIM_DT, decoupled from the frame rate ---
+        // --replay-fast runs one tick per frame as fast as it can go instead of following the clock
         {
-            // landing handled by gravity block below; keep playing jump until landed
-            if (player.isGrounded)
-            {
-                // landed this frame
-                if (glm::length(moveInput) > 0.0f) {
-                    if (shiftNow) { state = ActionState::Running; PlayLoop(gRun); }
-                    else { state = ActionState::Moving; PlayLoop(gWalk); }
-                }
-                else { state = ActionState::Idle; PlayLoop(gIdle); }
-            }
-        }
+        PROFILE_CPU(profiler, "simulation");
+        inputTicker.Take(gInputEvents);
+        int ticks = 0;
+        if (replayFast) ticks = 1;
         else {
-            if (eNow && !prevE && player.isGrounded) {
-                // start jump
-                state = ActionState::Jumping;
-                PlayOneShot(gJump, actionTimeLeft);
-                player.yVelocity = PLAYER_JUMP_SPEED;
-                player.isGrounded = false;
-            }
-            else if (spaceNow && !prevSpace) {
-                state = ActionState::Rolling;  PlayOneShot(gRoll, actionTimeLeft);
-            }
-            else if (lmbNow && !prevLMB) {
-                state = ActionState::Attacking; PlayOneShot(gAttack, actionTimeLeft);
-            }
-            else {
-                // If moving and holding shift -> running
-                if (glm::length(moveInput) > 0.0f) {
-                    if (shiftNow) {
-                        if (state != ActionState::Running) { state = ActionState::Running; PlayLoop(gRun); }
-                    }
-                    else {
-                        if (state != ActionState::Moving) { state = ActionState::Moving; PlayLoop(gWalk); }
-                    }
-                }
-                else {
-                    if (state != ActionState::Idle) { state = ActionState::Idle;   PlayLoop(gIdle); }
-                }
+            simAccumulator += std::min(frameSeconds, SIM_MAX_FRAME); // after a hitch, slow down rather than spiral
+            while (simAccumulator >= SIM_DT) { simAccumulator -= SIM_DT; ticks++; }
+        }
+        for (int t = 0; t < ticks; t++) {
+            // each tick gets the events up to its own end: the frame's time less the ticks still
+            // to come and what's left in the accumulator (later ones wait for the next frame)
+            double tickEnd = replayFast ? frameTime : frameTime - simAccumulator - (ticks - 1 - t) * (double)SIM_DT;
+            double oldest = inputTicker.Advance(tickEnd);
+            if (packet.inputTime < 0.0) packet.inputTime = oldest;
+            InputFrame in = TickInput(inputTicker, sampled.cam.yawDeg, tickEnd);
+            if (gReplay) {
+                if (!gReplay->Next(in)) { packet.quit = true; break; }
+                simCam.yawDeg = in.camYawDeg;
             }
+            in.tick = simTick++;
+
+            simPrev = SimSnapshot{ player.pos, player.yawDeg };
+            SimulateTick(in, SIM_DT);
+
+            uint32_t hash = SimStateHash();
+            if (recorder) recorder->Add(in, hash);
+            if (gReplay) gReplay->Check(hash);
+        }
         }
 
-        // ===== GRAVITY / JUMP =====
-        if (!player.isGrounded)
+        // render state between the last two ticks
+        float simAlpha = replayFast ? 1.0f : simAccumulator / SIM_DT;
+        glm::vec3 renderPos = glm::mix(simPrev.pos, player.pos, simAlpha);
+        float yawStep = std::fmod(player.yawDeg - simPrev.yawDeg + 540.0f, 360.0f) - 180.0f; // shortest way round
+        float renderYawDeg = simPrev.yawDeg + yawStep * simAlpha;
+        packet.renderPos = renderPos;
+        packet.playerModel = glm::rotate(glm::translate(glm::mat4(1.0f), renderPos), radiansf(renderYawDeg), glm::vec3(0, 1, 0));
+
+        // camera/projection (before the animation update: the crowd's LOD and culling use it)
+        packet.projection = glm::perspective(glm::radians(50.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 300.0f);
+        ComputeCamera(simCam, renderPos, packet.camPos, packet.view);
+        packet.camYawDeg = simCam.yawDeg;
+
+        // --- animation update: the crowd on the job system (the player's pose steps with the simulation) ---
+        auto animBegin = std::chrono::steady_clock::now();
         {
-            player.yVelocity += PLAYER_GRAVITY * deltaTime;
-            player.pos.y += player.yVelocity * deltaTime;
-
-            if (player.pos.y <= 0.0f)
-            {
-                player.pos.y = 0.0f;
-                player.yVelocity = 0.0f;
-                player.isGrounded = true;
-                // state change handled at top of loop (or force here)
-                if (state == ActionState::Jumping) {
-                    if (glm::length(moveInput) > 0.0f) {
-                        if (shiftNow) { state = ActionState::Running; PlayLoop(gRun); }
-                        else { state = ActionState::Moving; PlayLoop(gWalk); }
-                    }
-                    else { state = ActionState::Idle; PlayLoop(gIdle); }
-                }
-            }
+        PROFILE_CPU(profiler, "crowd animation");
+        JobCounter animDone;
+        if (gCrowd) {
+            gCrowd->SetLodView(AnimLodView(packet.projection, packet.view, packet.camPos));
+            gCrowd->UpdateAsync(frameSeconds, *gJobs, animDone);
         }
-
-        // ===== MOVEMENT =====
-        glm::vec3 camF = CameraForward();
-        glm::vec3 camR = CameraRight();
-        glm::vec3 wishDir = glm::vec3(0.0f);
-        if (glm::length(moveInput) > 1e-6f) {
-            wishDir = glm::normalize(camF * moveInput.y + camR * moveInput.x);
-            if (glm::any(glm::isnan(wishDir))) wishDir = glm::vec3(0);
+        gJobs->Wait(animDone); // every pose is final before it's copied out
         }
 
-        if (state == ActionState::Moving || state == ActionState::Idle || state == ActionState::Jumping || state == ActionState::Running) {
-            float spd = 0.0f;
-            if (state == ActionState::Moving) spd = player.moveSpeed;
-            else if (state == ActionState::Running) spd = player.runSpeed;
-            else spd = 0.0f;
-            // allow limited air-control while jumping
-            if (state == ActionState::Jumping) spd *= 0.6f;
-            player.pos += wishDir * spd * deltaTime;
+        // bone matrices: copied into the packet, uploaded by the render half
+        {
+        PROFILE_CPU(profiler, "frame packet");
+        const auto& transforms = gAnimator->GetFinalBoneMatrices();
+        packet.playerPalette.assign(transforms.begin(), transforms.end());
+        packet.crowdCount = gCrowd ? gCrowd->Pack(packet.crowdBlocks) : 0;
+        }
+        packet.animSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - animBegin).count();
+
+        // crowd LOD / culling counters; the culler's per-mesh triangle counts are fixed at load
+        packet.lodStats.Reset();
+        packet.crowdCull.Reset();
+        packet.attackHits = (int)attackHits.size();
+        if (gCrowd) {
+            gCrowd->GatherLodStats(packet.lodStats);
+            gCrowd->GatherCullStats(playerCuller, packet.crowdCull);
+            // the ramp changes the active count, so it steps with the simulation
+            if (crowdRampReport)
+                crowdRampReport->Frame(frameSeconds, packet.animSeconds, Crowd::DrawCallsFor(*gModel, packet.crowdCount, crowdInstanced));
+        }
 
-            if (glm::length(wishDir) > 0.0f) {
-                // หันตัวละครไปทิศการเคลื่อนที่ (souls-like)
-                player.yawDeg = glm::degrees(std::atan2(wishDir.x, wishDir.z));
+        // hitbox (and the other collision / hit volumes), as lines for the render half
+        packet.debugLines.Clear();
+        if (sampled.showHitbox) {
+            PROFILE_CPU(profiler, "debug lines");
+            DebugLineList& lines = packet.debugLines;
+            // the player's volumes are sim state; shift them to where the player is drawn
+            glm::vec3 shift = renderPos - player.pos;
+            const uint32_t red = DebugColor(1.0f, 0.0f, 0.0f), orange = DebugColor(1.0f, 0.5f, 0.0f);
+            lines.AddBox(Aabb::FromCenter(playerHitbox.center + shift, playerHitbox.halfExtents), red);
+            for (int i = 0; i < playerVolumes.GetCount(); i++) {
+                Capsule c = playerVolumes.GetCapsule(i);
+                c.a += shift; c.b += shift;
+                lines.AddCapsule(c, DebugColor(1.0f, 1.0f, 0.0f), 8);
             }
+            const glm::mat4& renderModel = packet.playerModel;
+            lines.AddSkeleton(gAnimator->GetGlobalTransforms(), idleAnim.GetNodeParents(), renderModel, DebugColor(0.2f, 0.8f, 1.0f));
+            if (state == ActionState::Attacking) {
+                attackSweep.ForEachActive(0.0f, attackSweep.GetDuration() - actionTimeLeft + SIM_DT, [&](const AttackSweep::Sample& sample) {
+                    Capsule c = sample.capsule;
+                    c.a = glm::vec3(renderModel * glm::vec4(c.a, 1.0f));
+                    c.b = glm::vec3(renderModel * glm::vec4(c.b, 1.0f));
+                    lines.AddCapsule(c, DebugColor(0.0f, 1.0f, 1.0f), 6);
+                });
+            }
+            gCollision->ForEachBox([&](int id, const Aabb& box) {
+                if (id == playerCollider) return;
+                bool hit = std::find(attackHits.begin(), attackHits.end(), id) != attackHits.end();
+                lines.AddBox(box, hit ? orange : red);
+            });
         }
-        else if (state == ActionState::Rolling) {
-            // กลิ้งพุ่งไปข้างหน้า “ตามทิศตัวละคร” (ไม่ใช่ทิศกล้อง)
-            glm::vec3 forwardChar = glm::normalize(glm::vec3(std::sin(radiansf(player.yawDeg)), 0, std::cos(radiansf(player.yawDeg))));
-            player.pos += forwardChar * player.rollSpeed * deltaTime;
-        }
+    };
 
-        prevSpace = spaceNow;
-        prevLMB = lmbNow;
-        prevE = eNow;
-        prevShift = shiftNow;
+    // ---- Render half: upload and draw one packet; reads nothing the simulation writes ----
+    // `view` / `camPos`: the camera latched just before drawing, newer than the packet's
+    auto renderFrame = [&](const FramePacket& packet, const glm::mat4& view, const glm::vec3& camPos) {
+        const glm::mat4& projection = packet.projection;
 
-        playerHitbox.center = player.pos + glm::vec3(0, player.height / 1.2 5f, 0);
-        playerHitbox.halfExtents = glm::vec3(0.3f, player.height, 0.3f);
+        // bone matrices: one copy into this frame's palette region
+        const std::vector<glm::mat4>& transforms = packet.playerPalette;
+        int paletteBase = -1, crowdBase = -1;
+        {
+        PROFILE_CPU(gProfiler, "palette upload");
+        gBonePalette->BeginFrame();
+        paletteBase = gBonePalette->Upload(transforms.data(), (int)transforms.size());
+        if (packet.crowdCount > 0) crowdBase = gBonePalette->Upload(packet.crowdBlocks.data(), (int)packet.crowdBlocks.size());
+        gBonePalette->Submit(BONE_PALETTE_UNIT);
+        }
+        if (skinCache) {
+            PROFILE_GPU(gProfiler, "skin once");
+            skinCache->Skin(paletteBase, (int)transforms.size(), BONE_PALETTE_UNIT);
+            if (!skinValidated && paletteBase >= 0) {
+                skinCache->Validate(transforms.data(), (int)transforms.size()); // one stall, first frame only (--preskin-validate)
+                skinValidated = true;
+            }
+        }
 
+        // culling (player, and the crowd's LOD counters with one) averaged into the window title
+        // once a second; the player's meshes are added as they're drawn below
+        if (gCrowd) {
+            lodStats.Add(packet.lodStats);
+            cullStats.Add(packet.crowdCull);
+        }
+        statsFrames++;
+        statsElapsed += deltaTime;
+        if (statsElapsed >= 1.0f) {
+            char crowd[128] = "";
+            if (gCrowd)
+                std::snprintf(crowd, sizeof(crowd), " | crowd bones/frame %d of %d | lod %d/%d/%d/%d culled %d",
+                    lodStats.bonesEvaluated / statsFrames, lodStats.bonesFull / statsFrames,
+                    lodStats.characters[0] / statsFrames, lodStats.characters[1] / statsFrames,
+                    lodStats.characters[2] / statsFrames, lodStats.characters[3] / statsFrames, lodStats.culled / statsFrames);
+            char title[256];
+            std::snprintf(title, sizeof(title),
+                "Souls-like TPS (Mouse Camera)%s | meshes %d culled %d occluded %d | tris %dk culled %dk | last swing hit %d",
+                crowd, cullStats.meshes / statsFrames, cullStats.meshesCulled / statsFrames, cullStats.meshesOccluded / statsFrames,
+                cullStats.triangles / statsFrames / 1000, cullStats.trianglesCulled / statsFrames / 1000,
+                packet.attackHits);
+            glfwSetWindowTitle(window, title);
+            lodStats.Reset();
+            cullStats.Reset();
+            statsFrames = 0;
+            statsElapsed = 0.0f;
+        }
 
-        // --- animation update ---
-        gAnimator->UpdateAnimation(deltaTime);
+        {
+        PROFILE_CPU(gProfiler, "texture streaming");
+        textureStreamer.Update();
+        if (!texturesReported && textureStreamer.IsIdle()) {
+            std::cout << "textures streamed: " << textureStreamer.GetResidentBytes() / 1024 << " KB compressed\n";
+            texturesReported = true;
+        }
+        }
 
         // --- RENDER ---
         glClearColor(0.06f, 0.06f, 0.07f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // camera/projection
-        glm::mat4 projection = glm::perspective(glm::radians(50.0f),
-            (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 300.0f);
-        glm::vec3 camPos; glm::mat4 view;
-        ComputeCamera(camPos, view);
-
         // ----- draw ground -----
+        {
+        PROFILE_CPU(gProfiler, "terrain streaming");
+        terrain.Update(packet.renderPos);
+        }
+        {
+        PROFILE_GPU(gProfiler, "ground draw");
         gShader->use();
         gShader->setMat4("projection", projection);
         gShader->setMat4("view", view);
-        glm::mat4 groundModel = glm::mat4(1.0f);
-        gShader->setMat4("model", groundModel);
 
         if (groundTex != 0) {
             glActiveTexture(GL_TEXTURE0);
@@ -517,61 +1243,214 @@ int main() {
             gShader->setInt("texture_diffuse1", 0);
         }
 
-        glBindVertexArray(groundVAO);
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        terrain.Draw(*gShader, Frustum(projection * view), camPos);
         glBindTexture(GL_TEXTURE_2D, 0);
         glActiveTexture(GL_TEXTURE0);
+        }
 
-        // ----- draw hitbox -----
-        if (showHitbox) {
-            hitboxShader->use();
-            glDisable(GL_DEPTH_TEST);
-            glDrawElements(GL_LINES, 24, GL_UNSIGNED_INT, 0);
-            glEnable(GL_DEPTH_TEST);
-
-            glm::mat4 hbModel = glm::mat4(1.0f);
-            hbModel = glm::translate(hbModel, playerHitbox.center);
-            hbModel = glm::scale(hbModel, playerHitbox.halfExtents * 2.0f);
-
-            hitboxShader->setMat4("model", hbModel);
-            hitboxShader->setMat4("view", view);
-            hitboxShader->setMat4("projection", projection);
-
-            glBindVertexArray(hitboxVAO);
-            glDrawElements(GL_LINES, 24, GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
-
-            glEnable(GL_DEPTH_TEST);
+        // ----- draw hitbox (the lines the simulation half collected) -----
+        if (!packet.debugLines.GetVertices().empty()) {
+            PROFILE_GPU(gProfiler, "debug draw");
+            debugDraw.AddLines(packet.debugLines.GetVertices());
+            debugDraw.Flush(projection * view);
         }
 
 
         // ----- draw character -----
+        {
+        PROFILE_GPU(gProfiler, "player draw");
         gShader->use(); // ✅ สำคัญ! ต้องเรียก shader ของโมเดลอีกครั้ง
         gShader->setMat4("projection", projection);
         gShader->setMat4("view", view);
 
-        // bone matrices
-        auto transforms = gAnimator->GetFinalBoneMatrices();
-        for (int i = 0; i < (int)transforms.size(); ++i)
-            gShader->setMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
+        // bone palette uploaded above
+        gShader->setInt("bonePaletteBase", paletteBase);
+        gShader->setInt("boneCount", paletteBase >= 0 ? (int)transforms.size() : 0);
 
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, player.pos);
-        model = glm::rotate(model, radiansf(player.yawDeg), glm::vec3(0, 1, 0));
-        model = glm::scale(model, glm::vec3(1.0f)); // ใช้ scale 1.0f
+        const glm::mat4& model = packet.playerModel;
         gShader->setMat4("model", model);
 
-        gModel->Draw(*gShader);
+        // after the terrain, so the occlusion queries test against its depth
+        playerCuller.Cull(model, paletteBase >= 0 ? transforms.data() : nullptr, (int)transforms.size(), projection * view, camPos);
+        gShader->use();
+        auto drawPlayer = [&] {
+            if (skinCache) skinCache->Draw(*gShader, &playerCuller); // already skinned this frame
+            else {
+                packedModel.Bind(*gShader);
+                playerCuller.Draw(*gShader);
+            }
+        };
+        if (depthPrepass) {
+            // depth only, then shade against it: each covered pixel is shaded once
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            drawPlayer();
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            glDepthFunc(GL_LEQUAL);
+            glDepthMask(GL_FALSE);
+            drawPlayer();
+            glDepthMask(GL_TRUE);
+            glDepthFunc(GL_LESS);
+        }
+        else drawPlayer();
+        cullStats.Add(playerCuller.GetStats());
+        }
 
-        glfwSwapBuffers(window);
+        // ----- draw crowd -----
+        if (gCrowd) {
+            PROFILE_GPU(gProfiler, "crowd draw");
+            packedModel.Bind(*gShader); // the crowd skins in its own vertex shader
+            gCrowd->Draw(*gModel, *gShader, crowdBase, packet.crowdCount, crowdInstanced);
+        }
+        PackedModel::Unbind(*gShader);
+        gBonePalette->EndFrame();
+    };
+
+    // ---- Threads: the simulation runs one frame ahead on its own thread, packets handed over ----
+    // through a TripleBuffer both ways (input snapshots in, frame packets out)
+    TripleBuffer<InputSnapshot> inputs;
+    TripleBuffer<FramePacket> packets;
+    FramePacket inlinePacket; // --single-thread
+    std::atomic<bool> stopSim{ false };
+    std::thread simThread;
+    if (simThreaded) {
+        simThread = std::thread([&] {
+            // its own clock: simulated time follows the wall, however long the draws take
+            while (!stopSim.load(std::memory_order_relaxed)) {
+                inputs.Acquire(); // the newest sample, or the last one again
+                FramePacket& packet = packets.Back();
+                simulateFrame(inputs.Front(), glfwGetTime(), nullptr, packet); // the profiler is the window thread's
+                bool quit = packet.quit;
+                packets.Publish();
+                if (quit) break;
+                // at most one packet ahead: don't simulate frames nobody will draw
+                TripleBuffer<FramePacket>::WaitFor([&] { return packets.IsConsumed(); }, stopSim);
+            }
+        });
+    }
+
+    // -------- Main loop --------
+    while (!glfwWindowShouldClose(window)) {
+        // events first: key / button transitions go to the simulation's queue as they're delivered
+        glfwPollEvents();
+
+        // --- timing ---
+        float currentFrame = glfwGetTime();
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+
+        gProfiler->BeginFrame();
+
+        // --- input: simulated keys / buttons arrive as events (key_callback); the rest is sampled here ---
+        InputSnapshot sampled;
+        {
+        PROFILE_CPU(gProfiler, "input");
+        // toggle hitbox with H (edge detect; its own edge, the attack edge is simulation state)
+        bool hNow = glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS;
+        if (hNow && !prevH) showHitbox = !showHitbox;
+        prevH = hNow;
+        sampled.cam = cam;
+        sampled.showHitbox = showHitbox;
+
+        // profiler: F3 toggles collection + overlay, F4 writes the kept frames as a Chrome trace
+        bool f3Now = glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS;
+        bool f4Now = glfwGetKey(window, GLFW_KEY_F4) == GLFW_PRESS;
+        if (f3Now && !prevF3) { profileOverlay = !profileOverlay; gProfiler->SetEnabled(profileOverlay || !tracePath.empty()); }
+        if (f4Now && !prevF4 && gProfiler->GetFrameIndex() > 0) {
+            uint64_t last = gProfiler->GetFrameIndex();
+            gProfiler->WriteChromeTrace("frame_trace.json", last > FrameProfiler::HISTORY ? last - FrameProfiler::HISTORY + 1 : 1, last);
+        }
+        prevF3 = f3Now;
+
+        // F5: occlusion queries on / off
+        bool f5Now = glfwGetKey(window, GLFW_KEY_F5) == GLFW_PRESS;
+        if (f5Now && !prevF5) playerCuller.SetOcclusion(!playerCuller.GetOcclusion());
+        prevF5 = f5Now;
+        prevF4 = f4Now;
+        }
+
+        // --- simulation: the packet the simulation thread finished meanwhile, or this frame's inline ---
+        const FramePacket* packet = &inlinePacket;
+        if (simThreaded) {
+            PROFILE_CPU(gProfiler, "wait for simulation");
+            inputs.Back() = sampled;
+            inputs.Publish();
+            TripleBuffer<FramePacket>::WaitFor([&] { return packets.Acquire(); }, stopSim);
+            packet = &packets.Front();
+        }
+        else simulateFrame(sampled, glfwGetTime(), gProfiler, inlinePacket);
+        if (packet->quit) glfwSetWindowShouldClose(window, true);
+
+        // late camera latch: the mouse moves since the packet was simulated go into this frame's
+        // view (yaw stays the recording's on a replay). Movement used the yaw sampled above.
         glfwPollEvents();
+        double latchTime = glfwGetTime();
+        OrbitCam latched = cam;
+        if (gReplay) latched.yawDeg = packet->camYawDeg;
+        glm::vec3 camPos; glm::mat4 view;
+        ComputeCamera(latched, packet->renderPos, camPos, view);
+
+        renderFrame(*packet, view, camPos);
+
+        if (profileOverlay) {
+            PROFILE_GPU(gProfiler, "profiler overlay");
+            profilerOverlay->Draw(*gProfiler, SCR_WIDTH, SCR_HEIGHT);
+        }
+
+        latency->Submit(packet->inputTime, latchTime, glfwGetTime());
+        {
+        PROFILE_CPU(gProfiler, "swap");
+        glfwSwapBuffers(window);
+        }
+        gProfiler->EndFrame();
+
+        latency->Update();
+        latencyElapsed += deltaTime;
+        if (latencyReport && latencyElapsed >= 1.0f) {
+            std::cout << "latency: ";
+            latency->TakeWindow().Print(std::cout);
+            latencyElapsed = 0.0f;
+        }
+
+        if (!tracePath.empty() && gProfiler->GetFrameIndex() == traceFirst + traceCount - 1) {
+            gProfiler->WriteChromeTrace(tracePath, traceFirst, traceFirst + traceCount - 1);
+            tracePath.clear();
+            gProfiler->SetEnabled(profileOverlay);
+        }
+    }
+    stopSim = true;
+    if (simThread.joinable()) simThread.join(); // before the recorder / replay below, which it writes
+
+    // recording / replay results
+    if (recorder) {
+        bool saved = recorder->Save(recordPath);
+        std::cout << (saved ? "recorded " : "FAILED to record ") << recorder->GetFrameCount() << " ticks to " << recordPath << "\n";
+        delete recorder;
+    }
+    if (gReplay) {
+        float wall = std::chrono::duration<float>(std::chrono::steady_clock::now() - runBegin).count();
+        std::cout << "replayed " << gReplay->GetPosition() << " / " << gReplay->GetFrameCount() << " ticks in " << wall << " s ("
+                  << (wall > 0.0f ? gReplay->GetPosition() / wall : 0.0f) << " ticks/s): ";
+        if (gReplay->GetFirstMismatch() < 0) std::cout << "state matches the recording\n";
+        else std::cout << "state DIVERGED at tick " << gReplay->GetFirstMismatch() << "\n";
+        gReplay = nullptr;
     }
 
+    std::cout << "latency: ";
+    latency->GetTotal().Print(std::cout);
+    if (gInputEvents.GetDroppedCount() > 0) std::cout << "Warning: " << gInputEvents.GetDroppedCount() << " input events dropped\n";
 
     // cleanup
     if (groundTex) glDeleteTextures(1, &groundTex);
-    if (groundVAO) { glDeleteVertexArrays(1, &groundVAO); glDeleteBuffers(1, &groundVBO); glDeleteBuffers(1, &groundEBO); }
+    delete gBonePalette; // needs the context, so before glfwTerminate
+    delete skinCache;
+    delete profilerOverlay;
+    delete latency;
+    delete gProfiler;
+    delete crowdRampReport;
+    delete gCollision;
+    delete gCrowd;
+    delete bakedPalettes; // after the crowd that plays from it
+    delete gJobs;
 
     glfwTerminate();
     return 0;
@@ -590,7 +1469,7 @@ void mouse_callback(GLFWwindow* /*window*/, double xpos, double ypos) {
     double yoffset = lastY - ypos;
     lastX = xpos; lastY = ypos;
 
-    cam.yawDeg += (float)xoffset * cam.sens * -1;
+    if (!gReplay) cam.yawDeg += (float)xoffset * cam.sens * -1; // yaw is simulation input
     cam.pitchDeg += (float)yoffset * cam.sens;
     if (cam.pitchDeg < cam.minPitch) cam.pitchDeg = cam.minPitch;
     if (cam.pitchDeg > cam.maxPitch) cam.pitchDeg = cam.maxPitch;
@@ -602,3 +1481,28 @@ void scroll_callback(GLFWwindow* /*window*/, double /*xoffset*/, double yoffset)
     if (cam.distance < cam.minDist) cam.distance = cam.minDist;
     if (cam.distance > cam.maxDist) cam.distance = cam.maxDist;
 }
+
+// keys / buttons the simulation reads, queued with the time they arrived (see input_events.h)
+uint32_t KeyBits(int key) {
+    switch (key) {
+    case GLFW_KEY_W: return MOVE_FORWARD;
+    case GLFW_KEY_S: return MOVE_BACK;
+    case GLFW_KEY_D: return MOVE_RIGHT;
+    case GLFW_KEY_A: return MOVE_LEFT;
+    case GLFW_KEY_SPACE: return INPUT_ROLL;
+    case GLFW_KEY_E: return INPUT_JUMP;
+    case GLFW_KEY_LEFT_SHIFT: return INPUT_RUN;
+    default: return 0;
+    }
+}
+
+void key_callback(GLFWwindow* /*window*/, int key, int /*scancode*/, int action, int /*mods*/) {
+    uint32_t bits = KeyBits(key);
+    if (bits != 0 && action != GLFW_REPEAT) gInputEvents.Push({ glfwGetTime(), bits, action == GLFW_PRESS });
+}
+
+void mouse_button_callback(GLFWwindow* /*window*/, int button, int action, int /*mods*/) {
+    uint32_t bits = button == GLFW_MOUSE_BUTTON_LEFT ? (uint32_t)INPUT_ATTACK
+                  : button == GLFW_MOUSE_BUTTON_RIGHT ? (uint32_t)INPUT_STRAFE : 0u; // right mouse: face the camera, strafe
+    if (bits != 0) gInputEvents.Push({ glfwGetTime(), bits, action == GLFW_PRESS });
+}
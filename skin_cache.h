@@ -0,0 +1,273 @@
+#ifndef SKIN_CACHE_H
+#define SKIN_CACHE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <learnopengl/shader_m.h>
+#include <learnopengl/model_animation.h>
+
+#include "packed_mesh.h"
+#include "mesh_culling.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SKIN_SSE 1
+#endif
+
+// ---- CPU skinning: the reference for the GPU paths, and headless validation ----
+
+// one packed vertex as anim_model.vs skins it (weights sum to one, unused slots weigh 0)
+inline glm::vec3 SkinPackedVertex(const PackedVertex& v, const glm::mat4* palette, int boneCount,
+                                  const glm::vec3& scale, const glm::vec3& offset) {
+    glm::vec3 p = glm::vec3(v.pos[0], v.pos[1], v.pos[2]) / 65535.0f * scale + offset;
+    if (boneCount == 0) return p;
+    glm::vec4 total(0.0f);
+    for (int i = 0; i < 4; i++) {
+        if (v.weights[i] == 0) continue;
+        if (v.bones[i] >= boneCount) return p;
+        total += palette[v.bones[i]] * glm::vec4(p, 1.0f) * (v.weights[i] / 255.0f);
+    }
+    return glm::vec3(total);
+}
+
+// Skin `count` vertices into `out`. With SSE2 the influences' matrices are blended column
+// by column (4 lanes) and the blend applied once, instead of one transform per influence.
+inline void SkinPackedVertices(const PackedVertex* verts, int count, const glm::mat4* palette, int boneCount,
+                               const glm::vec3& scale, const glm::vec3& offset, glm::vec3* out) {
+#ifdef SKIN_SSE
+    static_assert(sizeof(glm::mat4) == 16 * sizeof(float), "palette columns are loaded as raw floats");
+    const float inv = 1.0f / 65535.0f;
+    for (int n = 0; n < count; n++) {
+        const PackedVertex& v = verts[n];
+        glm::vec3 p = glm::vec3(v.pos[0] * inv, v.pos[1] * inv, v.pos[2] * inv) * scale + offset;
+        bool rigid = (boneCount == 0);
+        __m128 c0 = _mm_setzero_ps(), c1 = c0, c2 = c0, c3 = c0;
+        for (int i = 0; i < 4 && !rigid; i++) {
+            if (v.weights[i] == 0) continue;
+            if (v.bones[i] >= boneCount) { rigid = true; break; }
+            const float* m = glm::value_ptr(palette[v.bones[i]]);
+            __m128 w = _mm_set1_ps(v.weights[i] / 255.0f);
+            c0 = _mm_add_ps(c0, _mm_mul_ps(_mm_loadu_ps(m), w));
+            c1 = _mm_add_ps(c1, _mm_mul_ps(_mm_loadu_ps(m + 4), w));
+            c2 = _mm_add_ps(c2, _mm_mul_ps(_mm_loadu_ps(m + 8), w));
+            c3 = _mm_add_ps(c3, _mm_mul_ps(_mm_loadu_ps(m + 12), w));
+        }
+        if (rigid) { out[n] = p; continue; }
+        __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p.x)), _mm_mul_ps(c1, _mm_set1_ps(p.y))),
+                              _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(p.z)), c3));
+        float f[4];
+        _mm_storeu_ps(f, r);
+        out[n] = glm::vec3(f[0], f[1], f[2]);
+    }
+#else
+    for (int n = 0; n < count; n++) out[n] = SkinPackedVertex(verts[n], palette, boneCount, scale, offset);
+#endif
+}
+
+// ---- GPU: skin once per frame, draw the result in every pass ----
+
+// Pre-skinned copies of one character's packed meshes. Skin() runs skin_feedback.vs over every
+// vertex once (points, GL_RASTERIZER_DISCARD) and captures the model-space positions and UVs
+// with transform feedback; Draw() then draws them with the mesh's own index buffer as
+// unskinned geometry (boneCount 0), so a depth prepass, shadow map or outline costs one
+// vertex fetch and one matrix per vertex rather than another four-influence palette blend.
+//
+// Transform feedback is core in GL 3.3, so this runs wherever the game does; a compute
+// shader version would need 4.3 and buys nothing over this for a handful of characters.
+class SkinCache {
+public:
+    static const GLsizei STRIDE = 5 * sizeof(float); // vec3 position, vec2 uv
+
+    SkinCache(Model& model, const PackedModel& packed)
+        : m_Model(model), m_Packed(packed), m_Shader("skin_feedback.vs", "skin_feedback.fs") {
+        // varyings have to be named before linking: link the program again with them
+        const char* varyings[] = { "skinnedPos", "skinnedTex" };
+        glTransformFeedbackVaryings(m_Shader.ID, 2, varyings, GL_INTERLEAVED_ATTRIBS);
+        glLinkProgram(m_Shader.ID);
+        GLint linked = 0;
+        glGetProgramiv(m_Shader.ID, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            std::cout << "ERROR::SKIN_CACHE: skin_feedback.vs doesn't link for transform feedback\n";
+            return;
+        }
+
+        m_Meshes.resize(model.meshes.size());
+        for (size_t i = 0; i < model.meshes.size(); i++) {
+            MeshSkin& skin = m_Meshes[i];
+            skin.vertexCount = (GLsizei)packed.GetVertices((int)i).size();
+            if (skin.vertexCount == 0) continue; // not packed: drawn the usual way
+
+            GLint ebo = 0; // the packed mesh's index buffer, shared
+            glBindVertexArray(model.meshes[i].VAO);
+            glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &ebo);
+
+            glGenBuffers(1, &skin.buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, skin.buffer);
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)skin.vertexCount * STRIDE, nullptr, GL_DYNAMIC_COPY);
+            glGenVertexArrays(1, &skin.vao);
+            glBindVertexArray(skin.vao);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (GLuint)ebo);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, STRIDE, (void*)0);
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, STRIDE, (void*)(3 * sizeof(float)));
+            glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            m_Valid = true;
+        }
+    }
+
+    ~SkinCache() {
+        for (MeshSkin& skin : m_Meshes) {
+            if (skin.vao) glDeleteVertexArrays(1, &skin.vao);
+            if (skin.buffer) glDeleteBuffers(1, &skin.buffer);
+        }
+    }
+
+    SkinCache(const SkinCache&) = delete;
+    SkinCache& operator=(const SkinCache&) = delete;
+
+    bool IsValid() const { return m_Valid; }
+
+    // skin every packed mesh with the palette at `paletteBase` (already submitted to `paletteUnit`)
+    void Skin(int paletteBase, int boneCount, int paletteUnit) {
+        if (!m_Valid) return;
+        m_Shader.use();
+        m_Shader.setInt("bonePalette", paletteUnit);
+        m_Shader.setInt("bonePaletteBase", paletteBase);
+        m_Shader.setInt("boneCount", paletteBase >= 0 ? boneCount : 0);
+        m_Packed.Bind(m_Shader);
+        glEnable(GL_RASTERIZER_DISCARD);
+        for (size_t i = 0; i < m_Meshes.size(); i++) {
+            const MeshSkin& skin = m_Meshes[i];
+            if (!skin.vao) continue;
+            glBindVertexArray(m_Model.meshes[i].VAO);
+            glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, skin.buffer);
+            glBeginTransformFeedback(GL_POINTS);
+            glDrawArrays(GL_POINTS, 0, skin.vertexCount);
+            glEndTransformFeedback();
+        }
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        glDisable(GL_RASTERIZER_DISCARD);
+        glBindVertexArray(0);
+        m_SkinnedVertices = 0;
+        for (const MeshSkin& skin : m_Meshes) m_SkinnedVertices += skin.vao ? skin.vertexCount : 0;
+    }
+
+    // Draw the last Skin() with `shader` (anim_model.vs; projection / view / model already set),
+    // skipping meshes the culler rejected. Meshes that weren't packed aren't in the cache.
+    void Draw(Shader& shader, const ModelCuller* culler = nullptr) const {
+        if (!m_Valid) return;
+        shader.setInt("boneCount", 0);
+        shader.setInt("instanceStride", 0);
+        PackedModel::Unbind(shader);
+        for (size_t i = 0; i < m_Meshes.size(); i++) {
+            const MeshSkin& skin = m_Meshes[i];
+            if (!skin.vao || (culler && !culler->IsVisible((int)i))) continue;
+            const Mesh& mesh = m_Model.meshes[i];
+            BindMeshTextures(mesh, shader);
+            glBindVertexArray(skin.vao);
+            glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indices.size(), GL_UNSIGNED_INT, 0);
+        }
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    int GetSkinnedVertexCount() const { return m_SkinnedVertices; }
+
+    // Read the last Skin() back (stalls) and compare with CPU skinning of the same palette.
+    // Returns the largest position difference, model units.
+    float Validate(const glm::mat4* palette, int boneCount, std::ostream& os = std::cout) const {
+        float worst = 0.0f;
+        std::vector<float> gpu;
+        std::vector<glm::vec3> cpu;
+        for (size_t i = 0; i < m_Meshes.size(); i++) {
+            const MeshSkin& skin = m_Meshes[i];
+            if (!skin.vao) continue;
+            const std::vector<PackedVertex>& verts = m_Packed.GetVertices((int)i);
+            gpu.resize((size_t)skin.vertexCount * 5);
+            cpu.resize(skin.vertexCount);
+            glBindBuffer(GL_ARRAY_BUFFER, skin.buffer);
+            glGetBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)gpu.size() * sizeof(float), gpu.data());
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            SkinPackedVertices(verts.data(), skin.vertexCount, palette, boneCount,
+                               m_Packed.GetPositionScale(), m_Packed.GetPositionOffset(), cpu.data());
+            for (GLsizei v = 0; v < skin.vertexCount; v++)
+                worst = std::max(worst, glm::length(glm::vec3(gpu[v * 5], gpu[v * 5 + 1], gpu[v * 5 + 2]) - cpu[v]));
+        }
+        os << "skin cache: " << m_SkinnedVertices << " vertices, GPU vs CPU skinning max difference " << worst << "\n";
+        return worst;
+    }
+
+private:
+    struct MeshSkin {
+        GLuint buffer = 0, vao = 0;
+        GLsizei vertexCount = 0;
+    };
+
+    Model& m_Model;
+    const PackedModel& m_Packed;
+    Shader m_Shader;
+    std::vector<MeshSkin> m_Meshes;
+    bool m_Valid = false;
+    int m_SkinnedVertices = 0;
+};
+
+// CPU skinning throughput, per-influence scalar vs blended SSE, on random vertices and a
+// random palette (skeletal_animation --bench-skinning [vertices])
+inline void BenchCpuSkinning(int vertexCount = 100000, std::ostream& os = std::cout) {
+    using Clock = std::chrono::steady_clock;
+    const int BONES = 65, REPEAT = 20;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> pos(0, 65535), bone(0, BONES - 1), weight(0, 255);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    std::vector<PackedVertex> verts(vertexCount);
+    for (PackedVertex& v : verts) {
+        for (int c = 0; c < 3; c++) v.pos[c] = (uint16_t)pos(rng);
+        int left = 255;
+        for (int i = 0; i < 4; i++) {
+            v.bones[i] = (uint8_t)bone(rng);
+            v.weights[i] = (uint8_t)(i == 3 ? left : std::min(left, weight(rng) / 2));
+            left -= v.weights[i];
+        }
+    }
+    std::vector<glm::mat4> palette(BONES);
+    for (glm::mat4& m : palette)
+        for (int c = 0; c < 4; c++)
+            for (int r = 0; r < 3; r++) m[c][r] = unit(rng) + (c == r ? 1.0f : 0.0f);
+    const glm::vec3 scale(1.0f, 2.0f, 0.5f), offset(-0.5f, 0.0f, -0.25f);
+
+    std::vector<glm::vec3> ref(vertexCount), fast(vertexCount);
+    auto t0 = Clock::now();
+    for (int r = 0; r < REPEAT; r++)
+        for (int n = 0; n < vertexCount; n++) ref[n] = SkinPackedVertex(verts[n], palette.data(), BONES, scale, offset);
+    auto t1 = Clock::now();
+    for (int r = 0; r < REPEAT; r++)
+        SkinPackedVertices(verts.data(), vertexCount, palette.data(), BONES, scale, offset, fast.data());
+    auto t2 = Clock::now();
+
+    float worst = 0.0f;
+    for (int n = 0; n < vertexCount; n++) worst = std::max(worst, glm::length(ref[n] - fast[n]));
+    auto ms = [&](Clock::time_point a, Clock::time_point b) { return std::chrono::duration<double, std::milli>(b - a).count() / REPEAT; };
+    os << "---- CPU skinning, " << vertexCount << " vertices x 4 influences ----\n" << std::fixed << std::setprecision(3)
+       << "  scalar  " << ms(t0, t1) << " ms\n"
+#ifdef SKIN_SSE
+       << "  sse2    " << ms(t1, t2) << " ms\n"
+#else
+       << "  batch   " << ms(t1, t2) << " ms (no SSE2: scalar)\n"
+#endif
+       << "  max difference " << std::setprecision(7) << worst << (worst < 1e-4f ? "  OK" : "  MISMATCH") << "\n";
+}
+
+#endif
@@ -0,0 +1,8 @@
+#version 330 core
+out vec4 FragColor;
+
+// never runs: the skin pass draws with GL_RASTERIZER_DISCARD
+void main()
+{
+    FragColor = vec4(0.0);
+}
@@ -0,0 +1,53 @@
+#version 330 core
+
+// Skin-once pass (see skin_cache.h): the skinning of anim_model.vs, captured with transform
+// feedback instead of rasterized. One point per vertex; the output buffer is then drawn as
+// plain geometry by every pass that needs the character.
+layout(location = 0) in vec3 pos;
+layout(location = 2) in vec2 tex;
+layout(location = 5) in ivec4 boneIds;
+layout(location = 6) in vec4 weights;
+
+const int MAX_BONE_INFLUENCE = 4;
+
+uniform samplerBuffer bonePalette;
+uniform int bonePaletteBase;
+uniform int boneCount;
+uniform int packedVertices;
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+
+out vec3 skinnedPos; // model space
+out vec2 skinnedTex;
+
+mat4 PaletteMatrix(int index)
+{
+    int t = index * 4;
+    return mat4(texelFetch(bonePalette, t),
+                texelFetch(bonePalette, t + 1),
+                texelFetch(bonePalette, t + 2),
+                texelFetch(bonePalette, t + 3));
+}
+
+void main()
+{
+    vec3 position = packedVertices != 0 ? pos * positionScale + positionOffset : pos;
+    vec4 totalPosition = vec4(0.0f);
+    if(boneCount == 0)
+        totalPosition = vec4(position,1.0f);
+    for(int i = 0 ; i < MAX_BONE_INFLUENCE && boneCount > 0 ; i++)
+    {
+        if(boneIds[i] == -1)
+            continue;
+        if(boneIds[i] >= boneCount)
+        {
+            totalPosition = vec4(position,1.0f);
+            break;
+        }
+        totalPosition += PaletteMatrix(bonePaletteBase + boneIds[i]) * vec4(position,1.0f) * weights[i];
+    }
+
+    skinnedPos = totalPosition.xyz;
+    skinnedTex = tex;
+    gl_Position = vec4(0.0);
+}
@@ -0,0 +1,470 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_m.h>
+
+#include "asset_loader.h"
+#include "frustum.h"
+
+// Terrain as a grid of square height-map chunks, CHUNK_SIZE m on a side with CHUNK_RES
+// quads (1 m spacing). Nothing is loaded up front:
+//
+//   TerrainSource    where a chunk's heights come from: <directory>/<cx>_<cz>.height if the
+//                    file exists, otherwise a deterministic generator (--cook-terrain writes
+//                    the generated chunks out)
+//   TerrainHeights   CPU heights of the chunks in use and the ground query the simulation
+//                    uses. A chunk the query needs but nobody streamed in yet is loaded on
+//                    the spot, so the simulation never depends on streaming timing.
+//   TerrainRenderer  pages chunk meshes in and out around a point on a worker thread,
+//                    uploads a few per frame, draws them with geomipmapping LOD and
+//                    frustum culling
+//
+// Only what's around the player is resident, so the world size is bounded by disk, not
+// VRAM or startup time.
+const int TERRAIN_CHUNK_RES = 64;            // quads per side
+const float TERRAIN_CHUNK_SIZE = 64.0f;      // m
+const float TERRAIN_SPACING = TERRAIN_CHUNK_SIZE / TERRAIN_CHUNK_RES;
+const int TERRAIN_APRON_RES = TERRAIN_CHUNK_RES + 3; // samples per side incl. a one-sample apron for normals
+
+// Chunk file (<cx>_<cz>.height), host byte order like the clip cache:
+//   TerrainFileHeader
+//   float heights[TERRAIN_APRON_RES * TERRAIN_APRON_RES]  rows of +x, sample (-1, -1) first
+const char TERRAIN_FILE_MAGIC[4] = { 'K', 'H', 'G', 'T' };
+const uint32_t TERRAIN_FILE_VERSION = 1;
+
+struct TerrainFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t resolution; // TERRAIN_CHUNK_RES
+    float spacing;       // m
+};
+
+struct TerrainChunkData {
+    int cx = 0, cz = 0;
+    std::vector<float> heights; // TERRAIN_APRON_RES^2
+    float minY = 0.0f, maxY = 0.0f;
+
+    // sample (i, j) of the chunk, i / j in [-1, TERRAIN_CHUNK_RES + 1]
+    float At(int i, int j) const { return heights[(j + 1) * TERRAIN_APRON_RES + (i + 1)]; }
+
+    void UpdateRange() {
+        minY = maxY = At(0, 0);
+        for (int j = 0; j <= TERRAIN_CHUNK_RES; j++)
+            for (int i = 0; i <= TERRAIN_CHUNK_RES; i++) {
+                minY = std::min(minY, At(i, j));
+                maxY = std::max(maxY, At(i, j));
+            }
+    }
+};
+
+inline uint64_t TerrainChunkKey(int cx, int cz) { return ((uint64_t)(uint32_t)cx << 32) | (uint32_t)cz; }
+inline int TerrainChunkCoord(float v) { return (int)std::floor(v / TERRAIN_CHUNK_SIZE); }
+
+class TerrainSource {
+public:
+    std::string directory;  // chunk files; empty = generate everything
+    float amplitude = 4.0f; // m, generated hills
+    float flatRadius = 40.0f; // m around the origin kept at height 0 (spawn, crowd)
+    uint32_t seed = 1;
+
+    std::string ChunkPath(int cx, int cz) const {
+        return directory + "/" + std::to_string(cx) + "_" + std::to_string(cz) + ".height";
+    }
+
+    // the chunk's file if there is a valid one, otherwise generated; safe on any thread
+    TerrainChunkData Load(int cx, int cz) const {
+        TerrainChunkData chunk;
+        if (!directory.empty() && Read(ChunkPath(cx, cz), chunk)) {
+            chunk.cx = cx; chunk.cz = cz;
+            chunk.UpdateRange();
+            return chunk;
+        }
+        return Generate(cx, cz);
+    }
+
+    TerrainChunkData Generate(int cx, int cz) const {
+        TerrainChunkData chunk;
+        chunk.cx = cx; chunk.cz = cz;
+        chunk.heights.resize(TERRAIN_APRON_RES * TERRAIN_APRON_RES);
+        for (int j = -1; j <= TERRAIN_CHUNK_RES + 1; j++)
+            for (int i = -1; i <= TERRAIN_CHUNK_RES + 1; i++)
+                chunk.heights[(j + 1) * TERRAIN_APRON_RES + (i + 1)] =
+                    Sample(cx * TERRAIN_CHUNK_SIZE + i * TERRAIN_SPACING, cz * TERRAIN_CHUNK_SIZE + j * TERRAIN_SPACING);
+        chunk.UpdateRange();
+        return chunk;
+    }
+
+    bool Write(const TerrainChunkData& chunk) const {
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        std::ofstream out(ChunkPath(chunk.cx, chunk.cz), std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cout << "ERROR::TERRAIN: can't write " << ChunkPath(chunk.cx, chunk.cz) << "\n";
+            return false;
+        }
+        TerrainFileHeader header;
+        std::memcpy(header.magic, TERRAIN_FILE_MAGIC, 4);
+        header.version = TERRAIN_FILE_VERSION;
+        header.resolution = TERRAIN_CHUNK_RES;
+        header.spacing = TERRAIN_SPACING;
+        out.write((const char*)&header, sizeof(header));
+        out.write((const char*)chunk.heights.data(), chunk.heights.size() * sizeof(float));
+        return (bool)out;
+    }
+
+    // generated height at world (x, z): a few octaves of value noise, faded to 0 near the origin
+    float Sample(float x, float z) const {
+        float h = 0.0f, amp = 1.0f, freq = 1.0f / 96.0f, norm = 0.0f;
+        for (int octave = 0; octave < 4; octave++) {
+            h += ValueNoise(x * freq, z * freq, seed + octave) * amp;
+            norm += amp;
+            amp *= 0.5f;
+            freq *= 2.0f;
+        }
+        float d = std::sqrt(x * x + z * z);
+        float fade = std::min(std::max((d - flatRadius) / flatRadius, 0.0f), 1.0f);
+        return amplitude * (h / norm) * fade * fade * (3.0f - 2.0f * fade);
+    }
+
+private:
+    static bool Read(const std::string& path, TerrainChunkData& chunk) {
+        std::ifstream in(path, std::ios::binary);
+        TerrainFileHeader header;
+        if (!in || !in.read((char*)&header, sizeof(header))) return false;
+        if (std::memcmp(header.magic, TERRAIN_FILE_MAGIC, 4) != 0 || header.version != TERRAIN_FILE_VERSION ||
+            header.resolution != (uint32_t)TERRAIN_CHUNK_RES || header.spacing != TERRAIN_SPACING) {
+            std::cout << "ERROR::TERRAIN: " << path << " is not a " << TERRAIN_CHUNK_RES << "-quad height chunk (version " << TERRAIN_FILE_VERSION << ")\n";
+            return false;
+        }
+        chunk.heights.resize(TERRAIN_APRON_RES * TERRAIN_APRON_RES);
+        return (bool)in.read((char*)chunk.heights.data(), chunk.heights.size() * sizeof(float));
+    }
+
+    static float Hash(int x, int z, uint32_t seed) {
+        uint32_t h = (uint32_t)x * 374761393u + (uint32_t)z * 668265263u + seed * 2246822519u;
+        h = (h ^ (h >> 13)) * 1274126177u;
+        h ^= h >> 16;
+        return (h & 0xffffff) / (float)0xffffff * 2.0f - 1.0f; // [-1, 1]
+    }
+
+    static float ValueNoise(float x, float z, uint32_t seed) {
+        int x0 = (int)std::floor(x), z0 = (int)std::floor(z);
+        float fx = x - x0, fz = z - z0;
+        fx = fx * fx * (3.0f - 2.0f * fx);
+        fz = fz * fz * (3.0f - 2.0f * fz);
+        float a = Hash(x0, z0, seed), b = Hash(x0 + 1, z0, seed);
+        float c = Hash(x0, z0 + 1, seed), d = Hash(x0 + 1, z0 + 1, seed);
+        return (a + (b - a) * fx) + ((c + (d - c) * fx) - (a + (b - a) * fx)) * fz;
+    }
+};
+
+// CPU heights of the resident chunks (thread-safe) and the ground query.
+class TerrainHeights {
+public:
+    explicit TerrainHeights(const TerrainSource& source) : m_Source(source) {}
+
+    // the chunk, loading it on the calling thread if it isn't resident
+    std::shared_ptr<const TerrainChunkData> Acquire(int cx, int cz) {
+        uint64_t key = TerrainChunkKey(cx, cz);
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            auto it = m_Chunks.find(key);
+            if (it != m_Chunks.end()) return it->second;
+        }
+        auto chunk = std::make_shared<const TerrainChunkData>(m_Source.Load(cx, cz)); // outside the lock
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Chunks.emplace(key, chunk).first->second; // a racing load may have won; keep that one
+    }
+
+    // Ground height at (x, z), interpolated over the same triangles the LOD 0 mesh draws
+    // (each quad split along its (0,0)-(1,1) diagonal).
+    float HeightAt(float x, float z) {
+        int cx = TerrainChunkCoord(x), cz = TerrainChunkCoord(z);
+        std::shared_ptr<const TerrainChunkData> chunk = Acquire(cx, cz);
+        float lx = (x - cx * TERRAIN_CHUNK_SIZE) / TERRAIN_SPACING, lz = (z - cz * TERRAIN_CHUNK_SIZE) / TERRAIN_SPACING;
+        int i = std::min(std::max((int)std::floor(lx), 0), TERRAIN_CHUNK_RES - 1);
+        int j = std::min(std::max((int)std::floor(lz), 0), TERRAIN_CHUNK_RES - 1);
+        float fx = lx - i, fz = lz - j;
+        float h00 = chunk->At(i, j), h10 = chunk->At(i + 1, j), h01 = chunk->At(i, j + 1), h11 = chunk->At(i + 1, j + 1);
+        if (fx >= fz) return h00 + fx * (h10 - h00) + fz * (h11 - h10);
+        return h00 + fz * (h01 - h00) + fx * (h11 - h01);
+    }
+
+    // drop chunks more than `radius` chunks (Chebyshev) from (cx, cz)
+    void Evict(int cx, int cz, int radius) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (auto it = m_Chunks.begin(); it != m_Chunks.end();) {
+            const TerrainChunkData& c = *it->second;
+            if (std::abs(c.cx - cx) > radius || std::abs(c.cz - cz) > radius) it = m_Chunks.erase(it);
+            else ++it;
+        }
+    }
+
+    int GetResidentCount() const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return (int)m_Chunks.size();
+    }
+    const TerrainSource& GetSource() const { return m_Source; }
+
+private:
+    TerrainSource m_Source;
+    mutable std::mutex m_Mutex;
+    std::unordered_map<uint64_t, std::shared_ptr<const TerrainChunkData>> m_Chunks;
+};
+
+// Streams chunk meshes around a point and draws them. Every chunk has the same grid, so
+// the LOD index lists (every 2^lod-th row and column, plus skirts that hide the cracks
+// between neighbours at different levels) are built once and shared; a chunk is one
+// vertex buffer. Drawn with the model shader (position, normal, texcoord), unskinned.
+class TerrainRenderer {
+public:
+    static const int LOD_LEVELS = 5;            // 64, 32, 16, 8, 4 quads per side
+    static const int LOAD_RADIUS = 5;           // chunks around the centre kept resident
+    static const int UNLOAD_RADIUS = LOAD_RADIUS + 2; // hysteresis before dropping one
+    static const int UPLOADS_PER_FRAME = 2;
+    static constexpr float LOD_DISTANCE = 48.0f; // m: LOD 0 within this, each level doubles it
+    static constexpr float SKIRT_DEPTH = 4.0f;   // m
+    static constexpr float UV_PER_METRE = 0.25f;
+
+    struct Stats {
+        int resident = 0, pending = 0, drawn = 0, culled = 0;
+        int triangles = 0;
+        int perLod[LOD_LEVELS] = {};
+    };
+
+    explicit TerrainRenderer(TerrainHeights& heights) : m_Heights(heights), m_Pool(1) {
+        BuildIndices();
+    }
+
+    ~TerrainRenderer() {
+        m_Stopping = true;
+        for (auto& entry : m_Meshes) ReleaseMesh(entry.second);
+        glDeleteBuffers(1, &m_IndexBuffer);
+    }
+
+    TerrainRenderer(const TerrainRenderer&) = delete;
+    TerrainRenderer& operator=(const TerrainRenderer&) = delete;
+
+    // GL thread, once a frame: request chunks near `center`, upload finished ones, drop far ones
+    void Update(const glm::vec3& center) {
+        int ccx = TerrainChunkCoord(center.x), ccz = TerrainChunkCoord(center.z);
+
+        // nearest first, so the ground under the player is never waiting behind the horizon
+        m_Wanted.clear();
+        for (int dz = -LOAD_RADIUS; dz <= LOAD_RADIUS; dz++)
+            for (int dx = -LOAD_RADIUS; dx <= LOAD_RADIUS; dx++)
+                if (dx * dx + dz * dz <= LOAD_RADIUS * LOAD_RADIUS) m_Wanted.push_back({ dx * dx + dz * dz, ccx + dx, ccz + dz });
+        std::sort(m_Wanted.begin(), m_Wanted.end(), [](const Wanted& a, const Wanted& b) { return a.dist2 < b.dist2; });
+        for (const Wanted& w : m_Wanted) {
+            uint64_t key = TerrainChunkKey(w.cx, w.cz);
+            if (m_Meshes.count(key) || m_Pending.count(key)) continue;
+            m_Pending.insert(key);
+            int cx = w.cx, cz = w.cz;
+            m_Pool.Submit([this, cx, cz] { BuildMesh(cx, cz); });
+        }
+
+        // upload a few finished meshes (still wanted) per frame
+        std::vector<ReadyMesh> ready;
+        {
+            std::lock_guard<std::mutex> lock(m_ReadyMutex);
+            int take = std::min((int)m_Ready.size(), UPLOADS_PER_FRAME);
+            ready.assign(std::make_move_iterator(m_Ready.begin()), std::make_move_iterator(m_Ready.begin() + take));
+            m_Ready.erase(m_Ready.begin(), m_Ready.begin() + take);
+        }
+        for (ReadyMesh& r : ready) {
+            uint64_t key = TerrainChunkKey(r.cx, r.cz);
+            m_Pending.erase(key);
+            if (std::abs(r.cx - ccx) > UNLOAD_RADIUS || std::abs(r.cz - ccz) > UNLOAD_RADIUS) continue;
+            m_Meshes[key] = Upload(r);
+        }
+
+        for (auto it = m_Meshes.begin(); it != m_Meshes.end();) {
+            const ChunkMesh& m = it->second;
+            if (std::abs(m.cx - ccx) > UNLOAD_RADIUS || std::abs(m.cz - ccz) > UNLOAD_RADIUS) {
+                ReleaseMesh(it->second);
+                it = m_Meshes.erase(it);
+            }
+            else ++it;
+        }
+        m_Heights.Evict(ccx, ccz, UNLOAD_RADIUS);
+    }
+
+    // shader is the model shader, already in use with projection / view set
+    void Draw(Shader& shader, const Frustum& frustum, const glm::vec3& cameraPos) {
+        m_Stats = Stats();
+        m_Stats.resident = (int)m_Meshes.size();
+        m_Stats.pending = (int)m_Pending.size();
+        shader.setMat4("model", glm::mat4(1.0f));
+        shader.setInt("boneCount", 0); // not skinned
+        shader.setInt("instanceStride", 0);
+        for (auto& entry : m_Meshes) {
+            const ChunkMesh& m = entry.second;
+            if (!frustum.IntersectsAABB(m.boundsMin, m.boundsMax)) { m_Stats.culled++; continue; }
+            glm::vec3 nearest = glm::clamp(cameraPos, m.boundsMin, m.boundsMax);
+            float dist = glm::length(nearest - cameraPos);
+            int lod = 0;
+            while (lod + 1 < LOD_LEVELS && dist > LOD_DISTANCE * (float)(1 << lod)) lod++;
+            glBindVertexArray(m.vao);
+            glDrawElements(GL_TRIANGLES, m_LodCount[lod], GL_UNSIGNED_SHORT, (void*)(m_LodFirst[lod] * sizeof(uint16_t)));
+            m_Stats.drawn++;
+            m_Stats.perLod[lod]++;
+            m_Stats.triangles += m_LodCount[lod] / 3;
+        }
+        glBindVertexArray(0);
+    }
+
+    const Stats& GetStats() const { return m_Stats; }
+
+private:
+    struct Wanted { int dist2, cx, cz; };
+
+    struct ReadyMesh {
+        int cx, cz;
+        std::vector<float> vertices; // pos3 normal3 uv2
+        float minY, maxY;
+    };
+
+    struct ChunkMesh {
+        int cx = 0, cz = 0;
+        GLuint vao = 0, vbo = 0;
+        glm::vec3 boundsMin{ 0.0f }, boundsMax{ 0.0f };
+    };
+
+    static const int GRID_VERTICES = (TERRAIN_CHUNK_RES + 1) * (TERRAIN_CHUNK_RES + 1);
+    static const int FLOATS_PER_VERTEX = 8;
+
+    // vertex index of grid sample (i, j), and of the skirt vertex below border sample k of side s
+    static int GridIndex(int i, int j) { return j * (TERRAIN_CHUNK_RES + 1) + i; }
+    static int SkirtIndex(int side, int k) { return GRID_VERTICES + side * (TERRAIN_CHUNK_RES + 1) + k; }
+    // border sample k of side s (0: z = 0, 1: x = max, 2: z = max, 3: x = 0)
+    static void BorderSample(int side, int k, int& i, int& j) {
+        const int n = TERRAIN_CHUNK_RES;
+        switch (side) {
+        case 0: i = k; j = 0; break;
+        case 1: i = n; j = k; break;
+        case 2: i = k; j = n; break;
+        default: i = 0; j = k; break;
+        }
+    }
+
+    void BuildIndices() {
+        std::vector<uint16_t> indices;
+        for (int lod = 0; lod < LOD_LEVELS; lod++) {
+            const int step = 1 << lod;
+            m_LodFirst[lod] = (int)indices.size();
+            for (int j = 0; j < TERRAIN_CHUNK_RES; j += step)
+                for (int i = 0; i < TERRAIN_CHUNK_RES; i += step) {
+                    uint16_t v00 = (uint16_t)GridIndex(i, j), v10 = (uint16_t)GridIndex(i + step, j);
+                    uint16_t v01 = (uint16_t)GridIndex(i, j + step), v11 = (uint16_t)GridIndex(i + step, j + step);
+                    indices.insert(indices.end(), { v00, v01, v11, v00, v11, v10 });
+                }
+            for (int side = 0; side < 4; side++)
+                for (int k = 0; k < TERRAIN_CHUNK_RES; k += step) {
+                    int i0, j0, i1, j1;
+                    BorderSample(side, k, i0, j0);
+                    BorderSample(side, k + step, i1, j1);
+                    uint16_t a = (uint16_t)GridIndex(i0, j0), b = (uint16_t)GridIndex(i1, j1);
+                    uint16_t sa = (uint16_t)SkirtIndex(side, k), sb = (uint16_t)SkirtIndex(side, k + step);
+                    indices.insert(indices.end(), { a, sa, sb, a, sb, b });
+                }
+            m_LodCount[lod] = (int)indices.size() - m_LodFirst[lod];
+        }
+        glGenBuffers(1, &m_IndexBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    // worker: heights (disk or generated) -> interleaved vertices
+    void BuildMesh(int cx, int cz) {
+        ReadyMesh r;
+        r.cx = cx; r.cz = cz;
+        if (!m_Stopping) {
+            std::shared_ptr<const TerrainChunkData> chunk = m_Heights.Acquire(cx, cz);
+            const int n = TERRAIN_CHUNK_RES;
+            r.vertices.resize((GRID_VERTICES + 4 * (n + 1)) * FLOATS_PER_VERTEX);
+            r.minY = chunk->minY - SKIRT_DEPTH;
+            r.maxY = chunk->maxY;
+            auto write = [&](int v, int i, int j, float drop) {
+                float* out = &r.vertices[v * FLOATS_PER_VERTEX];
+                float x = cx * TERRAIN_CHUNK_SIZE + i * TERRAIN_SPACING, z = cz * TERRAIN_CHUNK_SIZE + j * TERRAIN_SPACING;
+                glm::vec3 normal = glm::normalize(glm::vec3(chunk->At(i - 1, j) - chunk->At(i + 1, j), 2.0f * TERRAIN_SPACING,
+                                                            chunk->At(i, j - 1) - chunk->At(i, j + 1)));
+                out[0] = x; out[1] = chunk->At(i, j) - drop; out[2] = z;
+                out[3] = normal.x; out[4] = normal.y; out[5] = normal.z;
+                out[6] = x * UV_PER_METRE; out[7] = z * UV_PER_METRE;
+            };
+            for (int j = 0; j <= n; j++)
+                for (int i = 0; i <= n; i++) write(GridIndex(i, j), i, j, 0.0f);
+            for (int side = 0; side < 4; side++)
+                for (int k = 0; k <= n; k++) {
+                    int i, j;
+                    BorderSample(side, k, i, j);
+                    write(SkirtIndex(side, k), i, j, SKIRT_DEPTH);
+                }
+        }
+        std::lock_guard<std::mutex> lock(m_ReadyMutex);
+        m_Ready.push_back(std::move(r));
+    }
+
+    ChunkMesh Upload(const ReadyMesh& r) {
+        ChunkMesh m;
+        m.cx = r.cx; m.cz = r.cz;
+        m.boundsMin = glm::vec3(r.cx * TERRAIN_CHUNK_SIZE, r.minY, r.cz * TERRAIN_CHUNK_SIZE);
+        m.boundsMax = glm::vec3((r.cx + 1) * TERRAIN_CHUNK_SIZE, r.maxY, (r.cz + 1) * TERRAIN_CHUNK_SIZE);
+        glGenVertexArrays(1, &m.vao);
+        glGenBuffers(1, &m.vbo);
+        glBindVertexArray(m.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, m.vbo);
+        glBufferData(GL_ARRAY_BUFFER, r.vertices.size() * sizeof(float), r.vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+        GLsizei stride = FLOATS_PER_VERTEX * sizeof(float);
+        glEnableVertexAttribArray(0); glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+        glEnableVertexAttribArray(1); glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(2); glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return m;
+    }
+
+    static void ReleaseMesh(ChunkMesh& m) {
+        if (m.vao) glDeleteVertexArrays(1, &m.vao);
+        if (m.vbo) glDeleteBuffers(1, &m.vbo);
+        m.vao = m.vbo = 0;
+    }
+
+    TerrainHeights& m_Heights;
+    GLuint m_IndexBuffer = 0;
+    int m_LodFirst[LOD_LEVELS] = {}, m_LodCount[LOD_LEVELS] = {};
+
+    std::unordered_map<uint64_t, ChunkMesh> m_Meshes;
+    std::unordered_set<uint64_t> m_Pending;
+    std::vector<Wanted> m_Wanted;
+    Stats m_Stats;
+
+    std::mutex m_ReadyMutex;
+    std::vector<ReadyMesh> m_Ready;
+    std::atomic<bool> m_Stopping{ false };
+    ThreadPool m_Pool; // last: the worker must stop before the members it uses go away
+};
+
+#endif
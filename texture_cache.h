@@ -0,0 +1,479 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include "asset_loader.h"
+#include "clip_cache.h"
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// Cooked texture file (<image>.tex): the whole mip chain, block-compressed, so loading is a
+// copy straight into glCompressedTexImage2D with no decode and no glGenerateMipmap.
+//
+//   TextureFileHeader
+//   TextureFileMip[mipCount]     level 0 = full size
+//   block data                   smallest level first, each level 4-byte aligned
+//
+// Smallest-first lets the streamer read a usable (blurry) texture off the front of the file
+// before the big levels. Formats, all 4x4 blocks:
+//   BC1  RGB, 8 bytes    colour images and normal maps (samplers keep reading xyz)
+//   BC3  RGBA, 16 bytes  images with alpha (BC4 alpha block + BC1 colour block)
+//   BC4  R, 8 bytes      single channel (core GL 3.0 as RGTC1)
+// Host byte order, like the clip cache.
+const char TEXTURE_FILE_MAGIC[4] = { 'K', 'T', 'E', 'X' };
+const uint32_t TEXTURE_FILE_VERSION = 1;
+
+enum TextureFileFormat : uint32_t {
+    TEXTURE_BC1 = 1,
+    TEXTURE_BC3 = 3,
+    TEXTURE_BC4 = 4,
+};
+
+struct TextureFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t fileSize;
+    uint32_t format; // TextureFileFormat
+    uint32_t width, height;
+    uint32_t mipCount;
+};
+
+struct TextureFileMip {
+    uint32_t width, height;
+    uint32_t offset, size; // bytes from the start of the file
+};
+
+inline uint32_t TextureBlockBytes(uint32_t format) { return format == TEXTURE_BC3 ? 16 : 8; }
+
+inline uint32_t TextureLevelBytes(uint32_t format, uint32_t width, uint32_t height) {
+    return ((width + 3) / 4) * ((height + 3) / 4) * TextureBlockBytes(format);
+}
+
+inline GLenum TextureGLFormat(uint32_t format) {
+    switch (format) {
+    case TEXTURE_BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case TEXTURE_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case TEXTURE_BC4: return GL_COMPRESSED_RED_RGTC1;
+    default: return 0;
+    }
+}
+
+// RGTC is core; S3TC is an extension every desktop driver (and Mesa) exposes
+inline bool TextureFormatSupported(uint32_t format) {
+    if (format == TEXTURE_BC4) return true;
+    if (format != TEXTURE_BC1 && format != TEXTURE_BC3) return false;
+    static int s3tc = -1;
+    if (s3tc < 0) {
+        s3tc = 0;
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count && !s3tc; i++) {
+            const char* name = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+            if (name && std::strcmp(name, "GL_EXT_texture_compression_s3tc") == 0) s3tc = 1;
+        }
+    }
+    return s3tc == 1;
+}
+
+// ---- block encoders (offline) ----
+
+inline uint16_t PackRgb565(const float c[3]) {
+    auto q = [](float v, int maxV) { return (uint16_t)std::lround(std::min(std::max(v, 0.0f), 255.0f) * maxV / 255.0f); };
+    return (uint16_t)((q(c[0], 31) << 11) | (q(c[1], 63) << 5) | q(c[2], 31));
+}
+
+inline void UnpackRgb565(uint16_t v, float out[3]) {
+    out[0] = ((v >> 11) & 31) * 255.0f / 31.0f;
+    out[1] = ((v >> 5) & 63) * 255.0f / 63.0f;
+    out[2] = (v & 31) * 255.0f / 31.0f;
+}
+
+// 16 RGBA8 pixels -> one BC1 block (4-colour mode). Endpoints are the extremes of the pixels
+// along their principal axis (a few power iterations on the covariance).
+inline void EncodeBC1Block(const uint8_t* rgba, uint8_t* out) {
+    float mean[3] = {};
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 3; c++) mean[c] += rgba[i * 4 + c] / 16.0f;
+    float cov[6] = {}; // rr rg rb gg gb bb
+    for (int i = 0; i < 16; i++) {
+        float d[3] = { rgba[i * 4] - mean[0], rgba[i * 4 + 1] - mean[1], rgba[i * 4 + 2] - mean[2] };
+        cov[0] += d[0] * d[0]; cov[1] += d[0] * d[1]; cov[2] += d[0] * d[2];
+        cov[3] += d[1] * d[1]; cov[4] += d[1] * d[2]; cov[5] += d[2] * d[2];
+    }
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int it = 0; it < 4; it++) {
+        float n[3] = { cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+                       cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+                       cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2] };
+        float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len < 1e-6f) break; // flat block: any axis will do
+        for (int c = 0; c < 3; c++) axis[c] = n[c] / len;
+    }
+    float lo = FLT_MAX, hi = -FLT_MAX;
+    for (int i = 0; i < 16; i++) {
+        float t = (rgba[i * 4] - mean[0]) * axis[0] + (rgba[i * 4 + 1] - mean[1]) * axis[1] + (rgba[i * 4 + 2] - mean[2]) * axis[2];
+        lo = std::min(lo, t);
+        hi = std::max(hi, t);
+    }
+    float e0[3], e1[3];
+    for (int c = 0; c < 3; c++) { e0[c] = mean[c] + axis[c] * hi; e1[c] = mean[c] + axis[c] * lo; }
+    uint16_t c0 = PackRgb565(e0), c1 = PackRgb565(e1);
+    if (c0 < c1) std::swap(c0, c1); // c0 > c1 selects 4-colour mode
+
+    float palette[4][3];
+    UnpackRgb565(c0, palette[0]);
+    UnpackRgb565(c1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+        palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+    }
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        for (int i = 0; i < 16; i++) {
+            int best = 0;
+            float bestDist = FLT_MAX;
+            for (int p = 0; p < 4; p++) {
+                float dr = rgba[i * 4] - palette[p][0], dg = rgba[i * 4 + 1] - palette[p][1], db = rgba[i * 4 + 2] - palette[p][2];
+                float dist = dr * dr + dg * dg + db * db;
+                if (dist < bestDist) { bestDist = dist; best = p; }
+            }
+            indices |= (uint32_t)best << (2 * i);
+        }
+    }
+    out[0] = (uint8_t)(c0 & 0xFF); out[1] = (uint8_t)(c0 >> 8);
+    out[2] = (uint8_t)(c1 & 0xFF); out[3] = (uint8_t)(c1 >> 8);
+    for (int b = 0; b < 4; b++) out[4 + b] = (uint8_t)(indices >> (8 * b));
+}
+
+// 16 values -> one BC4 block (8-value mode: endpoints are the min and max)
+inline void EncodeBC4Block(const uint8_t* values, uint8_t* out) {
+    uint8_t lo = 255, hi = 0;
+    for (int i = 0; i < 16; i++) { lo = std::min(lo, values[i]); hi = std::max(hi, values[i]); }
+    out[0] = hi;
+    out[1] = lo;
+    uint64_t indices = 0;
+    if (hi != lo) {
+        float palette[8] = { (float)hi, (float)lo };
+        for (int k = 1; k <= 6; k++) palette[k + 1] = ((7 - k) * hi + k * lo) / 7.0f;
+        for (int i = 0; i < 16; i++) {
+            int best = 0;
+            for (int p = 1; p < 8; p++)
+                if (std::fabs(values[i] - palette[p]) < std::fabs(values[i] - palette[best])) best = p;
+            indices |= (uint64_t)best << (3 * i);
+        }
+    }
+    for (int b = 0; b < 6; b++) out[2 + b] = (uint8_t)(indices >> (8 * b));
+}
+
+// One mip level, 8-bit pixels with `channels` channels, into `format` blocks. Edge blocks
+// repeat the last row / column.
+inline std::vector<uint8_t> CompressTextureLevel(uint32_t format, const uint8_t* pixels, int width, int height, int channels) {
+    std::vector<uint8_t> out(TextureLevelBytes(format, width, height));
+    uint8_t* dst = out.data();
+    uint8_t rgba[16 * 4], values[16];
+    for (int by = 0; by < height; by += 4) {
+        for (int bx = 0; bx < width; bx += 4) {
+            for (int i = 0; i < 16; i++) {
+                int x = std::min(bx + (i & 3), width - 1), y = std::min(by + (i >> 2), height - 1);
+                const uint8_t* p = pixels + ((size_t)y * width + x) * channels;
+                uint8_t* q = rgba + i * 4;
+                if (channels >= 3) { q[0] = p[0]; q[1] = p[1]; q[2] = p[2]; }
+                else q[0] = q[1] = q[2] = p[0];
+                q[3] = (channels == 4) ? p[3] : (channels == 2) ? p[1] : 255;
+                values[i] = (format == TEXTURE_BC4) ? q[0] : q[3];
+            }
+            if (format == TEXTURE_BC4) { EncodeBC4Block(values, dst); dst += 8; continue; }
+            if (format == TEXTURE_BC3) { EncodeBC4Block(values, dst); dst += 8; }
+            EncodeBC1Block(rgba, dst);
+            dst += 8;
+        }
+    }
+    return out;
+}
+
+// 2x2 box filter; normal maps are renormalized so the mips stay unit length
+inline std::vector<uint8_t> DownsampleTextureLevel(const std::vector<uint8_t>& src, int width, int height, int channels,
+                                                   bool normalMap, int& outWidth, int& outHeight) {
+    outWidth = std::max(1, width / 2);
+    outHeight = std::max(1, height / 2);
+    std::vector<uint8_t> dst((size_t)outWidth * outHeight * channels);
+    for (int y = 0; y < outHeight; y++) {
+        for (int x = 0; x < outWidth; x++) {
+            int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+            int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+            float sum[4] = {};
+            for (int c = 0; c < channels; c++)
+                sum[c] = (src[((size_t)y0 * width + x0) * channels + c] + src[((size_t)y0 * width + x1) * channels + c] +
+                          src[((size_t)y1 * width + x0) * channels + c] + src[((size_t)y1 * width + x1) * channels + c]) / 4.0f;
+            if (normalMap && channels >= 3) {
+                float n[3] = { sum[0] / 127.5f - 1.0f, sum[1] / 127.5f - 1.0f, sum[2] / 127.5f - 1.0f };
+                float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                if (len > 1e-6f)
+                    for (int c = 0; c < 3; c++) sum[c] = (n[c] / len + 1.0f) * 127.5f;
+            }
+            for (int c = 0; c < channels; c++)
+                dst[((size_t)y * outWidth + x) * channels + c] = (uint8_t)std::lround(std::min(std::max(sum[c], 0.0f), 255.0f));
+        }
+    }
+    return dst;
+}
+
+// Cook images to .tex files; read their headers back.
+class TextureCache {
+public:
+    struct CookStats {
+        int width = 0, height = 0, mips = 0;
+        uint32_t format = 0;
+        uint64_t uncompressedBytes = 0; // what the stb_image path uploads: 8-bit pixels + generated mips
+        uint64_t cookedBytes = 0;
+        double decodeMs = 0.0;          // stbi_load of the source
+    };
+
+    static std::string CachePathFor(const std::string& sourcePath) { return sourcePath + ".tex"; }
+
+    // Offline step: decode, build the mip chain, compress each level and write the .tex next to
+    // the image. Decodes with the current stbi flip setting; cook with the one the game uses.
+    static bool Cook(const std::string& sourcePath, CookStats* stats = nullptr) {
+        auto begin = std::chrono::steady_clock::now();
+        DecodedImage img = DecodeImage(sourcePath);
+        double decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        if (!img.data) {
+            std::cout << "ERROR::TEXTURE_CACHE: can't decode " << sourcePath << "\n";
+            return false;
+        }
+        const int channels = img.channels;
+        std::vector<uint8_t> level(img.data.get(), img.data.get() + (size_t)img.width * img.height * channels);
+
+        uint32_t format = TEXTURE_BC1;
+        if (channels == 1) format = TEXTURE_BC4;
+        else if (channels == 2 || channels == 4) {
+            for (size_t i = channels - 1; i < level.size(); i += channels)
+                if (level[i] != 255) { format = TEXTURE_BC3; break; }
+        }
+        std::string file = sourcePath.substr(sourcePath.find_last_of("/\\") + 1);
+        bool normalMap = file.find("normal") != std::string::npos || file.find("Normal") != std::string::npos;
+
+        std::vector<TextureFileMip> mips;
+        std::vector<std::vector<uint8_t>> blocks;
+        int width = img.width, height = img.height;
+        uint64_t uncompressed = 0;
+        for (;;) {
+            blocks.push_back(CompressTextureLevel(format, level.data(), width, height, channels));
+            mips.push_back({ (uint32_t)width, (uint32_t)height, 0, (uint32_t)blocks.back().size() });
+            uncompressed += (uint64_t)width * height * channels;
+            if (width == 1 && height == 1) break;
+            level = DownsampleTextureLevel(level, width, height, channels, normalMap, width, height);
+        }
+
+        TextureFileHeader header;
+        std::memcpy(header.magic, TEXTURE_FILE_MAGIC, sizeof(header.magic));
+        header.version = TEXTURE_FILE_VERSION;
+        header.format = format;
+        header.width = (uint32_t)img.width;
+        header.height = (uint32_t)img.height;
+        header.mipCount = (uint32_t)mips.size();
+        uint32_t offset = (uint32_t)(sizeof(TextureFileHeader) + mips.size() * sizeof(TextureFileMip));
+        for (int m = (int)mips.size() - 1; m >= 0; m--) {
+            mips[m].offset = offset;
+            offset += (uint32_t)ClipFileAligned(mips[m].size);
+        }
+        header.fileSize = offset;
+
+        std::string cachePath = CachePathFor(sourcePath);
+        std::ofstream out(cachePath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cout << "ERROR::TEXTURE_CACHE: can't write " << cachePath << "\n";
+            return false;
+        }
+        const char pad[4] = {};
+        out.write((const char*)&header, sizeof(header));
+        out.write((const char*)mips.data(), mips.size() * sizeof(TextureFileMip));
+        for (int m = (int)mips.size() - 1; m >= 0; m--) {
+            out.write((const char*)blocks[m].data(), blocks[m].size());
+            out.write(pad, ClipFileAligned(mips[m].size) - mips[m].size);
+        }
+        if (!out) return false;
+
+        if (stats) {
+            stats->width = img.width;
+            stats->height = img.height;
+            stats->mips = (int)mips.size();
+            stats->format = format;
+            stats->uncompressedBytes = uncompressed;
+            stats->cookedBytes = header.fileSize;
+            stats->decodeMs = decodeMs;
+        }
+        return true;
+    }
+
+    // header and mip table of a fresh, well-formed .tex
+    static bool ReadHeader(const std::string& sourcePath, TextureFileHeader& header, std::vector<TextureFileMip>& mips) {
+        std::string cachePath = CachePathFor(sourcePath);
+        if (!ClipCache::IsFresh(sourcePath, cachePath)) return false;
+        std::ifstream in(cachePath, std::ios::binary);
+        if (!in.read((char*)&header, sizeof(header))) return false;
+        if (std::memcmp(header.magic, TEXTURE_FILE_MAGIC, 4) != 0 || header.version != TEXTURE_FILE_VERSION ||
+            TextureGLFormat(header.format) == 0 || header.mipCount == 0 || header.mipCount > 32) return false;
+        mips.resize(header.mipCount);
+        if (!in.read((char*)mips.data(), mips.size() * sizeof(TextureFileMip))) return false;
+        for (const TextureFileMip& mip : mips)
+            if ((uint64_t)mip.offset + mip.size > header.fileSize ||
+                mip.size != TextureLevelBytes(header.format, mip.width, mip.height)) return false;
+        return true;
+    }
+};
+
+// Streams cooked textures in, smallest levels first. Request hands the file to a worker, which
+// reads the mip tail (every level up to TAIL_SIZE) and then each larger level, one at a time;
+// Update uploads what has arrived, within a byte budget per call, and lowers the texture's
+// GL_TEXTURE_BASE_LEVEL as each level lands. So a texture is usable (blurry) within a frame
+// or two of its request and sharpens over the next few, while startup never waits on the big
+// levels and nothing is ever decoded.
+class TextureStreamer {
+public:
+    static const int TAIL_SIZE = 64; // levels no larger than this come in the first chunk
+
+    explicit TextureStreamer(int uploadBytesPerUpdate = 4 << 20)
+        : m_Budget(uploadBytesPerUpdate), m_Pool(1) {}
+
+    ~TextureStreamer() { m_Stopping = true; } // queued reads are skipped, the pool drains
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // Stream `sourcePath`'s cooked file. onCreated(tex) runs on the GL thread at the first
+    // upload (the texture is complete from then on). Returns false, and does nothing, if there
+    // is no fresh .tex or the GL can't sample its format: load the source instead.
+    bool Request(const std::string& sourcePath, std::function<void(unsigned int)> onCreated) {
+        auto tex = std::make_shared<Streamed>();
+        if (!TextureCache::ReadHeader(sourcePath, tex->header, tex->mips)) return false;
+        if (!TextureFormatSupported(tex->header.format)) return false;
+        tex->path = TextureCache::CachePathFor(sourcePath);
+        tex->onCreated = std::move(onCreated);
+        m_InFlight++;
+        m_Pool.Submit([this, tex] { Read(tex); });
+        return true;
+    }
+
+    // GL thread: upload arrived levels, at least one chunk and then up to the byte budget.
+    // Returns the number of levels uploaded.
+    int Update() {
+        int levels = 0;
+        int bytes = 0;
+        for (;;) {
+            Chunk chunk;
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                if (m_Ready.empty() || (levels > 0 && bytes + (int)m_Ready.front().data.size() > m_Budget)) break;
+                chunk = std::move(m_Ready.front());
+                m_Ready.erase(m_Ready.begin());
+            }
+            Streamed& tex = *chunk.tex;
+            bool created = (tex.id == 0);
+            if (created) {
+                glGenTextures(1, &tex.id);
+                glBindTexture(GL_TEXTURE_2D, tex.id);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)tex.mips.size() - 1);
+            }
+            else glBindTexture(GL_TEXTURE_2D, tex.id);
+
+            const GLenum format = TextureGLFormat(tex.header.format);
+            size_t offset = 0;
+            for (int level = chunk.last; level >= chunk.first; level--) {
+                const TextureFileMip& mip = tex.mips[level];
+                glCompressedTexImage2D(GL_TEXTURE_2D, level, format, (GLsizei)mip.width, (GLsizei)mip.height, 0,
+                                       (GLsizei)mip.size, chunk.data.data() + offset);
+                offset += mip.size;
+                levels++;
+            }
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, chunk.first);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            bytes += (int)chunk.data.size();
+            m_ResidentBytes += chunk.data.size();
+            if (created && tex.onCreated) tex.onCreated(tex.id);
+            if (chunk.first == 0) m_InFlight--;
+        }
+        return levels;
+    }
+
+    // every requested texture fully uploaded
+    bool IsIdle() const { return m_InFlight == 0; }
+    int GetInFlightCount() const { return m_InFlight; }
+    // compressed bytes uploaded so far
+    uint64_t GetResidentBytes() const { return m_ResidentBytes; }
+
+private:
+    struct Streamed {
+        std::string path;
+        TextureFileHeader header;
+        std::vector<TextureFileMip> mips;
+        std::function<void(unsigned int)> onCreated;
+        GLuint id = 0; // GL thread only
+    };
+
+    struct Chunk {
+        std::shared_ptr<Streamed> tex;
+        int first = 0, last = 0; // levels, data holds last..first (smallest first)
+        std::vector<uint8_t> data;
+    };
+
+    // worker: the tail, then each larger level, in file order
+    void Read(std::shared_ptr<Streamed> tex) {
+        MappedFile file(tex->path);
+        if (!file.IsOpen() || file.Size() < tex->header.fileSize) {
+            std::cout << "ERROR::TEXTURE_STREAMER: can't read " << tex->path << "\n";
+            m_InFlight--;
+            return;
+        }
+        int level = (int)tex->mips.size() - 1;
+        while (level >= 0 && !m_Stopping) {
+            Chunk chunk;
+            chunk.tex = tex;
+            chunk.last = level;
+            do {
+                const TextureFileMip& mip = tex->mips[level];
+                chunk.data.insert(chunk.data.end(), file.Data() + mip.offset, file.Data() + mip.offset + mip.size);
+                level--;
+            } while (level >= 0 && (int)std::max(tex->mips[level].width, tex->mips[level].height) <= TAIL_SIZE);
+            chunk.first = level + 1;
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Ready.push_back(std::move(chunk));
+        }
+    }
+
+    int m_Budget;
+    std::atomic<bool> m_Stopping{ false };
+    std::atomic<int> m_InFlight{ 0 };
+    uint64_t m_ResidentBytes = 0;
+    std::mutex m_Mutex;
+    std::vector<Chunk> m_Ready;
+    ThreadPool m_Pool; // last: the worker must stop before the members it uses go away
+};
+
+#endif